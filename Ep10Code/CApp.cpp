@@ -30,6 +30,11 @@ CApp::CApp()
 	isRunning = true;
 	pWindow = NULL;
 	pRenderer = NULL;
+	m_progressive = false;
+	m_maxPasses = 64;
+	m_timeBudget = 0.0;
+	m_targetError = 0.0;
+	m_resume = false;
 }
 
 bool CApp::OnInit()
@@ -55,8 +60,19 @@ bool CApp::OnInit()
 		SDL_SetRenderDrawColor(pRenderer, 255, 255, 255, 255);
 		SDL_RenderClear(pRenderer);
 		
-		// Render the scene.
-		m_scene.Render(m_image);
+		// Setup checkpointing and continue from an earlier checkpoint if required.
+		m_scene.m_checkpointFile = m_checkpointFile;
+		if (m_resume && !m_checkpointFile.empty())
+			m_scene.LoadCheckpoint(m_checkpointFile, xSize, ySize);
+		
+		// Render the scene, unless we are rendering progressively in OnLoop.
+		if (!m_progressive)
+		{
+			if ((m_timeBudget > 0.0) || (m_targetError > 0.0))
+				m_scene.RenderToTarget(m_image, m_timeBudget, m_targetError);
+			else
+				m_scene.Render(m_image);
+		}
 		
 		// Setup a texture.
 		/*qbRT::Texture::Image testTexture;
@@ -132,7 +148,13 @@ void CApp::OnEvent(SDL_Event *event)
 
 void CApp::OnLoop()
 {
-
+	// Add another pass to the progressive render and show the current estimate.
+	if (m_progressive && (m_scene.GetPassCount() < m_maxPasses))
+	{
+		m_scene.RenderPass(m_image);
+		m_image.Display();
+		SDL_RenderPresent(pRenderer);
+	}
 }
 
 void CApp::OnRender()
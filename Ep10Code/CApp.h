@@ -54,6 +54,21 @@ class CApp
 		// An instance of the scene class.
 		qbRT::Scene m_scene;
 		
+		/* Flag to select progressive rendering, where the image is refined
+			one pass at a time and displayed after every pass. */
+		bool m_progressive;
+		int m_maxPasses;
+		
+		/* A time budget (in seconds) and / or target relative error for the render.
+			If either is non-zero, the scene is rendered with RenderToTarget. */
+		double m_timeBudget;
+		double m_targetError;
+		
+		/* The file to write checkpoints of progressive renders to and a flag
+			to continue from the checkpoint in that file, if there is one. */
+		std::string m_checkpointFile;
+		bool m_resume;
+		
 		// SDL2 stuff.
 		bool isRunning;
 		SDL_Window *pWindow;
@@ -0,0 +1,209 @@
+/* ***********************************************************
+	accumbuffer.cpp
+	
+	The AccumBuffer class implementation - A class to accumulate
+	samples for each pixel over many passes, keeping a running
+	estimate of the mean and variance.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+// accumbuffer.cpp
+
+#include "accumbuffer.hpp"
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+
+// Weights used to convert a color to luminance.
+static const double lumWeights[3] = {0.2126, 0.7152, 0.0722};
+
+// The default constructor.
+qbRT::AccumBuffer::AccumBuffer()
+{
+	m_xSize = 0;
+	m_ySize = 0;
+}
+
+// Function to initialize the buffer to the given size.
+void qbRT::AccumBuffer::Initialize(const int xSize, const int ySize)
+{
+	m_xSize = xSize;
+	m_ySize = ySize;
+	Reset();
+}
+
+// Function to discard all of the accumulated samples.
+void qbRT::AccumBuffer::Reset()
+{
+	int numPixels = m_xSize * m_ySize;
+	m_mean.assign(numPixels * 3, 0.0);
+	m_m2.assign(numPixels * 3, 0.0);
+	m_m2Lum.assign(numPixels, 0.0);
+	m_count.assign(numPixels, 0);
+}
+
+// Function to add a sample to a pixel.
+void qbRT::AccumBuffer::AddSample(const int x, const int y, const qbVector<double> &color)
+{
+	int index = (y * m_xSize) + x;
+	int n = ++m_count.at(index);
+	
+	// Update the luminance first, as it needs the mean from before this sample.
+	double lum = 0.0;
+	double oldLum = 0.0;
+	for (int c=0; c<3; ++c)
+	{
+		lum += lumWeights[c] * color.GetElement(c);
+		oldLum += lumWeights[c] * m_mean.at((index * 3) + c);
+	}
+	double lumDelta = lum - oldLum;
+	double newLum = oldLum + (lumDelta / n);
+	m_m2Lum.at(index) += lumDelta * (lum - newLum);
+	
+	// And then each of the color channels.
+	for (int c=0; c<3; ++c)
+	{
+		double value = color.GetElement(c);
+		double &mean = m_mean.at((index * 3) + c);
+		double delta = value - mean;
+		mean += delta / n;
+		m_m2.at((index * 3) + c) += delta * (value - mean);
+	}
+}
+
+// Function to return the current estimate of the color of a pixel.
+qbVector<double> qbRT::AccumBuffer::GetMean(const int x, const int y) const
+{
+	int index = (y * m_xSize) + x;
+	return qbVector<double>{std::vector<double>{	m_mean.at(index * 3),
+																								m_mean.at((index * 3) + 1),
+																								m_mean.at((index * 3) + 2)}};
+}
+
+// Function to return the sample variance of each color channel of a pixel.
+qbVector<double> qbRT::AccumBuffer::GetVariance(const int x, const int y) const
+{
+	int index = (y * m_xSize) + x;
+	qbVector<double> variance {3};
+	int n = m_count.at(index);
+	if (n > 1)
+	{
+		for (int c=0; c<3; ++c)
+			variance.SetElement(c, m_m2.at((index * 3) + c) / (n - 1));
+	}
+	return variance;
+}
+
+// Function to return the mean luminance of a pixel.
+double qbRT::AccumBuffer::GetLuminance(const int x, const int y) const
+{
+	int index = (y * m_xSize) + x;
+	double lum = 0.0;
+	for (int c=0; c<3; ++c)
+		lum += lumWeights[c] * m_mean.at((index * 3) + c);
+	return lum;
+}
+
+// Function to return the relative standard error of the mean luminance.
+double qbRT::AccumBuffer::GetRelativeError(const int x, const int y) const
+{
+	int index = (y * m_xSize) + x;
+	int n = m_count.at(index);
+	if (n < 2)
+		return 0.0;
+		
+	double stdError = sqrt((m_m2Lum.at(index) / (n - 1)) / n);
+	return stdError / std::max(GetLuminance(x, y), 1e-3);
+}
+
+// Function to return the number of samples taken for a pixel.
+int qbRT::AccumBuffer::GetSampleCount(const int x, const int y) const
+{
+	return m_count.at((y * m_xSize) + x);
+}
+
+// Function to copy the current estimate into an image.
+void qbRT::AccumBuffer::WriteToImage(qbImage &outputImage) const
+{
+	for (int y=0; y<m_ySize; ++y)
+	{
+		for (int x=0; x<m_xSize; ++x)
+		{
+			int index = ((y * m_xSize) + x) * 3;
+			outputImage.SetPixel(x, y, m_mean.at(index), m_mean.at(index + 1), m_mean.at(index + 2));
+		}
+	}
+}
+
+// Function to write the buffer to a binary stream.
+bool qbRT::AccumBuffer::Write(std::ostream &outputStream) const
+{
+	int32_t dims[2] = {m_xSize, m_ySize};
+	outputStream.write(reinterpret_cast<const char *>(dims), sizeof(dims));
+	outputStream.write(reinterpret_cast<const char *>(m_mean.data()), m_mean.size() * sizeof(double));
+	outputStream.write(reinterpret_cast<const char *>(m_m2.data()), m_m2.size() * sizeof(double));
+	outputStream.write(reinterpret_cast<const char *>(m_m2Lum.data()), m_m2Lum.size() * sizeof(double));
+	
+	std::vector<int32_t> counts (m_count.begin(), m_count.end());
+	outputStream.write(reinterpret_cast<const char *>(counts.data()), counts.size() * sizeof(int32_t));
+	
+	return outputStream.good();
+}
+
+// Function to read the buffer back from a binary stream.
+bool qbRT::AccumBuffer::Read(std::istream &inputStream, int xSize, int ySize)
+{
+	int32_t dims[2];
+	inputStream.read(reinterpret_cast<char *>(dims), sizeof(dims));
+	if (!inputStream.good() || (dims[0] != xSize) || (dims[1] != ySize))
+		return false;
+	
+	Initialize(dims[0], dims[1]);
+	inputStream.read(reinterpret_cast<char *>(m_mean.data()), m_mean.size() * sizeof(double));
+	inputStream.read(reinterpret_cast<char *>(m_m2.data()), m_m2.size() * sizeof(double));
+	inputStream.read(reinterpret_cast<char *>(m_m2Lum.data()), m_m2Lum.size() * sizeof(double));
+	
+	std::vector<int32_t> counts (m_count.size());
+	inputStream.read(reinterpret_cast<char *>(counts.data()), counts.size() * sizeof(int32_t));
+	if (!inputStream.good())
+		return false;
+		
+	// Check that every pixel holds a sample count and statistics that a render could have produced.
+	for (std::size_t i=0; i<counts.size(); ++i)
+	{
+		if (counts[i] < 0)
+			return false;
+		if (!std::isfinite(m_m2Lum[i]) || (m_m2Lum[i] < 0.0))
+			return false;
+		for (std::size_t c=i*3; c<(i*3)+3; ++c)
+		{
+			if (!std::isfinite(m_mean[c]) || !std::isfinite(m_m2[c]) || (m_m2[c] < 0.0))
+				return false;
+		}
+	}
+	m_count.assign(counts.begin(), counts.end());
+	
+	return true;
+}
+
+// Functions to return the dimensions of the buffer.
+int qbRT::AccumBuffer::GetXSize() const
+{
+	return m_xSize;
+}
+
+int qbRT::AccumBuffer::GetYSize() const
+{
+	return m_ySize;
+}
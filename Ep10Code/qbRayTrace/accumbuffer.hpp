@@ -0,0 +1,94 @@
+/* ***********************************************************
+	accumbuffer.hpp
+	
+	The AccumBuffer class definition - A class to accumulate
+	samples for each pixel over many passes, keeping a running
+	estimate of the mean and variance.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+// accumbuffer.hpp
+
+#ifndef ACCUMBUFFER_H
+#define ACCUMBUFFER_H
+
+#include <vector>
+#include <iostream>
+#include "qbImage.hpp"
+#include "./qbLinAlg/qbVector.h"
+
+namespace qbRT
+{
+	class AccumBuffer
+	{
+		public:
+			// The default constructor.
+			AccumBuffer();
+			
+			// Function to initialize the buffer to the given size.
+			void Initialize(const int xSize, const int ySize);
+			
+			// Function to discard all of the accumulated samples.
+			void Reset();
+			
+			// Function to add a sample to a pixel.
+			void AddSample(const int x, const int y, const qbVector<double> &color);
+			
+			// Function to return the current estimate of the color of a pixel.
+			qbVector<double> GetMean(const int x, const int y) const;
+			
+			// Function to return the sample variance of each color channel of a pixel.
+			qbVector<double> GetVariance(const int x, const int y) const;
+			
+			// Function to return the mean luminance of a pixel.
+			double GetLuminance(const int x, const int y) const;
+			
+			/* Function to return the standard error of the mean luminance, relative
+				to the mean luminance itself. Returns zero for fewer than two samples. */
+			double GetRelativeError(const int x, const int y) const;
+			
+			// Function to return the number of samples taken for a pixel.
+			int GetSampleCount(const int x, const int y) const;
+			
+			// Function to copy the current estimate into an image.
+			void WriteToImage(qbImage &outputImage) const;
+			
+			/* Functions to write the buffer to, and read it back from, a binary stream.
+				Reading fails if the stored buffer is not of the expected size, or if any
+				pixel has a negative sample count or variance, or a value that is not finite. */
+			bool Write(std::ostream &outputStream) const;
+			bool Read(std::istream &inputStream, int xSize, int ySize);
+			
+			// Functions to return the dimensions of the buffer.
+			int GetXSize() const;
+			int GetYSize() const;
+			
+		private:
+			// Store the dimensions of the buffer.
+			int m_xSize, m_ySize;
+			
+			/* The running mean and sum of squared differences (Welford's method)
+				for each color channel, stored as three values per pixel. */
+			std::vector<double> m_mean;
+			std::vector<double> m_m2;
+			
+			// The sum of squared differences of the luminance of each pixel.
+			std::vector<double> m_m2Lum;
+			
+			// The number of samples taken for each pixel.
+			std::vector<int> m_count;
+	};
+}
+
+#endif
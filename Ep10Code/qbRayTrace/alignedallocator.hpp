@@ -0,0 +1,73 @@
+/* ***********************************************************
+	alignedallocator.hpp
+	
+	The AlignedAllocator class definition - A minimal allocator
+	for std::vector that aligns its storage to a given boundary
+	(by default, a 64 byte cache line).
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef ALIGNEDALLOCATOR_H
+#define ALIGNEDALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+
+namespace qbRT
+{
+	template <class T, std::size_t Alignment = 64>
+	class AlignedAllocator
+	{
+		public:
+			using value_type = T;
+			
+			template <class U>
+			struct rebind
+			{
+				using other = AlignedAllocator<U, Alignment>;
+			};
+			
+		public:
+			AlignedAllocator() noexcept {}
+			
+			template <class U>
+			AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+			
+			// Function to allocate storage for n objects.
+			T *allocate(std::size_t n)
+			{
+				return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+			}
+			
+			// Function to release storage.
+			void deallocate(T *p, std::size_t) noexcept
+			{
+				::operator delete(p, std::align_val_t(Alignment));
+			}
+	};
+	
+	template <class T, class U, std::size_t Alignment>
+	bool operator== (const AlignedAllocator<T, Alignment> &, const AlignedAllocator<U, Alignment> &)
+	{
+		return true;
+	}
+	
+	template <class T, class U, std::size_t Alignment>
+	bool operator!= (const AlignedAllocator<T, Alignment> &, const AlignedAllocator<U, Alignment> &)
+	{
+		return false;
+	}
+}
+
+#endif
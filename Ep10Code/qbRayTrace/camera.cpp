@@ -157,6 +157,22 @@ bool qbRT::Camera::GenerateRay(float proScreenX, float proScreenY, qbRT::Ray &ca
 	return true;
 }
 
+// Function to generate a ray with differentials.
+bool qbRT::Camera::GenerateRay(float proScreenX, float proScreenY, float proScreenDX, float proScreenDY, qbRT::Ray &cameraRay)
+{
+	// Generate the central ray.
+	GenerateRay(proScreenX, proScreenY, cameraRay);
+	
+	// And the rays through the neighbouring pixels in x and y.
+	qbRT::Ray rayX;
+	qbRT::Ray rayY;
+	GenerateRay(proScreenX + proScreenDX, proScreenY, rayX);
+	GenerateRay(proScreenX, proScreenY + proScreenDY, rayY);
+	cameraRay.SetDifferentials(rayX, rayY);
+	
+	return true;
+}
+
 
 
 
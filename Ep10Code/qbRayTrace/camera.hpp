@@ -59,6 +59,10 @@ namespace qbRT
 			// Function to generate a ray.
 			bool GenerateRay(float proScreenX, float proScreenY, qbRT::Ray &cameraRay);
 			
+			/* Function to generate a ray with differentials, given the spacing
+				between neighbouring pixels on the projection screen. */
+			bool GenerateRay(float proScreenX, float proScreenY, float proScreenDX, float proScreenDY, qbRT::Ray &cameraRay);
+			
 			// Function to update the camera geometry.
 			void UpdateCameraGeometry();
 			
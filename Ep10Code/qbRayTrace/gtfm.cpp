@@ -147,6 +147,21 @@ qbRT::Ray qbRT::GTform::Apply(const qbRT::Ray &inputRay, bool dirFlag)
 		outputRay.m_lab = outputRay.m_point2 - outputRay.m_point1;
 	}
 	
+	// Carry any ray differentials through the same transform.
+	if (inputRay.HasDifferentials())
+	{
+		for (int i=0; i<2; ++i)
+		{
+			qbRT::Ray auxRay = this -> Apply(inputRay.GetDifferential(i), dirFlag);
+			for (int j=0; j<3; ++j)
+			{
+				outputRay.m_differentialOrigin[i][j] = auxRay.m_point1.GetElement(j);
+				outputRay.m_differentialDirection[i][j] = auxRay.m_lab.GetElement(j);
+			}
+		}
+		outputRay.m_hasDifferentials = true;
+	}
+	
 	return outputRay;
 }
 
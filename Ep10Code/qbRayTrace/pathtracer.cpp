@@ -0,0 +1,277 @@
+/* ***********************************************************
+	pathtracer.cpp
+	
+	The PathTracer class implementation - A Monte Carlo integrator
+	that follows each camera ray through the scene as a random path,
+	with next-event estimation at every bounce and multiple
+	importance sampling of the environment.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "pathtracer.hpp"
+#include <algorithm>
+#include <cmath>
+#include "random.hpp"
+#include "./qbMaterials/materialbase.hpp"
+#include "./qbLights/arealight.hpp"
+
+// Constructor / destructor.
+qbRT::PathTracer::PathTracer()
+{
+
+}
+
+qbRT::PathTracer::~PathTracer()
+{
+
+}
+
+// Function to compute the light arriving along a camera ray.
+bool qbRT::PathTracer::ComputeColor(	const qbRT::Ray &cameraRay, bool intersectionFound,
+																			const std::shared_ptr<qbRT::ObjectBase> &firstObject,
+																			const qbVector<double> &firstIntPoint, const qbVector<double> &firstLocalNormal,
+																			const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+																			const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
+																			qbVector<double> &color)
+{
+	const std::shared_ptr<qbRT::EnvironmentLight> &environmentLight = qbRT::MaterialBase::m_environmentLight;
+	bool hasEnvironment = environmentLight && environmentLight->IsValid();
+	
+	double radiance[3] = {0.0, 0.0, 0.0};
+	double throughput[3] = {1.0, 1.0, 1.0};
+	
+	// The camera sees the first hit, which has already been found.
+	bool validInt = intersectionFound;
+	std::shared_ptr<qbRT::ObjectBase> hitObject = firstObject;
+	qbVector<double> intPoint = firstIntPoint;
+	qbVector<double> localNormal = firstLocalNormal;
+	qbRT::Ray ray = cameraRay;
+	
+	/* The density with which the last bounce chose the ray, to weight the environment
+		seen along it. The camera ray, like a specular bounce, could not have been found
+		by sampling the lights, so takes the full weight. */
+	double lastPdf = 0.0;
+	bool lastSpecular = true;
+	
+	for (int depth=0; ; ++depth)
+	{
+		qbVector<double> direction = ray.m_lab;
+		direction.Normalize();
+		if (depth > 0)
+			validInt = FindClosest(ray, objectList, hitObject, intPoint, localNormal);
+			
+		// A path that leaves the scene sees the environment, if there is one.
+		if (!validInt)
+		{
+			if (hasEnvironment)
+			{
+				double envColor[3];
+				environmentLight->GetRadiance(direction, envColor);
+				double weight = lastSpecular ? 1.0 : PowerHeuristic(lastPdf, environmentLight->GetPDF(direction));
+				for (int c=0; c<3; ++c)
+					radiance[c] += throughput[c] * envColor[c] * weight;
+			}
+			break;
+		}
+		
+		qbRT::BSDF bsdf;
+		GetBSDF(hitObject, intPoint, localNormal, ray, bsdf);
+		qbVector<double> wo = direction * -1.0;
+		
+		// Add the direct light, unless the surface only scatters along single directions.
+		if (bsdf.HasSmoothLobes())
+		{
+			double direct[3];
+			SampleLights(bsdf, intPoint, wo, objectList, lightList, direct);
+			for (int c=0; c<3; ++c)
+				radiance[c] += throughput[c] * direct[c];
+		}
+		
+		if (depth >= m_maxDepth)
+			break;
+			
+		// Choose the next direction from the BSDF.
+		double uLobe = qbRT::Random::Uniform();
+		double u1, u2;
+		qbRT::Random::Uniform2D(u1, u2);
+		qbVector<double> wi {3};
+		double weight[3];
+		if (!bsdf.Sample(wo, uLobe, u1, u2, wi, weight, lastPdf, lastSpecular))
+			break;
+			
+		for (int c=0; c<3; ++c)
+			throughput[c] *= weight[c];
+			
+		// End paths that carry little light at random, scaling up those that survive to compensate.
+		if ((depth + 1) >= m_rouletteDepth)
+		{
+			double survival = std::min(1.0, std::max({throughput[0], throughput[1], throughput[2]}));
+			if (qbRT::Random::Uniform() >= survival)
+				break;
+				
+			for (int c=0; c<3; ++c)
+				throughput[c] /= survival;
+		}
+		
+		qbVector<double> startPoint = intPoint + (wi * 0.001);
+		ray = qbRT::Ray (startPoint, startPoint + wi);
+	}
+	
+	color = qbVector<double> {std::vector<double> {radiance[0], radiance[1], radiance[2]}};
+	return intersectionFound || hasEnvironment;
+}
+
+// Function to find the closest object along a ray.
+bool qbRT::PathTracer::FindClosest(	const qbRT::Ray &ray, const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+																		std::shared_ptr<qbRT::ObjectBase> &closestObject,
+																		qbVector<double> &closestIntPoint, qbVector<double> &closestLocalNormal)
+{
+	qbVector<double> intPoint			{3};
+	qbVector<double> localNormal	{3};
+	qbVector<double> localColor		{3};
+	double minDist = 1e6;
+	bool intersectionFound = false;
+	for (auto &currentObject : objectList)
+	{
+		if (currentObject -> TestIntersection(ray, intPoint, localNormal, localColor))
+		{
+			double dist = (intPoint - ray.m_point1).norm();
+			if (dist < minDist)
+			{
+				minDist = dist;
+				closestObject = currentObject;
+				closestIntPoint = intPoint;
+				closestLocalNormal = localNormal;
+				intersectionFound = true;
+			}
+		}
+	}
+	
+	return intersectionFound;
+}
+
+// Function to describe the surface hit by a path as a BSDF.
+void qbRT::PathTracer::GetBSDF(	const std::shared_ptr<qbRT::ObjectBase> &hitObject,
+																const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																const qbRT::Ray &incidentRay, qbRT::BSDF &bsdf)
+{
+	if (hitObject -> m_hasMaterial)
+	{
+		hitObject -> m_pMaterial -> GetBSDF(hitObject, intPoint, localNormal, incidentRay, bsdf);
+	}
+	else
+	{
+		// Objects without a material are diffuse, in their base color.
+		bsdf = qbRT::BSDF();
+		bsdf.m_normal = localNormal;
+		bsdf.SetWhittedLobes(hitObject -> m_baseColor, 0.0, 0.0);
+	}
+}
+
+// Function to add the light reaching a point directly from the lights and the environment.
+void qbRT::PathTracer::SampleLights(	const qbRT::BSDF &bsdf, const qbVector<double> &intPoint, const qbVector<double> &wo,
+																			const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+																			const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
+																			double *rgb)
+{
+	for (int c=0; c<3; ++c)
+		rgb[c] = 0.0;
+		
+	// Shadow rays start just off the side of the surface that is being looked at.
+	qbVector<double> normal = bsdf.m_normal;
+	normal.Normalize();
+	if (qbVector<double>::dot(normal, wo) < 0.0)
+		normal = normal * -1.0;
+	qbVector<double> startPoint = intPoint + (normal * 0.001);
+	
+	double f[3];
+	const std::vector<qbRT::MaterialBase::LightSample> &lightSamples = qbRT::MaterialBase::SelectLights(lightList, intPoint);
+	for (auto &lightSample : lightSamples)
+	{
+		qbRT::LightBase *currentLight = lightSample.light;
+		if (!currentLight->IsInRange((currentLight->m_location - intPoint).norm()))
+			continue;
+			
+		// Area lights are sampled at a single point, chosen at random.
+		qbVector<double> lightPoint = currentLight->m_location;
+		qbRT::AreaLight *areaLight = dynamic_cast<qbRT::AreaLight *>(currentLight);
+		if (areaLight)
+		{
+			double u1, u2;
+			qbRT::Random::Uniform2D(u1, u2);
+			lightPoint = areaLight->SamplePoint(u1, u2, intPoint);
+		}
+		
+		qbVector<double> lightDir = lightPoint - intPoint;
+		double lightDist = lightDir.norm();
+		if (lightDist <= 0.0)
+			continue;
+		lightDir = lightDir * (1.0 / lightDist);
+		
+		double cosTheta = qbVector<double>::dot(normal, lightDir);
+		if ((cosTheta <= 0.0) || !bsdf.Evaluate(wo, lightDir, f))
+			continue;
+			
+		// The current object is tested too, since the point may be inside it.
+		if (currentLight->IsOccluded(startPoint, lightPoint, objectList, nullptr))
+			continue;
+			
+		double irradiance = M_PI * currentLight->m_intensity * currentLight->GetAttenuation(lightDist) * cosTheta * lightSample.weight;
+		for (int c=0; c<3; ++c)
+			rgb[c] += f[c] * currentLight->m_color.GetElement(c) * irradiance;
+	}
+	
+	// Sample the environment, weighted against the chance of the BSDF choosing the same direction.
+	const std::shared_ptr<qbRT::EnvironmentLight> &environmentLight = qbRT::MaterialBase::m_environmentLight;
+	if (environmentLight && environmentLight->IsValid())
+	{
+		double u1, u2;
+		qbRT::Random::Uniform2D(u1, u2);
+		qbVector<double> direction {3};
+		double envColor[3];
+		double lightPdf;
+		if (!environmentLight->SampleDirection(u1, u2, direction, envColor, lightPdf) || (lightPdf <= 0.0))
+			return;
+			
+		// Use the same filtered radiance as a path that leaves the scene, so that both estimate the same light.
+		environmentLight->GetRadiance(direction, envColor);
+		
+		double cosTheta = qbVector<double>::dot(normal, direction);
+		if ((cosTheta <= 0.0) || !bsdf.Evaluate(wo, direction, f))
+			return;
+			
+		// The light is infinitely far away, so any object along the ray blocks it.
+		qbRT::Ray shadowRay (startPoint, startPoint + direction);
+		qbVector<double> poi				{3};
+		qbVector<double> poiNormal	{3};
+		qbVector<double> poiColor		{3};
+		for (auto &sceneObject : objectList)
+		{
+			if (sceneObject -> TestIntersection(shadowRay, poi, poiNormal, poiColor))
+				return;
+		}
+		
+		double weight = PowerHeuristic(lightPdf, bsdf.GetPDF(wo, direction)) * cosTheta / lightPdf;
+		for (int c=0; c<3; ++c)
+			rgb[c] += f[c] * envColor[c] * weight;
+	}
+}
+
+// Function to return the power heuristic weight.
+double qbRT::PathTracer::PowerHeuristic(double pdfA, double pdfB)
+{
+	double a = pdfA * pdfA;
+	double b = pdfB * pdfB;
+	return (a + b > 0.0) ? (a / (a + b)) : 0.0;
+}
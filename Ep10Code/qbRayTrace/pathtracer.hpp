@@ -0,0 +1,104 @@
+/* ***********************************************************
+	pathtracer.hpp
+	
+	The PathTracer class definition - A Monte Carlo integrator that
+	follows each camera ray through the scene as a random path,
+	bouncing from surface to surface by sampling the BSDF of each
+	material, and so gathers all of the light reflected and
+	transmitted between surfaces rather than the single bounces
+	of the Whitted shading. At every surface that is not purely
+	specular, a point is chosen on one or more lights and a shadow
+	ray cast to it (next-event estimation). Light from the
+	environment can be found both ways, so the two estimates are
+	combined with multiple importance sampling, using the power
+	heuristic. Point and area lights cannot be hit by a ray, so
+	they are found by next-event estimation alone.
+	
+	The lights in this renderer do not fall off with distance, and a
+	point light of intensity I lights a white diffuse surface facing
+	it with a brightness of I. To match, each light is treated as
+	giving an irradiance of pi * I times the cosine of the angle of
+	incidence, so that a Lambertian surface of the same color has
+	the same brightness as with the Whitted shading.
+	
+	The ambient light, irradiance cache, photon map and ambient
+	occlusion all approximate light that the path tracer finds for
+	itself, so it uses none of them.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef PATHTRACER_H
+#define PATHTRACER_H
+
+#include <memory>
+#include <vector>
+#include "ray.hpp"
+#include "./qbLinAlg/qbVector.h"
+#include "./qbPrimatives/objectbase.hpp"
+#include "./qbLights/lightbase.hpp"
+#include "./qbMaterials/bsdf.hpp"
+
+namespace qbRT
+{
+	class PathTracer
+	{
+		public:
+			// Constructor / destructor.
+			PathTracer();
+			~PathTracer();
+			
+			/* Function to compute the light arriving along a camera ray, given the first
+				object that it hits, if any. The lights must already have been passed to
+				the materials, as for the Whitted shading. Returns false if the ray neither
+				hit an object nor saw the environment. */
+			bool ComputeColor(	const qbRT::Ray &cameraRay, bool intersectionFound,
+													const std::shared_ptr<qbRT::ObjectBase> &firstObject,
+													const qbVector<double> &firstIntPoint, const qbVector<double> &firstLocalNormal,
+													const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+													const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
+													qbVector<double> &color);
+													
+		public:
+			// The largest number of bounces that a path may take.
+			int m_maxDepth = 8;
+			
+			/* The number of bounces after which paths may be ended at random, with a
+				probability that rises as the light they carry falls (Russian roulette). */
+			int m_rouletteDepth = 3;
+			
+		private:
+			/* Function to find the closest object along a ray, including the one that it
+				leaves, which a ray may hit again from the inside. */
+			static bool FindClosest(	const qbRT::Ray &ray, const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+																std::shared_ptr<qbRT::ObjectBase> &closestObject,
+																qbVector<double> &closestIntPoint, qbVector<double> &closestLocalNormal);
+																
+			// Function to describe the surface hit by a path as a BSDF.
+			static void GetBSDF(	const std::shared_ptr<qbRT::ObjectBase> &hitObject,
+														const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+														const qbRT::Ray &incidentRay, qbRT::BSDF &bsdf);
+														
+			/* Function to add the light reaching a point directly from the lights and the
+				environment, chosen by next-event estimation and scattered towards wo. */
+			static void SampleLights(	const qbRT::BSDF &bsdf, const qbVector<double> &intPoint, const qbVector<double> &wo,
+																const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+																const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
+																double *rgb);
+																
+			// Function to return the power heuristic weight for a sample with density pdfA, against a strategy with pdfB.
+			static double PowerHeuristic(double pdfA, double pdfB);
+	};
+}
+
+#endif
@@ -0,0 +1,99 @@
+/* ***********************************************************
+	perfcounter.cpp
+	
+	The PerfCounter class implementation - A class to count hardware
+	cache misses while rendering. This uses the Linux perf_event
+	interface and simply reports itself as unavailable on other
+	systems, or where the kernel does not allow access.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+// perfcounter.cpp
+
+#include "perfcounter.hpp"
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Constructor.
+qbRT::PerfCounter::PerfCounter()
+{
+	m_fd = -1;
+	m_count = 0;
+	
+	#ifdef __linux__
+		// Count last level cache misses for this thread only, in user space only.
+		perf_event_attr attributes;
+		memset(&attributes, 0, sizeof(attributes));
+		attributes.type = PERF_TYPE_HARDWARE;
+		attributes.size = sizeof(attributes);
+		attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+		attributes.disabled = 1;
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		m_fd = static_cast<int>(syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+	#endif
+}
+
+// Destructor.
+qbRT::PerfCounter::~PerfCounter()
+{
+	#ifdef __linux__
+		if (m_fd >= 0)
+			close(m_fd);
+	#endif
+}
+
+// Function to test whether the counter could be opened.
+bool qbRT::PerfCounter::IsAvailable() const
+{
+	return m_fd >= 0;
+}
+
+// Function to start counting.
+void qbRT::PerfCounter::Start()
+{
+	#ifdef __linux__
+		if (m_fd >= 0)
+		{
+			ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+	#endif
+}
+
+// Function to stop counting, adding the misses since Start to the total.
+void qbRT::PerfCounter::Stop()
+{
+	#ifdef __linux__
+		if (m_fd >= 0)
+		{
+			ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+			long long value = 0;
+			if (read(m_fd, &value, sizeof(value)) == sizeof(value))
+				m_count += value;
+		}
+	#endif
+}
+
+// Function to return the number of cache misses counted so far.
+long long qbRT::PerfCounter::GetCount() const
+{
+	return m_count;
+}
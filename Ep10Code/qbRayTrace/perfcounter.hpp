@@ -0,0 +1,56 @@
+/* ***********************************************************
+	perfcounter.hpp
+	
+	The PerfCounter class definition - A class to count hardware
+	cache misses while rendering. This uses the Linux perf_event
+	interface and simply reports itself as unavailable on other
+	systems, or where the kernel does not allow access.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+// perfcounter.hpp
+
+#ifndef PERFCOUNTER_H
+#define PERFCOUNTER_H
+
+namespace qbRT
+{
+	class PerfCounter
+	{
+		public:
+			// Constructor / destructor.
+			PerfCounter();
+			~PerfCounter();
+			
+			// The counter holds a file descriptor, so it cannot be copied.
+			PerfCounter(const PerfCounter &) = delete;
+			PerfCounter &operator= (const PerfCounter &) = delete;
+			
+			// Function to test whether the counter could be opened.
+			bool IsAvailable() const;
+			
+			// Functions to start and stop counting.
+			void Start();
+			void Stop();
+			
+			// Function to return the number of cache misses counted so far.
+			long long GetCount() const;
+			
+		private:
+			int m_fd;
+			long long m_count;
+	};
+}
+
+#endif
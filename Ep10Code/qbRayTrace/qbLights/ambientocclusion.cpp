@@ -0,0 +1,178 @@
+/* ***********************************************************
+	ambientocclusion.cpp
+	
+	The AmbientOcclusion class implementation - Estimates how much
+	of the hemisphere above a point is open, by casting short rays
+	that stop at the first object they meet within a maximum
+	distance. Objects whose bounding spheres are out of reach of
+	those rays are culled before any of them are tested, so the
+	cost depends on the nearby geometry rather than on the whole
+	scene.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "ambientocclusion.hpp"
+#include "../random.hpp"
+#include <algorithm>
+#include <cmath>
+
+// The objects that may occlude the point being shaded on this thread.
+static thread_local std::vector<int> t_candidates;
+
+// Constructor / destructor.
+qbRT::AmbientOcclusion::AmbientOcclusion()
+{
+
+}
+
+qbRT::AmbientOcclusion::~AmbientOcclusion()
+{
+
+}
+
+// Function to store the bounding spheres of the objects.
+void qbRT::AmbientOcclusion::Prepare(const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList)
+{
+	m_bounds.resize(objectList.size() * 4);
+	m_firstObject = objectList.empty() ? nullptr : objectList[0].get();
+	for (std::size_t i=0; i<objectList.size(); ++i)
+	{
+		qbVector<double> centre {3};
+		double radius;
+		objectList[i]->GetBoundingSphere(centre, radius);
+		for (int j=0; j<3; ++j)
+			m_bounds[(i * 4) + j] = centre.GetElement(j);
+		m_bounds[(i * 4) + 3] = radius;
+	}
+}
+
+// Function to compute the fraction of the hemisphere that is open.
+double qbRT::AmbientOcclusion::ComputeVisibility(	const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																									const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+																									const std::shared_ptr<qbRT::ObjectBase> &currentObject)
+{
+	int numSamples = std::max(1, m_numSamples);
+	double p[3] = {intPoint.GetElement(0), intPoint.GetElement(1), intPoint.GetElement(2)};
+	bool prepared = (m_bounds.size() == (objectList.size() * 4)) && (objectList.empty() || (objectList[0].get() == m_firstObject));
+	
+	/* Cull every object whose bounding sphere is further away than the rays reach,
+		which for short rays is almost all of them. */
+	std::vector<int> &candidates = t_candidates;
+	candidates.clear();
+	for (int i=0; i<static_cast<int>(objectList.size()); ++i)
+	{
+		if (objectList[i] == currentObject)
+			continue;
+			
+		if (prepared)
+		{
+			const double *bounds = &m_bounds[i * 4];
+			double distance2 = 0.0;
+			for (int j=0; j<3; ++j)
+				distance2 += (bounds[j] - p[j]) * (bounds[j] - p[j]);
+			double reach = m_maxDistance + bounds[3];
+			if (distance2 > (reach * reach))
+				continue;
+		}
+		candidates.push_back(i);
+	}
+	
+	if (candidates.empty())
+		return 1.0;
+		
+	// Build a basis around the normal, starting from whichever axis is furthest from it.
+	qbVector<double> w = localNormal;
+	w.Normalize();
+	qbVector<double> axis {std::vector<double> {1.0, 0.0, 0.0}};
+	if (std::abs(w.GetElement(0)) > 0.9)
+		axis = qbVector<double> {std::vector<double> {0.0, 1.0, 0.0}};
+	qbVector<double> tangent = qbVector<double>::cross(w, axis).Normalized();
+	qbVector<double> bitangent = qbVector<double>::cross(w, tangent);
+	
+	/* Spread the rays over the cosine-weighted hemisphere, as a lattice stratified in
+		the angle from the normal and stepped around it by the golden angle, shifted as a
+		whole by a single random pair. */
+	double shift1, shift2;
+	qbRT::Random::Uniform2D(shift1, shift2);
+	qbVector<double> poi				{3};
+	qbVector<double> poiNormal	{3};
+	qbVector<double> poiColor		{3};
+	int numOpen = 0;
+	uint64_t objectsTested = 0;
+	for (int i=0; i<numSamples; ++i)
+	{
+		double sinTheta = sqrt((static_cast<double>(i) + shift1) / static_cast<double>(numSamples));
+		double cosTheta = sqrt(std::max(0.0, 1.0 - (sinTheta * sinTheta)));
+		double phiFraction = shift2 + (static_cast<double>(i) * 0.6180339887498949);
+		double phi = 2.0 * M_PI * (phiFraction - floor(phiFraction));
+		qbVector<double> direction = (tangent * (sinTheta * cos(phi))) + (bitangent * (sinTheta * sin(phi))) + (w * cosTheta);
+		double d[3] = {direction.GetElement(0), direction.GetElement(1), direction.GetElement(2)};
+		qbRT::Ray aoRay (intPoint, intPoint + direction);
+		
+		bool occluded = false;
+		for (std::size_t c=0; (c<candidates.size()) && !occluded; ++c)
+		{
+			int objectIndex = candidates[c];
+			
+			// Skip objects whose bounding sphere this ray passes by.
+			if (prepared)
+			{
+				const double *bounds = &m_bounds[objectIndex * 4];
+				double toCentre[3] = {bounds[0] - p[0], bounds[1] - p[1], bounds[2] - p[2]};
+				double along = (toCentre[0] * d[0]) + (toCentre[1] * d[1]) + (toCentre[2] * d[2]);
+				double distance2 = (toCentre[0] * toCentre[0]) + (toCentre[1] * toCentre[1]) + (toCentre[2] * toCentre[2]);
+				double radius2 = bounds[3] * bounds[3];
+				if ((along < -bounds[3]) || (along > (m_maxDistance + bounds[3])) || ((distance2 - (along * along)) > radius2))
+					continue;
+			}
+			
+			// The first object met within range ends the ray.
+			objectsTested++;
+			if (objectList[objectIndex]->TestIntersection(aoRay, poi, poiNormal, poiColor) && ((poi - intPoint).norm() <= m_maxDistance))
+			{
+				// Neighbouring rays are likely to meet the same object, so test it first from now on.
+				std::swap(candidates[0], candidates[c]);
+				occluded = true;
+			}
+		}
+		
+		if (!occluded)
+			numOpen++;
+	}
+	
+	if (m_collectStats)
+	{
+		m_raysCast.fetch_add(numSamples, std::memory_order_relaxed);
+		m_objectsTested.fetch_add(objectsTested, std::memory_order_relaxed);
+	}
+	
+	return static_cast<double>(numOpen) / static_cast<double>(numSamples);
+}
+
+// Functions to return and reset the statistics.
+uint64_t qbRT::AmbientOcclusion::GetRaysCast() const
+{
+	return m_raysCast.load();
+}
+
+uint64_t qbRT::AmbientOcclusion::GetObjectsTested() const
+{
+	return m_objectsTested.load();
+}
+
+void qbRT::AmbientOcclusion::ResetStats()
+{
+	m_raysCast = 0;
+	m_objectsTested = 0;
+}
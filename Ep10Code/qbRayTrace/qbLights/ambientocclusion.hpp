@@ -0,0 +1,88 @@
+/* ***********************************************************
+	ambientocclusion.hpp
+	
+	The AmbientOcclusion class definition - Estimates how much of
+	the hemisphere above a point is open, by casting short rays
+	that stop at the first object they meet within a maximum
+	distance. Objects whose bounding spheres are out of reach of
+	those rays are culled before any of them are tested, so the
+	cost depends on the nearby geometry rather than on the whole
+	scene.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef AMBIENTOCCLUSION_H
+#define AMBIENTOCCLUSION_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "../qbPrimatives/objectbase.hpp"
+#include "../qbLinAlg/qbVector.h"
+
+namespace qbRT
+{
+	class AmbientOcclusion
+	{
+		public:
+			// Constructor / destructor.
+			AmbientOcclusion();
+			~AmbientOcclusion();
+			
+			// The counters are atomic, and so the class is not copyable.
+			AmbientOcclusion(const AmbientOcclusion &) = delete;
+			AmbientOcclusion &operator=(const AmbientOcclusion &) = delete;
+			
+			/* Function to store the bounding sphere of each object in the list, which
+				must be called again if the objects are moved, added or removed. */
+			void Prepare(const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList);
+			
+			/* Function to return the fraction of m_numSamples cosine-weighted rays from
+				the point that travel m_maxDistance without meeting another object, from
+				zero where the point is enclosed to one where it is fully open. If the list
+				is not the one that was prepared, every object is tested. */
+			double ComputeVisibility(	const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+																const std::shared_ptr<qbRT::ObjectBase> &currentObject);
+																
+			/* Functions to return and reset the number of rays cast and of objects tested
+				by them. These are only counted while m_collectStats is set. */
+			uint64_t GetRaysCast() const;
+			uint64_t GetObjectsTested() const;
+			void ResetStats();
+			
+		public:
+			// The number of rays cast from each point that is shaded.
+			int m_numSamples = 16;
+			
+			// The distance beyond which objects no longer occlude a point.
+			double m_maxDistance = 1.0;
+			
+			/* Whether to count the rays cast and the objects tested. Counting touches
+				counters shared by every thread at each shaded point, so it is off unless
+				the statistics are wanted. */
+			inline static bool m_collectStats = false;
+			
+		private:
+			// The bounding spheres of the prepared objects, as x, y, z and radius.
+			std::vector<double> m_bounds;
+			const qbRT::ObjectBase *m_firstObject = nullptr;
+			
+			std::atomic<uint64_t> m_raysCast {0};
+			std::atomic<uint64_t> m_objectsTested {0};
+	};
+}
+
+#endif
@@ -0,0 +1,120 @@
+/* ***********************************************************
+	arealight.cpp
+	
+	The AreaLight class implementation - A base class for lights with
+	a surface, which cast soft shadows. The illumination at a point
+	is averaged over a set of sample points on the light, spread
+	out with a low-discrepancy sequence, and the number of shadow
+	rays is adapted to how much of the light is visible.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "arealight.hpp"
+#include "../random.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Function to reflect the digits of n in the given base about the radix point.
+static double RadicalInverse(int n, int base)
+{
+	double invBase = 1.0 / static_cast<double>(base);
+	double scale = invBase;
+	double result = 0.0;
+	while (n > 0)
+	{
+		result += static_cast<double>(n % base) * scale;
+		n /= base;
+		scale *= invBase;
+	}
+	return result;
+}
+
+// Constructor / destructor.
+qbRT::AreaLight::AreaLight()
+{
+	m_color = qbVector<double> {std::vector<double> {1.0, 1.0, 1.0}};
+	m_intensity = 1.0;
+}
+
+qbRT::AreaLight::~AreaLight()
+{
+
+}
+
+// Function to compute illumination.
+bool qbRT::AreaLight::ComputeIllumination(	const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																						const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+																						const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																						qbVector<double> &color, double &intensity)
+{
+	color = m_color;
+	intensity = 0.0;
+	
+	// If the point is out of range, then there is no need for any shadow rays.
+	if (!IsInRange((m_location - intPoint).norm()))
+		return false;
+		
+	/* Use the 2D Halton sequence, shifted by a random offset for each point, so that
+		any number of samples taken from the start of it are spread evenly over the
+		light, while the sample points still differ from one point to the next. */
+	double offset1, offset2;
+	qbRT::Random::Uniform2D(offset1, offset2);
+	int maxSamples = std::max(1, m_maxShadowSamples);
+	int minSamples = std::min(std::max(1, m_minShadowSamples), maxSamples);
+	
+	double totalIllum = 0.0;
+	int numLit = 0;
+	int numSamples = 0;
+	for (; numSamples<maxSamples; ++numSamples)
+	{
+		// Once the probes have been tested, only carry on if they disagree.
+		if ((numSamples == minSamples) && ((numLit == 0) || (numLit == numSamples)))
+			break;
+			
+		double u1 = RadicalInverse(numSamples, 2) + offset1;
+		double u2 = RadicalInverse(numSamples, 3) + offset2;
+		qbVector<double> lightPoint = SamplePoint(u1 - floor(u1), u2 - floor(u2), intPoint);
+		
+		// Compute the angle between the local normal and the direction to this point on the light.
+		qbVector<double> lightDir = lightPoint - intPoint;
+		double lightDist = lightDir.norm();
+		lightDir = lightDir * (1.0 / lightDist);
+		double angle = acos(std::min(std::max(qbVector<double>::dot(localNormal, lightDir), -1.0), 1.0));
+		
+		// Points on the light behind the surface need no shadow ray.
+		if (angle > 1.5708)
+			continue;
+			
+		if (!IsOccluded(intPoint, lightPoint, objectList, currentObject))
+		{
+			numLit++;
+			totalIllum += (1.0 - (angle / 1.5708)) * GetAttenuation(lightDist);
+		}
+	}
+	
+	intensity = m_intensity * (totalIllum / static_cast<double>(numSamples));
+	return intensity > 0.0;
+}
+
+// Function to build an orthonormal basis around a unit vector.
+void qbRT::AreaLight::BuildBasis(const qbVector<double> &normal, qbVector<double> &tangent, qbVector<double> &bitangent)
+{
+	// Start from whichever axis is furthest from the normal.
+	qbVector<double> axis {std::vector<double> {1.0, 0.0, 0.0}};
+	if (std::abs(normal.GetElement(0)) > 0.9)
+		axis = qbVector<double> {std::vector<double> {0.0, 1.0, 0.0}};
+		
+	tangent = qbVector<double>::cross(normal, axis).Normalized();
+	bitangent = qbVector<double>::cross(normal, tangent);
+}
@@ -0,0 +1,62 @@
+/* ***********************************************************
+	arealight.hpp
+	
+	The AreaLight class definition - A base class for lights with
+	a surface, which cast soft shadows. The illumination at a point
+	is averaged over a set of sample points on the light, spread
+	out with a low-discrepancy sequence, and the number of shadow
+	rays is adapted to how much of the light is visible.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef AREALIGHT_H
+#define AREALIGHT_H
+
+#include "lightbase.hpp"
+
+namespace qbRT
+{
+	class AreaLight : public LightBase
+	{
+		public:
+			// Constructor / destructor.
+			AreaLight();
+			virtual ~AreaLight() override;
+			
+			/* Function to compute illumination. The first m_minShadowSamples sample points
+				are tested as probes. If they all agree, the point is either fully lit or
+				fully in shadow and their average is used; otherwise it lies in a penumbra
+				and the remaining samples, up to m_maxShadowSamples, are tested as well. */
+			virtual bool ComputeIllumination(	const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																				const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+																				const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																				qbVector<double> &color, double &intensity) override;
+																				
+			/* Function to return a point on the light, given two numbers in [0,1) that are
+				spread evenly over the light. The point being lit is given so that lights can
+				choose to sample only the part of their surface that faces it. */
+			virtual qbVector<double> SamplePoint(double u1, double u2, const qbVector<double> &intPoint) = 0;
+			
+		public:
+			// The number of probe shadow rays, and the most that are used in a penumbra.
+			int m_minShadowSamples = 4;
+			int m_maxShadowSamples = 16;
+			
+		protected:
+			// Function to build an orthonormal basis around the given unit vector.
+			static void BuildBasis(const qbVector<double> &normal, qbVector<double> &tangent, qbVector<double> &bitangent);
+	};
+}
+
+#endif
@@ -0,0 +1,68 @@
+/* ***********************************************************
+	disklight.cpp
+	
+	The DiskLight class implementation - A disk shaped area light, centred on m_location
+	and facing along m_normal.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "disklight.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Constructor / destructor.
+qbRT::DiskLight::DiskLight()
+{
+
+}
+
+qbRT::DiskLight::~DiskLight()
+{
+
+}
+
+// Function to return a point on the light.
+qbVector<double> qbRT::DiskLight::SamplePoint(double u1, double u2, const qbVector<double> &)
+{
+	/* Map the unit square onto the disk with the concentric mapping, which keeps
+		points that are spread evenly over the square spread evenly over the disk. */
+	double a = (2.0 * u1) - 1.0;
+	double b = (2.0 * u2) - 1.0;
+	double r = 0.0;
+	double phi = 0.0;
+	if ((a != 0.0) || (b != 0.0))
+	{
+		if (std::abs(a) > std::abs(b))
+		{
+			r = a;
+			phi = (M_PI / 4.0) * (b / a);
+		}
+		else
+		{
+			r = b;
+			phi = (M_PI / 2.0) - ((M_PI / 4.0) * (a / b));
+		}
+	}
+	
+	qbVector<double> tangent {3};
+	qbVector<double> bitangent {3};
+	BuildBasis(m_normal.Normalized(), tangent, bitangent);
+	return m_location + (tangent * (m_diskRadius * r * cos(phi))) + (bitangent * (m_diskRadius * r * sin(phi)));
+}
+
+// Function to return the size of the light.
+double qbRT::DiskLight::GetExtent() const
+{
+	return m_diskRadius;
+}
@@ -0,0 +1,47 @@
+/* ***********************************************************
+	disklight.hpp
+	
+	The DiskLight class definition - A disk shaped area light, centred on m_location
+	and facing along m_normal.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef DISKLIGHT_H
+#define DISKLIGHT_H
+
+#include "arealight.hpp"
+
+namespace qbRT
+{
+	class DiskLight : public AreaLight
+	{
+		public:
+			// Constructor / destructor.
+			DiskLight();
+			virtual ~DiskLight() override;
+			
+			// Function to return a point on the light.
+			virtual qbVector<double> SamplePoint(double u1, double u2, const qbVector<double> &intPoint) override;
+			
+			// Function to return the distance from the centre to the furthest point of the light.
+			virtual double GetExtent() const override;
+			
+		public:
+			// The direction that the disk faces, and its radius.
+			qbVector<double> m_normal {std::vector<double> {0.0, 0.0, 1.0}};
+			double m_diskRadius = 0.5;
+	};
+}
+
+#endif
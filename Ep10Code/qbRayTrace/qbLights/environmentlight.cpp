@@ -0,0 +1,376 @@
+/* ***********************************************************
+	environmentlight.cpp
+	
+	The EnvironmentLight class implementation - Light arriving from
+	every direction at an infinite distance, given by an HDR image
+	in the equirectangular (latitude / longitude) layout. Directions
+	are chosen in proportion to the brightness of the image, so that
+	a few shadow rays find the sun and the bright parts of the sky,
+	and a prefiltered copy of the image gives the unshadowed diffuse
+	lighting for any normal with a single lookup.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "environmentlight.hpp"
+#include "../random.hpp"
+#include "../qbTextures/hdrdecoder.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Function to return the luminance of a linear RGB value.
+static double Luminance(const float *rgb)
+{
+	return (0.2126 * rgb[0]) + (0.7152 * rgb[1]) + (0.0722 * rgb[2]);
+}
+
+// Constructor / destructor.
+qbRT::EnvironmentLight::EnvironmentLight()
+{
+
+}
+
+qbRT::EnvironmentLight::~EnvironmentLight()
+{
+
+}
+
+// Function to load the image from an HDR file.
+bool qbRT::EnvironmentLight::LoadHDR(const std::string &fileName)
+{
+	int xSize, ySize;
+	std::vector<float> rgba;
+	if (!qbRT::Texture::DecodeHDR(fileName, xSize, ySize, rgba))
+		return false;
+		
+	SetImage(xSize, ySize, rgba);
+	return true;
+}
+
+// Function to set the image.
+void qbRT::EnvironmentLight::SetImage(int xSize, int ySize, const std::vector<float> &rgba)
+{
+	m_xSize = xSize;
+	m_ySize = ySize;
+	m_radiance.resize(static_cast<std::size_t>(xSize) * ySize * 3);
+	for (std::size_t i=0; i<(static_cast<std::size_t>(xSize) * ySize); ++i)
+	{
+		for (int c=0; c<3; ++c)
+			m_radiance[(i * 3) + c] = std::max(rgba[(i * 4) + c], 0.0f);
+	}
+	
+	// Build the cumulative distribution for each row, and then over the rows.
+	m_conditionalCDF.assign(static_cast<std::size_t>(ySize) * (xSize + 1), 0.0f);
+	m_rowIntegral.assign(ySize, 0.0f);
+	m_marginalCDF.assign(ySize + 1, 0.0f);
+	double marginalSum = 0.0;
+	for (int y=0; y<ySize; ++y)
+	{
+		double sinTheta = sin(M_PI * (static_cast<double>(y) + 0.5) / static_cast<double>(ySize));
+		float *cdf = &m_conditionalCDF[static_cast<std::size_t>(y) * (xSize + 1)];
+		double rowSum = 0.0;
+		std::vector<double> running (xSize + 1, 0.0);
+		for (int x=0; x<xSize; ++x)
+		{
+			rowSum += Luminance(&m_radiance[((static_cast<std::size_t>(y) * xSize) + x) * 3]) * sinTheta;
+			running[x + 1] = rowSum;
+		}
+		
+		// A black row is given a uniform distribution, which will never be chosen.
+		for (int x=1; x<=xSize; ++x)
+			cdf[x] = (rowSum > 0.0) ? static_cast<float>(running[x] / rowSum) : static_cast<float>(x) / static_cast<float>(xSize);
+		cdf[xSize] = 1.0f;
+		
+		m_rowIntegral[y] = static_cast<float>(rowSum / static_cast<double>(xSize));
+		marginalSum += m_rowIntegral[y];
+		m_marginalCDF[y + 1] = static_cast<float>(marginalSum);
+	}
+	
+	m_totalIntegral = marginalSum / static_cast<double>(ySize);
+	for (int y=1; y<=ySize; ++y)
+		m_marginalCDF[y] = (marginalSum > 0.0) ? static_cast<float>(m_marginalCDF[y] / marginalSum) : static_cast<float>(y) / static_cast<float>(ySize);
+	m_marginalCDF[ySize] = 1.0f;
+	
+	BuildIrradiance();
+}
+
+// Function to return whether an image has been set.
+bool qbRT::EnvironmentLight::IsValid() const
+{
+	return !m_radiance.empty();
+}
+
+// Function to return the radiance from a direction.
+void qbRT::EnvironmentLight::GetRadiance(const qbVector<double> &direction, double *rgb) const
+{
+	for (int c=0; c<3; ++c)
+		rgb[c] = 0.0;
+	if (!IsValid())
+		return;
+		
+	double u, v;
+	DirectionToUV(direction, u, v);
+	LookupBilinear(m_radiance, m_xSize, m_ySize, u, v, rgb);
+	for (int c=0; c<3; ++c)
+		rgb[c] *= m_intensity;
+}
+
+// Function to choose a direction.
+bool qbRT::EnvironmentLight::SampleDirection(double u1, double u2, qbVector<double> &direction, double *rgb, double &pdf) const
+{
+	pdf = 0.0;
+	if (!IsValid() || (m_totalIntegral <= 0.0))
+		return false;
+		
+	// Choose a row, and then a texel within it.
+	double vOffset, uOffset;
+	int y = SampleCDF(m_marginalCDF.data(), m_ySize, u2, vOffset);
+	int x = SampleCDF(&m_conditionalCDF[static_cast<std::size_t>(y) * (m_xSize + 1)], m_xSize, u1, uOffset);
+	double u = (static_cast<double>(x) + uOffset) / static_cast<double>(m_xSize);
+	double v = (static_cast<double>(y) + vOffset) / static_cast<double>(m_ySize);
+	
+	double sinTheta = sin(M_PI * v);
+	if (sinTheta <= 0.0)
+		return false;
+		
+	/* The density over the image is the weight of the texel over the total, which is
+		converted to solid angle by dividing by the area that the image covers. */
+	const float *texel = &m_radiance[((static_cast<std::size_t>(y) * m_xSize) + x) * 3];
+	double texelSinTheta = sin(M_PI * (static_cast<double>(y) + 0.5) / static_cast<double>(m_ySize));
+	double weight = Luminance(texel) * texelSinTheta;
+	pdf = (weight / m_totalIntegral) / (2.0 * M_PI * M_PI * sinTheta);
+	
+	direction = UVToDirection(u, v);
+	for (int c=0; c<3; ++c)
+		rgb[c] = texel[c] * m_intensity;
+		
+	return pdf > 0.0;
+}
+
+// Function to return the probability density of a direction.
+double qbRT::EnvironmentLight::GetPDF(const qbVector<double> &direction) const
+{
+	if (!IsValid() || (m_totalIntegral <= 0.0))
+		return 0.0;
+		
+	double u, v;
+	DirectionToUV(direction, u, v);
+	double sinTheta = sin(M_PI * v);
+	if (sinTheta <= 0.0)
+		return 0.0;
+		
+	int x = std::min(static_cast<int>(u * static_cast<double>(m_xSize)), m_xSize - 1);
+	int y = std::min(static_cast<int>(v * static_cast<double>(m_ySize)), m_ySize - 1);
+	double texelSinTheta = sin(M_PI * (static_cast<double>(y) + 0.5) / static_cast<double>(m_ySize));
+	double weight = Luminance(&m_radiance[((static_cast<std::size_t>(y) * m_xSize) + x) * 3]) * texelSinTheta;
+	return (weight / m_totalIntegral) / (2.0 * M_PI * M_PI * sinTheta);
+}
+
+// Function to return the prefiltered diffuse lighting.
+void qbRT::EnvironmentLight::GetIrradiance(const qbVector<double> &normal, double *rgb) const
+{
+	for (int c=0; c<3; ++c)
+		rgb[c] = 0.0;
+	if (m_irradiance.empty())
+		return;
+		
+	double u, v;
+	DirectionToUV(normal, u, v);
+	LookupBilinear(m_irradiance, m_irradianceXSize, m_irradianceYSize, u, v, rgb);
+	for (int c=0; c<3; ++c)
+		rgb[c] *= m_intensity;
+}
+
+// Function to compute the diffuse lighting at a point.
+void qbRT::EnvironmentLight::ComputeIllumination(	const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																									const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+																									const std::shared_ptr<qbRT::ObjectBase> &currentObject, double *rgb) const
+{
+	if (m_numSamples <= 0)
+	{
+		GetIrradiance(localNormal, rgb);
+		return;
+	}
+	
+	for (int c=0; c<3; ++c)
+		rgb[c] = 0.0;
+		
+	qbVector<double> direction	{3};
+	qbVector<double> poi				{3};
+	qbVector<double> poiNormal	{3};
+	qbVector<double> poiColor		{3};
+	double radiance[3];
+	double pdf;
+	for (int i=0; i<m_numSamples; ++i)
+	{
+		// Directions below the surface need no shadow ray.
+		double u1, u2;
+		qbRT::Random::Uniform2D(u1, u2);
+		if (!SampleDirection(u1, u2, direction, radiance, pdf))
+			continue;
+		double cosTheta = qbVector<double>::dot(localNormal, direction);
+		if (cosTheta <= 0.0)
+			continue;
+			
+		// The light is infinitely far away, so any object along the ray blocks it.
+		qbRT::Ray shadowRay (intPoint, intPoint + direction);
+		bool blocked = false;
+		for (auto &sceneObject : objectList)
+		{
+			if ((sceneObject != currentObject) && (sceneObject -> TestIntersection(shadowRay, poi, poiNormal, poiColor)))
+			{
+				blocked = true;
+				break;
+			}
+		}
+		
+		if (!blocked)
+		{
+			for (int c=0; c<3; ++c)
+				rgb[c] += (radiance[c] * cosTheta) / (M_PI * pdf);
+		}
+	}
+	
+	for (int c=0; c<3; ++c)
+		rgb[c] /= static_cast<double>(m_numSamples);
+}
+
+// Function to look up a bilinearly filtered value.
+void qbRT::EnvironmentLight::LookupBilinear(const std::vector<float> &image, int xSize, int ySize, double u, double v, double *rgb)
+{
+	// Wrap around the horizon, but not over the poles.
+	double x = (u * static_cast<double>(xSize)) - 0.5;
+	double y = (v * static_cast<double>(ySize)) - 0.5;
+	double x0 = floor(x);
+	double y0 = floor(y);
+	double fx = x - x0;
+	double fy = y - y0;
+	int xs[2], ys[2];
+	for (int i=0; i<2; ++i)
+	{
+		xs[i] = ((static_cast<int>(x0) + i) % xSize + xSize) % xSize;
+		ys[i] = std::min(std::max(static_cast<int>(y0) + i, 0), ySize - 1);
+	}
+	
+	for (int c=0; c<3; ++c)
+	{
+		double top = ((1.0 - fx) * image[((ys[0] * xSize) + xs[0]) * 3 + c]) + (fx * image[((ys[0] * xSize) + xs[1]) * 3 + c]);
+		double bottom = ((1.0 - fx) * image[((ys[1] * xSize) + xs[0]) * 3 + c]) + (fx * image[((ys[1] * xSize) + xs[1]) * 3 + c]);
+		rgb[c] = ((1.0 - fy) * top) + (fy * bottom);
+	}
+}
+
+// Function to convert a direction to (u,v).
+void qbRT::EnvironmentLight::DirectionToUV(const qbVector<double> &direction, double &u, double &v)
+{
+	double x = direction.GetElement(0);
+	double y = direction.GetElement(1);
+	double z = direction.GetElement(2);
+	double length = sqrt((x * x) + (y * y) + (z * z));
+	if (length <= 0.0)
+	{
+		u = 0.0;
+		v = 0.0;
+		return;
+	}
+	
+	u = (atan2(y, x) + M_PI) / (2.0 * M_PI);
+	v = acos(std::min(std::max(z / length, -1.0), 1.0)) / M_PI;
+	u = std::min(std::max(u, 0.0), 1.0 - 1e-12);
+	v = std::min(std::max(v, 0.0), 1.0 - 1e-12);
+}
+
+// Function to convert (u,v) to a direction.
+qbVector<double> qbRT::EnvironmentLight::UVToDirection(double u, double v)
+{
+	double phi = (2.0 * M_PI * u) - M_PI;
+	double theta = M_PI * v;
+	return qbVector<double> {std::vector<double> {sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta)}};
+}
+
+// Function to sample a cumulative distribution.
+int qbRT::EnvironmentLight::SampleCDF(const float *cdf, int count, double u, double &offset)
+{
+	// Find the last interval that starts at or below u.
+	int index = static_cast<int>(std::upper_bound(cdf, cdf + count + 1, static_cast<float>(u)) - cdf) - 1;
+	index = std::min(std::max(index, 0), count - 1);
+	double width = cdf[index + 1] - cdf[index];
+	offset = (width > 0.0) ? std::min(std::max((u - cdf[index]) / width, 0.0), 1.0 - 1e-9) : 0.5;
+	return index;
+}
+
+// Function to build the prefiltered image.
+void qbRT::EnvironmentLight::BuildIrradiance()
+{
+	/* Shrink the image first, as the cosine lobe is so wide that detail much finer
+		than the prefiltered image makes no difference. */
+	int smallXSize = std::min(m_xSize, 2 * m_irradianceXSize);
+	int smallYSize = std::min(m_ySize, 2 * m_irradianceYSize);
+	std::vector<double> small (static_cast<std::size_t>(smallXSize) * smallYSize * 3, 0.0);
+	std::vector<double> weights (static_cast<std::size_t>(smallXSize) * smallYSize, 0.0);
+	for (int y=0; y<m_ySize; ++y)
+	{
+		int sy = (y * smallYSize) / m_ySize;
+		for (int x=0; x<m_xSize; ++x)
+		{
+			int sx = (x * smallXSize) / m_xSize;
+			int index = (sy * smallXSize) + sx;
+			for (int c=0; c<3; ++c)
+				small[(index * 3) + c] += m_radiance[((static_cast<std::size_t>(y) * m_xSize) + x) * 3 + c];
+			weights[index] += 1.0;
+		}
+	}
+	
+	// Find the direction and solid angle of each texel of the shrunk image.
+	std::vector<qbVector<double>> directions;
+	std::vector<double> solidAngles;
+	for (int y=0; y<smallYSize; ++y)
+	{
+		double v = (static_cast<double>(y) + 0.5) / static_cast<double>(smallYSize);
+		for (int x=0; x<smallXSize; ++x)
+		{
+			int index = (y * smallXSize) + x;
+			for (int c=0; c<3; ++c)
+				small[(index * 3) + c] /= std::max(weights[index], 1.0);
+			directions.push_back(UVToDirection((static_cast<double>(x) + 0.5) / static_cast<double>(smallXSize), v));
+			solidAngles.push_back((2.0 * M_PI / static_cast<double>(smallXSize)) * (M_PI / static_cast<double>(smallYSize)) * sin(M_PI * v));
+		}
+	}
+	
+	// Then integrate the cosine-weighted radiance over the hemisphere about each normal.
+	m_irradiance.assign(static_cast<std::size_t>(m_irradianceXSize) * m_irradianceYSize * 3, 0.0f);
+	for (int y=0; y<m_irradianceYSize; ++y)
+	{
+		for (int x=0; x<m_irradianceXSize; ++x)
+		{
+			qbVector<double> normal = UVToDirection(	(static_cast<double>(x) + 0.5) / static_cast<double>(m_irradianceXSize),
+																								(static_cast<double>(y) + 0.5) / static_cast<double>(m_irradianceYSize));
+			double sum[3] = {0.0, 0.0, 0.0};
+			double cosineSum = 0.0;
+			for (std::size_t i=0; i<directions.size(); ++i)
+			{
+				double cosTheta = qbVector<double>::dot(normal, directions[i]);
+				if (cosTheta <= 0.0)
+					continue;
+				for (int c=0; c<3; ++c)
+					sum[c] += small[(i * 3) + c] * cosTheta * solidAngles[i];
+				cosineSum += cosTheta * solidAngles[i];
+			}
+			
+			/* The cosine over the hemisphere integrates to pi, but dividing by the sum found
+				on the same texels instead means that a uniform environment stays uniform. */
+			for (int c=0; c<3; ++c)
+				m_irradiance[((y * m_irradianceXSize) + x) * 3 + c] = static_cast<float>((cosineSum > 0.0) ? (sum[c] / cosineSum) : 0.0);
+		}
+	}
+}
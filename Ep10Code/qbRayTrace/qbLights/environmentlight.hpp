@@ -0,0 +1,125 @@
+/* ***********************************************************
+	environmentlight.hpp
+	
+	The EnvironmentLight class definition - Light arriving from
+	every direction at an infinite distance, given by an HDR image
+	in the equirectangular (latitude / longitude) layout. Directions
+	are chosen in proportion to the brightness of the image, so that
+	a few shadow rays find the sun and the bright parts of the sky,
+	and a prefiltered copy of the image gives the unshadowed diffuse
+	lighting for any normal with a single lookup.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef ENVIRONMENTLIGHT_H
+#define ENVIRONMENTLIGHT_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "../qbLinAlg/qbVector.h"
+#include "../ray.hpp"
+#include "../qbPrimatives/objectbase.hpp"
+
+namespace qbRT
+{
+	class EnvironmentLight
+	{
+		public:
+			// Constructor / destructor.
+			EnvironmentLight();
+			~EnvironmentLight();
+			
+			// Function to load the image from a Radiance HDR file.
+			bool LoadHDR(const std::string &fileName);
+			
+			/* Function to set the image from RGBA values, four per texel, with rows
+				running from the top of the image down. The top row looks straight up
+				(along +z) and the bottom row straight down, and the columns run once
+				around the horizon starting from the -x axis. */
+			void SetImage(int xSize, int ySize, const std::vector<float> &rgba);
+			
+			// Function to return whether an image has been set.
+			bool IsValid() const;
+			
+			// Function to return the radiance arriving from the given direction.
+			void GetRadiance(const qbVector<double> &direction, double *rgb) const;
+			
+			/* Function to choose a direction in proportion to the brightness of the image,
+				given two random numbers in [0,1). Returns the direction, the radiance from
+				it and its probability density with respect to solid angle. Returns false if
+				the image is black. */
+			bool SampleDirection(double u1, double u2, qbVector<double> &direction, double *rgb, double &pdf) const;
+			
+			// Function to return the probability density of SampleDirection choosing the given direction.
+			double GetPDF(const qbVector<double> &direction) const;
+			
+			/* Function to return the diffuse lighting for a surface with the given normal,
+				ignoring shadows. This is the irradiance divided by pi, which is the same as
+				the radiance from a uniform environment that would give the same lighting. */
+			void GetIrradiance(const qbVector<double> &normal, double *rgb) const;
+			
+			/* Function to compute the diffuse lighting at a point, with shadows, from
+				m_numSamples directions chosen by SampleDirection. With no samples, the
+				prefiltered lighting from GetIrradiance is used instead. */
+			void ComputeIllumination(	const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+																const std::shared_ptr<qbRT::ObjectBase> &currentObject, double *rgb) const;
+																
+		public:
+			// A scale applied to every value returned.
+			double m_intensity = 1.0;
+			
+			// The number of shadow rays used by ComputeIllumination.
+			int m_numSamples = 8;
+			
+			// The size of the prefiltered image.
+			int m_irradianceXSize = 32;
+			int m_irradianceYSize = 16;
+			
+		private:
+			// Function to look up a bilinearly filtered value in an image of RGB values.
+			static void LookupBilinear(const std::vector<float> &image, int xSize, int ySize, double u, double v, double *rgb);
+			
+			// Functions to convert between directions and (u,v) in the image.
+			static void DirectionToUV(const qbVector<double> &direction, double &u, double &v);
+			static qbVector<double> UVToDirection(double u, double v);
+			
+			// Function to find the position of u within a cumulative distribution, returning the interval that it lies in.
+			static int SampleCDF(const float *cdf, int count, double u, double &offset);
+			
+			// Function to build the prefiltered image.
+			void BuildIrradiance();
+			
+		private:
+			// The image, as RGB values.
+			int m_xSize = 0;
+			int m_ySize = 0;
+			std::vector<float> m_radiance;
+			
+			/* The distributions used to choose directions. Each row has a cumulative
+				distribution over its texels, and the rows have a cumulative distribution
+				over their totals. Each texel is weighted by its luminance times the sine
+				of its angle from the pole, to allow for rows shrinking towards the poles. */
+			std::vector<float> m_conditionalCDF;
+			std::vector<float> m_rowIntegral;
+			std::vector<float> m_marginalCDF;
+			double m_totalIntegral = 0.0;
+			
+			// The prefiltered image, as RGB values.
+			std::vector<float> m_irradiance;
+	};
+}
+
+#endif
@@ -0,0 +1,431 @@
+/* ***********************************************************
+	irradiancecache.cpp
+	
+	The IrradianceCache class implementation - A sparse set of records
+	of the diffuse light arriving at points in the scene, each with
+	its gradients, held in an octree. The light at other points
+	nearby is interpolated from the records, so that the expensive
+	hemisphere of rays needed for indirect lighting is only traced
+	at a small fraction of the points that are shaded. Records are
+	added as they are needed, and may be added and looked up from
+	several threads at once without locking.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "irradiancecache.hpp"
+#include "../random.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// Node constructor.
+qbRT::IrradianceCache::Node::Node()
+{
+	for (int i=0; i<8; ++i)
+		children[i] = nullptr;
+	records = nullptr;
+}
+
+// Constructor / destructor.
+qbRT::IrradianceCache::IrradianceCache()
+{
+	for (int j=0; j<3; ++j)
+	{
+		m_boundsMin[j] = -100.0;
+		m_boundsMax[j] = 100.0;
+	}
+	m_root = new Node();
+}
+
+qbRT::IrradianceCache::IrradianceCache(const qbVector<double> &boundsMin, const qbVector<double> &boundsMax)
+{
+	for (int j=0; j<3; ++j)
+	{
+		m_boundsMin[j] = boundsMin.GetElement(j);
+		m_boundsMax[j] = boundsMax.GetElement(j);
+	}
+	m_root = new Node();
+}
+
+qbRT::IrradianceCache::~IrradianceCache()
+{
+	DeleteNode(m_root);
+}
+
+// Function to interpolate the light at a point.
+bool qbRT::IrradianceCache::Lookup(const qbVector<double> &point, const qbVector<double> &normal, double *rgb) const
+{
+	double p[3] = {point.GetElement(0), point.GetElement(1), point.GetElement(2)};
+	double n[3] = {normal.GetElement(0), normal.GetElement(1), normal.GetElement(2)};
+	double sum[3] = {0.0, 0.0, 0.0};
+	double weightSum = 0.0;
+	
+	// Records are held at every level, so check each node on the way down to the point.
+	double nodeMin[3], nodeMax[3];
+	bool inside = true;
+	for (int j=0; j<3; ++j)
+	{
+		nodeMin[j] = m_boundsMin[j];
+		nodeMax[j] = m_boundsMax[j];
+		inside = inside && (p[j] >= nodeMin[j]) && (p[j] <= nodeMax[j]);
+	}
+	
+	const Node *node = m_root;
+	AccumulateRecords(node->records.load(std::memory_order_acquire), p, n, sum, weightSum);
+	while (inside)
+	{
+		int child = 0;
+		for (int j=0; j<3; ++j)
+		{
+			double middle = 0.5 * (nodeMin[j] + nodeMax[j]);
+			if (p[j] >= middle)
+			{
+				child |= 1 << j;
+				nodeMin[j] = middle;
+			}
+			else
+			{
+				nodeMax[j] = middle;
+			}
+		}
+		
+		node = node->children[child].load(std::memory_order_acquire);
+		if (!node)
+			break;
+		AccumulateRecords(node->records.load(std::memory_order_acquire), p, n, sum, weightSum);
+	}
+	
+	if (weightSum <= 0.0)
+	{
+		m_misses.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	
+	m_hits.fetch_add(1, std::memory_order_relaxed);
+	for (int c=0; c<3; ++c)
+		rgb[c] = std::max(sum[c] / weightSum, 0.0);
+	return true;
+}
+
+// Function to compute a new record.
+void qbRT::IrradianceCache::ComputeRecord(	const qbVector<double> &point, const qbVector<double> &normal,
+																						const TraceFunction &traceRay, Record &record) const
+{
+	int numTheta = std::max(2, m_numThetaSamples);
+	int numPhi = std::max(3, m_numPhiSamples);
+	int numSamples = numTheta * numPhi;
+	
+	// Build a basis around the normal, starting from whichever axis is furthest from it.
+	qbVector<double> w = normal;
+	w.Normalize();
+	qbVector<double> axis {std::vector<double> {1.0, 0.0, 0.0}};
+	if (std::abs(w.GetElement(0)) > 0.9)
+		axis = qbVector<double> {std::vector<double> {0.0, 1.0, 0.0}};
+	qbVector<double> tangent = qbVector<double>::cross(w, axis).Normalized();
+	qbVector<double> bitangent = qbVector<double>::cross(w, tangent);
+	
+	/* Trace one ray in each cell of a grid over the hemisphere, with the cells of
+		equal cosine-weighted solid angle, so that the irradiance is just the mean
+		of the radiance. */
+	std::vector<double> radiance (numSamples * 3, 0.0);
+	std::vector<double> distance (numSamples, std::numeric_limits<double>::infinity());
+	std::vector<double> tanTheta (numSamples, 0.0);
+	for (int j=0; j<numTheta; ++j)
+	{
+		for (int k=0; k<numPhi; ++k)
+		{
+			int index = (j * numPhi) + k;
+			double jitter1, jitter2;
+			qbRT::Random::Uniform2D(jitter1, jitter2);
+			double sinTheta = sqrt((static_cast<double>(j) + jitter1) / static_cast<double>(numTheta));
+			double cosTheta = sqrt(std::max(0.0, 1.0 - (sinTheta * sinTheta)));
+			double phi = 2.0 * M_PI * (static_cast<double>(k) + jitter2) / static_cast<double>(numPhi);
+			tanTheta[index] = sinTheta / std::max(cosTheta, 1e-6);
+			qbVector<double> direction = (tangent * (sinTheta * cos(phi))) + (bitangent * (sinTheta * sin(phi))) + (w * cosTheta);
+			
+			double rgb[3] = {0.0, 0.0, 0.0};
+			double hitDistance;
+			if (traceRay(direction, rgb, hitDistance))
+				distance[index] = std::max(hitDistance, 1e-6);
+			for (int c=0; c<3; ++c)
+				radiance[(index * 3) + c] = rgb[c];
+		}
+	}
+	
+	// The irradiance, and the harmonic mean distance to the surfaces seen, which sets the radius.
+	double inverseDistanceSum = 0.0;
+	for (int c=0; c<3; ++c)
+		record.irradiance[c] = 0.0;
+	for (int i=0; i<numSamples; ++i)
+	{
+		for (int c=0; c<3; ++c)
+			record.irradiance[c] += radiance[(i * 3) + c] / static_cast<double>(numSamples);
+		inverseDistanceSum += 1.0 / distance[i];
+	}
+	double radius = (inverseDistanceSum > 0.0) ? static_cast<double>(numSamples) / inverseDistanceSum : m_maxSpacing;
+	
+	/* The gradients, following Ward and Heckbert. The rotational gradient comes
+		from how the cosine weighting of each sample changes as the normal turns. The
+		translational gradient comes from how the boundaries between neighbouring
+		cells move as the point moves, in proportion to the distance to what they see.
+		The boundaries between cells around the pole use the projected solid angle of
+		the cells, rather than the cosines of their edges as in the original. */
+	double rotational[3][3] = {};
+	double translational[3][3] = {};
+	for (int k=0; k<numPhi; ++k)
+	{
+		double phiCentre = 2.0 * M_PI * (static_cast<double>(k) + 0.5) / static_cast<double>(numPhi);
+		double phiEdge = 2.0 * M_PI * static_cast<double>(k) / static_cast<double>(numPhi);
+		qbVector<double> uCentre = (tangent * cos(phiCentre)) + (bitangent * sin(phiCentre));
+		qbVector<double> vCentre = (tangent * -sin(phiCentre)) + (bitangent * cos(phiCentre));
+		qbVector<double> vEdge = (tangent * -sin(phiEdge)) + (bitangent * cos(phiEdge));
+		int previousK = (k + numPhi - 1) % numPhi;
+		
+		for (int j=0; j<numTheta; ++j)
+		{
+			int index = (j * numPhi) + k;
+			double sin2Lower = static_cast<double>(j) / static_cast<double>(numTheta);
+			double sin2Upper = static_cast<double>(j + 1) / static_cast<double>(numTheta);
+			double sinLower = sqrt(sin2Lower);
+			double cosLower = sqrt(1.0 - sin2Lower);
+			double sinCentre = sqrt((static_cast<double>(j) + 0.5) / static_cast<double>(numTheta));
+			
+			// Across the boundary with the cell nearer the pole.
+			double thetaFactor = 0.0;
+			if (j > 0)
+			{
+				int below = ((j - 1) * numPhi) + k;
+				thetaFactor = (2.0 * M_PI / static_cast<double>(numPhi)) * sinLower * (cosLower * cosLower) / std::min(distance[index], distance[below]);
+				for (int c=0; c<3; ++c)
+				{
+					double difference = radiance[(index * 3) + c] - radiance[(below * 3) + c];
+					for (int a=0; a<3; ++a)
+						translational[c][a] += uCentre.GetElement(a) * thetaFactor * difference;
+				}
+			}
+			
+			// Across the boundary with the previous cell around the pole.
+			int beside = (j * numPhi) + previousK;
+			double phiFactor = (0.5 * (sin2Upper - sin2Lower)) / (sinCentre * std::min(distance[index], distance[beside]));
+			for (int c=0; c<3; ++c)
+			{
+				double difference = radiance[(index * 3) + c] - radiance[(beside * 3) + c];
+				for (int a=0; a<3; ++a)
+				{
+					translational[c][a] += vEdge.GetElement(a) * phiFactor * difference;
+					rotational[c][a] += vCentre.GetElement(a) * tanTheta[index] * radiance[(index * 3) + c] / static_cast<double>(numSamples);
+				}
+			}
+		}
+	}
+	
+	// The gradients above are of the irradiance itself, so divide by pi to match.
+	for (int c=0; c<3; ++c)
+	{
+		for (int a=0; a<3; ++a)
+		{
+			record.rotationalGradient[c][a] = rotational[c][a];
+			record.translationalGradient[c][a] = translational[c][a] / M_PI;
+		}
+	}
+	
+	/* Where the light changes quickly, such as near a shadow boundary, the record
+		should not be used over a distance in which the change would exceed the
+		light itself. */
+	double luminance = (0.2126 * record.irradiance[0]) + (0.7152 * record.irradiance[1]) + (0.0722 * record.irradiance[2]);
+	double gradientLength = 0.0;
+	for (int a=0; a<3; ++a)
+	{
+		double component = (0.2126 * record.translationalGradient[0][a]) + (0.7152 * record.translationalGradient[1][a]) + (0.0722 * record.translationalGradient[2][a]);
+		gradientLength += component * component;
+	}
+	gradientLength = sqrt(gradientLength);
+	if (gradientLength > 0.0)
+		radius = std::min(radius, luminance / gradientLength);
+		
+	record.radius = std::min(std::max(radius, m_minSpacing), m_maxSpacing);
+	for (int a=0; a<3; ++a)
+	{
+		record.position[a] = point.GetElement(a);
+		record.normal[a] = w.GetElement(a);
+	}
+}
+
+// Function to add a record.
+void qbRT::IrradianceCache::Insert(const Record &record)
+{
+	// The record is only used within this distance of its position.
+	double influence = m_accuracy * record.radius;
+	double recordMin[3], recordMax[3];
+	bool inside = true;
+	for (int j=0; j<3; ++j)
+	{
+		recordMin[j] = record.position[j] - influence;
+		recordMax[j] = record.position[j] + influence;
+		inside = inside && (recordMin[j] >= m_boundsMin[j]) && (recordMax[j] <= m_boundsMax[j]);
+	}
+	
+	// Records that reach outside the octree are held at the root, where every lookup finds them.
+	if (inside)
+	{
+		InsertIntoNode(m_root, m_boundsMin, m_boundsMax, record, recordMin, recordMax, 0);
+	}
+	else
+	{
+		RecordNode *recordNode = new RecordNode {record, m_root->records.load(std::memory_order_relaxed)};
+		while (!m_root->records.compare_exchange_weak(recordNode->next, recordNode, std::memory_order_release, std::memory_order_relaxed));
+	}
+	
+	m_numRecords.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Function to remove every record.
+void qbRT::IrradianceCache::Clear()
+{
+	DeleteNode(m_root);
+	m_root = new Node();
+	m_numRecords = 0;
+	m_hits = 0;
+	m_misses = 0;
+}
+
+// Functions to return the number of records and the lookup statistics.
+int qbRT::IrradianceCache::GetNumRecords() const
+{
+	return m_numRecords.load();
+}
+
+uint64_t qbRT::IrradianceCache::GetHits() const
+{
+	return m_hits.load();
+}
+
+uint64_t qbRT::IrradianceCache::GetMisses() const
+{
+	return m_misses.load();
+}
+
+// Function to add a record to a node.
+void qbRT::IrradianceCache::InsertIntoNode(Node *node, const double *nodeMin, const double *nodeMax, const Record &record, const double *recordMin, const double *recordMax, int depth)
+{
+	/* Hold the record at the first level where the children would be smaller than
+		the region it is used over. Lower down, it is held by each child that it
+		overlaps, so that a lookup, which follows a single path, finds it only once. */
+	double childSize = 0.0;
+	for (int j=0; j<3; ++j)
+		childSize = std::max(childSize, 0.5 * (nodeMax[j] - nodeMin[j]));
+		
+	if ((depth >= m_maxDepth) || (childSize < (recordMax[0] - recordMin[0])))
+	{
+		RecordNode *recordNode = new RecordNode {record, node->records.load(std::memory_order_relaxed)};
+		while (!node->records.compare_exchange_weak(recordNode->next, recordNode, std::memory_order_release, std::memory_order_relaxed));
+		return;
+	}
+	
+	for (int child=0; child<8; ++child)
+	{
+		double childMin[3], childMax[3];
+		bool overlaps = true;
+		for (int j=0; j<3; ++j)
+		{
+			double middle = 0.5 * (nodeMin[j] + nodeMax[j]);
+			childMin[j] = (child & (1 << j)) ? middle : nodeMin[j];
+			childMax[j] = (child & (1 << j)) ? nodeMax[j] : middle;
+			overlaps = overlaps && (recordMin[j] <= childMax[j]) && (recordMax[j] >= childMin[j]);
+		}
+		
+		if (overlaps)
+			InsertIntoNode(GetOrCreateChild(node, child), childMin, childMax, record, recordMin, recordMax, depth + 1);
+	}
+}
+
+// Function to return the child of a node.
+qbRT::IrradianceCache::Node *qbRT::IrradianceCache::GetOrCreateChild(Node *node, int child)
+{
+	Node *existing = node->children[child].load(std::memory_order_acquire);
+	if (existing)
+		return existing;
+		
+	// If another thread creates the child first, use theirs and discard this one.
+	Node *created = new Node();
+	if (node->children[child].compare_exchange_strong(existing, created, std::memory_order_acq_rel, std::memory_order_acquire))
+		return created;
+		
+	delete created;
+	return existing;
+}
+
+// Function to add the interpolation weights of the records in a list.
+void qbRT::IrradianceCache::AccumulateRecords(const RecordNode *recordNode, const double *point, const double *normal, double *sum, double &weightSum) const
+{
+	for (; recordNode; recordNode = recordNode->next)
+	{
+		const Record &record = recordNode->record;
+		double offset[3];
+		double distance2 = 0.0;
+		double normalDot = 0.0;
+		double averageNormalDot = 0.0;
+		for (int j=0; j<3; ++j)
+		{
+			offset[j] = point[j] - record.position[j];
+			distance2 += offset[j] * offset[j];
+			normalDot += normal[j] * record.normal[j];
+			averageNormalDot += offset[j] * 0.5 * (normal[j] + record.normal[j]);
+		}
+		
+		// Ward's estimate of the error in using the record here.
+		double error = (sqrt(distance2) / record.radius) + sqrt(std::max(0.0, 1.0 - normalDot));
+		if (error >= m_accuracy)
+			continue;
+			
+		// Do not use records from surfaces in front of the point, as they see light that it cannot.
+		if (averageNormalDot < (-0.05 * record.radius))
+			continue;
+			
+		// Extrapolate the record to the point with its gradients.
+		double rotation[3] = {	(record.normal[1] * normal[2]) - (record.normal[2] * normal[1]),
+														(record.normal[2] * normal[0]) - (record.normal[0] * normal[2]),
+														(record.normal[0] * normal[1]) - (record.normal[1] * normal[0])};
+		double weight = (1.0 / std::max(error, 1e-9)) - (1.0 / m_accuracy);
+		for (int c=0; c<3; ++c)
+		{
+			double value = record.irradiance[c];
+			for (int a=0; a<3; ++a)
+				value += (rotation[a] * record.rotationalGradient[c][a]) + (offset[a] * record.translationalGradient[c][a]);
+			sum[c] += weight * value;
+		}
+		weightSum += weight;
+	}
+}
+
+// Function to free a node and everything below it.
+void qbRT::IrradianceCache::DeleteNode(Node *node)
+{
+	if (!node)
+		return;
+		
+	for (int i=0; i<8; ++i)
+		DeleteNode(node->children[i].load());
+		
+	RecordNode *recordNode = node->records.load();
+	while (recordNode)
+	{
+		RecordNode *next = recordNode->next;
+		delete recordNode;
+		recordNode = next;
+	}
+	
+	delete node;
+}
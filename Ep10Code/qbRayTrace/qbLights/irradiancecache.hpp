@@ -0,0 +1,147 @@
+/* ***********************************************************
+	irradiancecache.hpp
+	
+	The IrradianceCache class definition - A sparse set of records
+	of the diffuse light arriving at points in the scene, each with
+	its gradients, held in an octree. The light at other points
+	nearby is interpolated from the records, so that the expensive
+	hemisphere of rays needed for indirect lighting is only traced
+	at a small fraction of the points that are shaded. Records are
+	added as they are needed, and may be added and looked up from
+	several threads at once without locking.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef IRRADIANCECACHE_H
+#define IRRADIANCECACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include "../qbLinAlg/qbVector.h"
+
+namespace qbRT
+{
+	class IrradianceCache
+	{
+		public:
+			/* A record of the light arriving at a point. The irradiance is divided by pi,
+				so that it is the radiance of a uniform environment that would give the same
+				lighting, and so are the gradients. The gradients are stored for each of the
+				three color channels. */
+			struct Record
+			{
+				double position[3];
+				double normal[3];
+				double irradiance[3];
+				double radius;
+				double rotationalGradient[3][3];
+				double translationalGradient[3][3];
+			};
+			
+			/* The function used to trace rays for a new record. Given a direction, it
+				returns the radiance arriving along it and the distance to the surface that
+				it came from, or returns false if the ray escaped the scene. */
+			typedef std::function<bool(const qbVector<double> &direction, double *rgb, double &distance)> TraceFunction;
+			
+		public:
+			/* Constructor / destructor. Records are held in an octree over the given
+				bounds; any that reach outside them are still found, but more slowly. */
+			IrradianceCache();
+			IrradianceCache(const qbVector<double> &boundsMin, const qbVector<double> &boundsMax);
+			~IrradianceCache();
+			
+			// The cache owns its octree, and so is not copyable.
+			IrradianceCache(const IrradianceCache &) = delete;
+			IrradianceCache &operator=(const IrradianceCache &) = delete;
+			
+			/* Function to interpolate the light arriving at a point from the records
+				nearby. Returns false, leaving rgb untouched, if no record is close
+				enough in both position and orientation. */
+			bool Lookup(const qbVector<double> &point, const qbVector<double> &normal, double *rgb) const;
+			
+			/* Function to compute a new record, tracing m_numThetaSamples by
+				m_numPhiSamples stratified rays over the cosine-weighted hemisphere. */
+			void ComputeRecord(	const qbVector<double> &point, const qbVector<double> &normal,
+													const TraceFunction &traceRay, Record &record) const;
+													
+			// Function to add a record. This may be called while other threads are adding or looking up records.
+			void Insert(const Record &record);
+			
+			/* Function to remove every record. This must not be called while any other
+				thread is using the cache. */
+			void Clear();
+			
+			// Functions to return the number of records and the lookup statistics.
+			int GetNumRecords() const;
+			uint64_t GetHits() const;
+			uint64_t GetMisses() const;
+			
+		public:
+			/* The largest error allowed when interpolating. Smaller values give more
+				records, each used over a smaller region. */
+			double m_accuracy = 0.25;
+			
+			// Limits on the radius of each record, in scene units.
+			double m_minSpacing = 0.05;
+			double m_maxSpacing = 2.0;
+			
+			// The number of rays traced for each record.
+			int m_numThetaSamples = 8;
+			int m_numPhiSamples = 24;
+			
+		private:
+			// A record in the list held by a node.
+			struct RecordNode
+			{
+				Record record;
+				RecordNode *next;
+			};
+			
+			// A node of the octree. Children and records are only ever added, with compare and swap.
+			struct Node
+			{
+				std::atomic<Node *> children[8];
+				std::atomic<RecordNode *> records;
+				Node();
+			};
+			
+		private:
+			// Function to add a record to a node, or to those of its children that it overlaps.
+			void InsertIntoNode(Node *node, const double *nodeMin, const double *nodeMax, const Record &record, const double *recordMin, const double *recordMax, int depth);
+			
+			// Function to return the child of a node, creating it if it does not exist yet.
+			Node *GetOrCreateChild(Node *node, int child);
+			
+			// Function to add the interpolation weights of the records in a list.
+			void AccumulateRecords(const RecordNode *recordNode, const double *point, const double *normal, double *sum, double &weightSum) const;
+			
+			// Function to free a node and everything below it.
+			static void DeleteNode(Node *node);
+			
+		private:
+			double m_boundsMin[3];
+			double m_boundsMax[3];
+			Node *m_root;
+			
+			// The depth beyond which the octree is not divided further.
+			static const int m_maxDepth = 24;
+			
+			std::atomic<int> m_numRecords {0};
+			mutable std::atomic<uint64_t> m_hits {0};
+			mutable std::atomic<uint64_t> m_misses {0};
+	};
+}
+
+#endif
@@ -22,17 +22,65 @@
 ***********************************************************/
 
 #include "lightbase.hpp"
+#include <mutex>
+
+/* The light IDs given up by destroyed lights, to be handed out again before any
+	new ones, so that the IDs, and so the occluder caches, stay as small as the
+	largest number of lights alive at once. A reused ID may find the occluder of
+	the light that held it before, but that is only ever a guess to test first. */
+static std::mutex g_lightIDMutex;
+static std::vector<int> g_freeLightIDs;
+static int g_nextLightID = 0;
+
+/* For each light ID, the position in the object list of the object that last
+	blocked that light on this thread, or -1 if there is none. */
+static thread_local std::vector<int> t_lastOccluder;
+
+// Function to hand out a light ID.
+static int AcquireLightID()
+{
+	std::lock_guard<std::mutex> lock (g_lightIDMutex);
+	if (g_freeLightIDs.empty())
+		return g_nextLightID++;
+		
+	int lightID = g_freeLightIDs.back();
+	g_freeLightIDs.pop_back();
+	return lightID;
+}
+
+// Function to give up a light ID.
+static void ReleaseLightID(int lightID)
+{
+	std::lock_guard<std::mutex> lock (g_lightIDMutex);
+	g_freeLightIDs.push_back(lightID);
+}
 
 // Constructor.
 qbRT::LightBase::LightBase()
 {
+	m_lightID = AcquireLightID();
+}
+
+// Copy constructor / assignment.
+qbRT::LightBase::LightBase(const LightBase &other)
+	: m_color(other.m_color), m_location(other.m_location), m_intensity(other.m_intensity), m_radius(other.m_radius)
+{
+	m_lightID = AcquireLightID();
+}
 
+qbRT::LightBase &qbRT::LightBase::operator=(const LightBase &other)
+{
+	m_color = other.m_color;
+	m_location = other.m_location;
+	m_intensity = other.m_intensity;
+	m_radius = other.m_radius;
+	return *this;
 }
 
 // Destructor.
 qbRT::LightBase::~LightBase()
 {
-
+	ReleaseLightID(m_lightID);
 }
 
 // Function to compute illumination.
@@ -43,3 +91,116 @@ bool qbRT::LightBase::ComputeIllumination(	const qbVector<double> &intPoint, con
 {
 	return false;
 }
+
+// Function to return the attenuation at a given distance.
+double qbRT::LightBase::GetAttenuation(double distance) const
+{
+	if (m_radius <= 0.0)
+		return 1.0;
+		
+	// (1 - (d/r)^2)^2, which has zero slope where it reaches zero at the radius.
+	double ratio2 = (distance * distance) / (m_radius * m_radius);
+	if (ratio2 >= 1.0)
+		return 0.0;
+		
+	return (1.0 - ratio2) * (1.0 - ratio2);
+}
+
+// Function to test whether a point on a light is hidden from the intersection point.
+bool qbRT::LightBase::IsOccluded(	const qbVector<double> &intPoint, const qbVector<double> &lightPoint,
+																	const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+																	const std::shared_ptr<qbRT::ObjectBase> &currentObject)
+{
+	// Construct a ray from the point of intersection towards the light.
+	qbVector<double> lightDir = (lightPoint - intPoint).Normalized();
+	double lightDist = (lightPoint - intPoint).norm();
+	qbRT::Ray lightRay (intPoint, intPoint + lightDir);
+	
+	qbVector<double> poi				{3};
+	qbVector<double> poiNormal	{3};
+	qbVector<double> poiColor		{3};
+	
+	/* Test the object that last blocked this light first. The position is checked
+		against the object list, in case the list has changed since it was stored. */
+	if (t_lastOccluder.size() <= static_cast<std::size_t>(m_lightID))
+		t_lastOccluder.resize(m_lightID + 1, -1);
+	int lastOccluder = t_lastOccluder[m_lightID];
+	if ((lastOccluder >= 0) && (lastOccluder < static_cast<int>(objectList.size())))
+	{
+		const std::shared_ptr<qbRT::ObjectBase> &sceneObject = objectList[lastOccluder];
+		if ((sceneObject != currentObject) && (sceneObject -> TestIntersection(lightRay, poi, poiNormal, poiColor)))
+		{
+			if ((poi - intPoint).norm() <= lightDist)
+			{
+				if (m_collectOccluderStats)
+					m_occluderHits.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+	}
+	else
+	{
+		lastOccluder = -1;
+	}
+	if (m_collectOccluderStats)
+		m_occluderMisses.fetch_add(1, std::memory_order_relaxed);
+	
+	/* Check for intersections with all of the other objects in the scene, except for
+		the current one, that are closer than the light. */
+	for (int i=0; i<static_cast<int>(objectList.size()); ++i)
+	{
+		const std::shared_ptr<qbRT::ObjectBase> &sceneObject = objectList[i];
+		if ((i != lastOccluder) && (sceneObject != currentObject) && (sceneObject -> TestIntersection(lightRay, poi, poiNormal, poiColor)))
+		{
+			// As soon as one object blocks the light, there is no need to check further.
+			if ((poi - intPoint).norm() <= lightDist)
+			{
+				t_lastOccluder[m_lightID] = i;
+				return true;
+			}
+		}
+	}
+	
+	/* The last occluder is kept even when the light is visible, as the point is
+		probably just past the edge of its shadow and the next may be back in it. */
+	return false;
+}
+
+// Functions to return the occluder cache statistics.
+uint64_t qbRT::LightBase::GetOccluderCacheHits() const
+{
+	return m_occluderHits.load();
+}
+
+uint64_t qbRT::LightBase::GetOccluderCacheMisses() const
+{
+	return m_occluderMisses.load();
+}
+
+double qbRT::LightBase::GetOccluderCacheHitRate() const
+{
+	uint64_t hits = m_occluderHits.load();
+	uint64_t total = hits + m_occluderMisses.load();
+	if (total == 0)
+		return 0.0;
+		
+	return static_cast<double>(hits) / static_cast<double>(total);
+}
+
+void qbRT::LightBase::ResetOccluderCacheStats()
+{
+	m_occluderHits = 0;
+	m_occluderMisses = 0;
+}
+
+// Function to return whether the light can reach a point.
+bool qbRT::LightBase::IsInRange(double distance) const
+{
+	return (m_radius <= 0.0) || ((distance - GetExtent()) < m_radius);
+}
+
+// Function to return the size of the light.
+double qbRT::LightBase::GetExtent() const
+{
+	return 0.0;
+}
@@ -23,6 +23,8 @@
 #ifndef LIGHTBASE_H
 #define LIGHTBASE_H
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include "../qbLinAlg/qbVector.h"
 #include "../ray.hpp"
@@ -37,16 +39,66 @@ namespace qbRT
 			LightBase();
 			virtual ~LightBase();
 			
+			/* A copy of a light has the same settings, but its own ID and occluder
+				cache statistics. */
+			LightBase(const LightBase &other);
+			LightBase &operator=(const LightBase &other);
+			
 			// Function to compute illumination contribution.
 			virtual bool ComputeIllumination(	const qbVector<double> &intPoint, const qbVector<double> &localNormal,
 																				const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
 																				const std::shared_ptr<qbRT::ObjectBase> &currentObject,
 																				qbVector<double> &color, double &intensity);
 																				
+			/* Function to return the factor by which the light is attenuated at the given
+				distance. With no radius set there is no attenuation; otherwise the light
+				falls off smoothly from full strength at the light to zero at the radius. */
+			double GetAttenuation(double distance) const;
+			
+			/* Function to return whether the light can reach a point at the given distance
+				from m_location. Some part of an area light may be nearer than that, by up
+				to its extent. */
+			bool IsInRange(double distance) const;
+			
+			/* Function to return the distance from m_location to the furthest point of
+				the light, which is zero for a point light. */
+			virtual double GetExtent() const;
+			
+			/* Function to test whether any object other than the current one lies between
+				the intersection point and the given point on this light, casting a shadow.
+				Each thread remembers the object that last blocked each light and tests it
+				first, since neighbouring points are usually shadowed by the same object. */
+			bool IsOccluded(	const qbVector<double> &intPoint, const qbVector<double> &lightPoint,
+															const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+															const std::shared_ptr<qbRT::ObjectBase> &currentObject);
+															
+			/* Functions to return the number of shadow tests answered by the last occluder
+				alone, and the number that needed a search of the scene. These are only
+				counted while m_collectOccluderStats is set. */
+			uint64_t GetOccluderCacheHits() const;
+			uint64_t GetOccluderCacheMisses() const;
+			double GetOccluderCacheHitRate() const;
+			void ResetOccluderCacheStats();
+			
 		public:
 			qbVector<double>	m_color			{3};
 			qbVector<double>	m_location	{3};
 			double						m_intensity;
+			
+			// The radius beyond which the light has no effect (zero for no limit).
+			double						m_radius = 0.0;
+			
+			/* Whether to count the occluder cache hits and misses. Counting touches a
+				counter shared by every thread on each shadow test, so it is off unless the
+				statistics are wanted. */
+			inline static bool m_collectOccluderStats = false;
+			
+		private:
+			// A number unique among the lights that exist, used to find this light's entry in each thread's occluder cache.
+			int m_lightID;
+			
+			std::atomic<uint64_t> m_occluderHits {0};
+			std::atomic<uint64_t> m_occluderMisses {0};
 	};
 }
 
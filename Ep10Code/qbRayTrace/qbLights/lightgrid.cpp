@@ -0,0 +1,165 @@
+/* ***********************************************************
+	lightgrid.cpp
+	
+	The LightGrid class implementation - A uniform grid over the
+	regions that lights with a limited radius can reach, used to
+	find the lights that may affect a given point without having
+	to visit every light in the scene.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "lightgrid.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Constructor / destructor.
+qbRT::LightGrid::LightGrid()
+{
+
+}
+
+qbRT::LightGrid::~LightGrid()
+{
+
+}
+
+// Function to build the grid.
+void qbRT::LightGrid::Build(const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList, int maxCellsPerAxis)
+{
+	m_numLights = static_cast<int>(lightList.size());
+	m_unboundedLights.clear();
+	m_cellStart.clear();
+	m_cellLights.clear();
+	for (int j=0; j<3; ++j)
+		m_numCells[j] = 0;
+		
+	// Find the bounds of every sphere of influence.
+	double boundsMax[3] = {-1e300, -1e300, -1e300};
+	for (int j=0; j<3; ++j)
+		m_boundsMin[j] = 1e300;
+		
+	std::vector<int> boundedLights;
+	for (int i=0; i<m_numLights; ++i)
+	{
+		const qbRT::LightBase &light = *lightList[i];
+		if (light.m_radius <= 0.0)
+		{
+			m_unboundedLights.push_back(i);
+			continue;
+		}
+		
+		boundedLights.push_back(i);
+		double reach = light.m_radius + light.GetExtent();
+		for (int j=0; j<3; ++j)
+		{
+			m_boundsMin[j] = std::min(m_boundsMin[j], light.m_location.GetElement(j) - reach);
+			boundsMax[j] = std::max(boundsMax[j], light.m_location.GetElement(j) + reach);
+		}
+	}
+	
+	if (boundedLights.empty())
+		return;
+		
+	/* Aim for a few cells per light, of equal size along each axis, limited
+		to maxCellsPerAxis along the longest axis. */
+	double volume = 1.0;
+	double longestSide = 0.0;
+	for (int j=0; j<3; ++j)
+	{
+		volume *= boundsMax[j] - m_boundsMin[j];
+		longestSide = std::max(longestSide, boundsMax[j] - m_boundsMin[j]);
+	}
+	double cellSize = std::max(cbrt(volume / (4.0 * static_cast<double>(boundedLights.size()))), longestSide / static_cast<double>(maxCellsPerAxis));
+	for (int j=0; j<3; ++j)
+	{
+		m_numCells[j] = std::min(maxCellsPerAxis, std::max(1, static_cast<int>(ceil((boundsMax[j] - m_boundsMin[j]) / cellSize))));
+		m_invCellSize[j] = static_cast<double>(m_numCells[j]) / (boundsMax[j] - m_boundsMin[j]);
+	}
+	
+	// Count the lights in each cell, and then fill them in, so that each cell's list is contiguous.
+	int totalCells = m_numCells[0] * m_numCells[1] * m_numCells[2];
+	m_cellStart.assign(totalCells + 1, 0);
+	for (int pass=0; pass<2; ++pass)
+	{
+		std::vector<int> fillPosition;
+		if (pass == 1)
+		{
+			for (int c=0; c<totalCells; ++c)
+				m_cellStart[c + 1] += m_cellStart[c];
+			m_cellLights.resize(m_cellStart[totalCells]);
+			fillPosition.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+		}
+		
+		for (int i : boundedLights)
+		{
+			const qbRT::LightBase &light = *lightList[i];
+			int cellMin[3], cellMax[3];
+			double reach = light.m_radius + light.GetExtent();
+			for (int j=0; j<3; ++j)
+			{
+				double centre = light.m_location.GetElement(j);
+				cellMin[j] = std::max(0, static_cast<int>(floor((centre - reach - m_boundsMin[j]) * m_invCellSize[j])));
+				cellMax[j] = std::min(m_numCells[j] - 1, static_cast<int>(floor((centre + reach - m_boundsMin[j]) * m_invCellSize[j])));
+			}
+			
+			for (int z=cellMin[2]; z<=cellMax[2]; ++z)
+			{
+				for (int y=cellMin[1]; y<=cellMax[1]; ++y)
+				{
+					for (int x=cellMin[0]; x<=cellMax[0]; ++x)
+					{
+						int cell = (((z * m_numCells[1]) + y) * m_numCells[0]) + x;
+						if (pass == 0)
+							m_cellStart[cell + 1]++;
+						else
+							m_cellLights[fillPosition[cell]++] = i;
+					}
+				}
+			}
+		}
+	}
+}
+
+// Function to return the number of lights.
+int qbRT::LightGrid::GetNumLights() const
+{
+	return m_numLights;
+}
+
+// Function to return the lights listed in the cell containing a point.
+int qbRT::LightGrid::GetCellLights(const qbVector<double> &point, const int *&lightIndices) const
+{
+	lightIndices = nullptr;
+	if (m_cellStart.empty())
+		return 0;
+		
+	int cellIndex[3];
+	for (int j=0; j<3; ++j)
+	{
+		double cell = floor((point.GetElement(j) - m_boundsMin[j]) * m_invCellSize[j]);
+		if ((cell < 0.0) || (cell >= static_cast<double>(m_numCells[j])))
+			return 0;
+		cellIndex[j] = static_cast<int>(cell);
+	}
+	
+	int cell = (((cellIndex[2] * m_numCells[1]) + cellIndex[1]) * m_numCells[0]) + cellIndex[0];
+	lightIndices = m_cellLights.data() + m_cellStart[cell];
+	return m_cellStart[cell + 1] - m_cellStart[cell];
+}
+
+// Function to return the lights that have no radius.
+const std::vector<int> &qbRT::LightGrid::GetUnboundedLights() const
+{
+	return m_unboundedLights;
+}
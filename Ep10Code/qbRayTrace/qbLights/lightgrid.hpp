@@ -0,0 +1,72 @@
+/* ***********************************************************
+	lightgrid.hpp
+	
+	The LightGrid class definition - A uniform grid over the
+	regions that lights with a limited radius can reach, used to
+	find the lights that may affect a given point without having
+	to visit every light in the scene.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef LIGHTGRID_H
+#define LIGHTGRID_H
+
+#include <memory>
+#include <vector>
+#include "lightbase.hpp"
+#include "../qbLinAlg/qbVector.h"
+
+namespace qbRT
+{
+	class LightGrid
+	{
+		public:
+			// Constructor / destructor.
+			LightGrid();
+			~LightGrid();
+			
+			/* Function to build the grid over the given list of lights, with no more than
+				maxCellsPerAxis cells along each axis. Each light with a radius is listed in
+				every cell within its radius of some point on the light. */
+			void Build(const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList, int maxCellsPerAxis = 64);
+			
+			// Function to return the number of lights that the grid was built over.
+			int GetNumLights() const;
+			
+			/* Function to return the lights listed in the cell containing the given point,
+				as a pointer to their indices and a count. Points outside the grid have no
+				lights listed. */
+			int GetCellLights(const qbVector<double> &point, const int *&lightIndices) const;
+			
+			// Function to return the lights that have no radius, and so affect every point.
+			const std::vector<int> &GetUnboundedLights() const;
+			
+		private:
+			int m_numLights = 0;
+			
+			// The bounds of the grid, the number of cells along each axis and the reciprocal of the cell size.
+			double m_boundsMin[3] = {0.0, 0.0, 0.0};
+			int m_numCells[3] = {0, 0, 0};
+			double m_invCellSize[3] = {0.0, 0.0, 0.0};
+			
+			/* The lights listed in each cell. Cell i lists the lights from
+				m_cellLights[m_cellStart[i]] up to m_cellLights[m_cellStart[i + 1]]. */
+			std::vector<int> m_cellStart;
+			std::vector<int> m_cellLights;
+			
+			std::vector<int> m_unboundedLights;
+	};
+}
+
+#endif
@@ -0,0 +1,227 @@
+/* ***********************************************************
+	lighttree.cpp
+	
+	The LightTree class implementation - A bounding volume hierarchy
+	over the lights in a scene, used to choose lights at random in
+	proportion to an estimate of how much each one contributes to
+	a given point.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "lighttree.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Constructor / destructor.
+qbRT::LightTree::LightTree()
+{
+
+}
+
+qbRT::LightTree::~LightTree()
+{
+
+}
+
+// Function to build the tree.
+void qbRT::LightTree::Build(const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList)
+{
+	int numLights = static_cast<int>(lightList.size());
+	m_nodes.clear();
+	m_lightPositions.resize(static_cast<std::size_t>(numLights) * 3);
+	m_lightPowers.resize(numLights);
+	m_lightRadii.resize(numLights);
+	m_leafOfLight.assign(numLights, -1);
+	
+	// Gather the position and power of each light, taking the power as the intensity times the mean of the color.
+	for (int i=0; i<numLights; ++i)
+	{
+		const qbRT::LightBase &light = *lightList[i];
+		for (int j=0; j<3; ++j)
+			m_lightPositions[(i * 3) + j] = light.m_location.GetElement(j);
+			
+		double meanColor = (light.m_color.GetElement(0) + light.m_color.GetElement(1) + light.m_color.GetElement(2)) / 3.0;
+		m_lightPowers[i] = std::max(0.0, light.m_intensity * meanColor);
+		m_lightRadii[i] = (light.m_radius > 0.0) ? (light.m_radius + light.GetExtent()) : std::numeric_limits<double>::infinity();
+	}
+	
+	if (numLights == 0)
+		return;
+		
+	// A binary tree with one light in each leaf has 2n - 1 nodes.
+	m_nodes.reserve((2 * numLights) - 1);
+	std::vector<int> lightIndices (numLights);
+	for (int i=0; i<numLights; ++i)
+		lightIndices[i] = i;
+		
+	BuildNode(lightIndices, 0, numLights, -1);
+}
+
+// Function to return the number of lights.
+int qbRT::LightTree::GetNumLights() const
+{
+	return static_cast<int>(m_lightPowers.size());
+}
+
+// Function to choose a light for the given point.
+int qbRT::LightTree::SampleLight(const qbVector<double> &point, double u, double &pmf) const
+{
+	pmf = 0.0;
+	if (m_nodes.empty())
+		return -1;
+		
+	double p[3] = {point.GetElement(0), point.GetElement(1), point.GetElement(2)};
+	double nodePMF = 1.0;
+	int nodeIndex = 0;
+	while (m_nodes[nodeIndex].lightIndex < 0)
+	{
+		const Node &node = m_nodes[nodeIndex];
+		double leftImportance = GetImportance(m_nodes[node.left], p);
+		double rightImportance = GetImportance(m_nodes[node.right], p);
+		double totalImportance = leftImportance + rightImportance;
+		if (totalImportance <= 0.0)
+			return -1;
+			
+		/* Choose a child, and rescale u to [0,1) within the part of the range that
+			chose it, so that the same number can be used again further down. */
+		double leftProb = leftImportance / totalImportance;
+		if (u < leftProb)
+		{
+			u = u / leftProb;
+			nodePMF *= leftProb;
+			nodeIndex = node.left;
+		}
+		else
+		{
+			u = (u - leftProb) / (1.0 - leftProb);
+			nodePMF *= 1.0 - leftProb;
+			nodeIndex = node.right;
+		}
+		u = std::min(u, 1.0 - 1e-12);
+	}
+	
+	pmf = nodePMF;
+	return m_nodes[nodeIndex].lightIndex;
+}
+
+// Function to return the probability of choosing the given light.
+double qbRT::LightTree::GetLightPMF(const qbVector<double> &point, int lightIndex) const
+{
+	if ((lightIndex < 0) || (lightIndex >= GetNumLights()) || (m_leafOfLight[lightIndex] < 0))
+		return 0.0;
+		
+	// Walk up from the leaf, multiplying together the probability of each choice on the way down.
+	double p[3] = {point.GetElement(0), point.GetElement(1), point.GetElement(2)};
+	double pmf = 1.0;
+	int nodeIndex = m_leafOfLight[lightIndex];
+	while (m_nodes[nodeIndex].parent >= 0)
+	{
+		const Node &parent = m_nodes[m_nodes[nodeIndex].parent];
+		double leftImportance = GetImportance(m_nodes[parent.left], p);
+		double rightImportance = GetImportance(m_nodes[parent.right], p);
+		double totalImportance = leftImportance + rightImportance;
+		if (totalImportance <= 0.0)
+			return 0.0;
+			
+		pmf *= ((parent.left == nodeIndex) ? leftImportance : rightImportance) / totalImportance;
+		nodeIndex = m_nodes[nodeIndex].parent;
+	}
+	
+	return pmf;
+}
+
+// Function to build the node over the given range of lights.
+int qbRT::LightTree::BuildNode(std::vector<int> &lightIndices, int first, int last, int parent)
+{
+	// Add the node now, so that it comes before its children.
+	int nodeIndex = static_cast<int>(m_nodes.size());
+	m_nodes.push_back(Node());
+	Node node;
+	node.parent = parent;
+	node.left = -1;
+	node.right = -1;
+	node.lightIndex = -1;
+	node.power = 0.0;
+	node.maxRadius = 0.0;
+	for (int j=0; j<3; ++j)
+	{
+		node.boundsMin[j] = 1e300;
+		node.boundsMax[j] = -1e300;
+	}
+	
+	// Find the bounds and total power of the lights in the range.
+	for (int i=first; i<last; ++i)
+	{
+		int light = lightIndices[i];
+		for (int j=0; j<3; ++j)
+		{
+			node.boundsMin[j] = std::min(node.boundsMin[j], m_lightPositions[(light * 3) + j]);
+			node.boundsMax[j] = std::max(node.boundsMax[j], m_lightPositions[(light * 3) + j]);
+		}
+		node.power += m_lightPowers[light];
+		node.maxRadius = std::max(node.maxRadius, m_lightRadii[light]);
+	}
+	
+	if ((last - first) == 1)
+	{
+		// A leaf.
+		node.lightIndex = lightIndices[first];
+		m_leafOfLight[node.lightIndex] = nodeIndex;
+	}
+	else
+	{
+		// Split at the median along the longest side of the bounds.
+		int axis = 0;
+		for (int j=1; j<3; ++j)
+		{
+			if ((node.boundsMax[j] - node.boundsMin[j]) > (node.boundsMax[axis] - node.boundsMin[axis]))
+				axis = j;
+		}
+		
+		int middle = first + ((last - first) / 2);
+		std::nth_element(lightIndices.begin() + first, lightIndices.begin() + middle, lightIndices.begin() + last,
+											[this, axis](int a, int b) {return m_lightPositions[(a * 3) + axis] < m_lightPositions[(b * 3) + axis];});
+											
+		node.left = BuildNode(lightIndices, first, middle, nodeIndex);
+		node.right = BuildNode(lightIndices, middle, last, nodeIndex);
+	}
+	
+	m_nodes[nodeIndex] = node;
+	return nodeIndex;
+}
+
+// Function to return the importance of a node to a point.
+double qbRT::LightTree::GetImportance(const Node &node, const double *point) const
+{
+	double distance2 = 0.0;
+	double radius2 = 0.0;
+	double boxDistance2 = 0.0;
+	for (int j=0; j<3; ++j)
+	{
+		double centre = 0.5 * (node.boundsMin[j] + node.boundsMax[j]);
+		double halfSize = 0.5 * (node.boundsMax[j] - node.boundsMin[j]);
+		distance2 += (point[j] - centre) * (point[j] - centre);
+		radius2 += halfSize * halfSize;
+		
+		double outside = std::max(std::max(node.boundsMin[j] - point[j], point[j] - node.boundsMax[j]), 0.0);
+		boxDistance2 += outside * outside;
+	}
+	
+	// No light in the node can reach a point that is further from its bounds than the largest radius.
+	if (boxDistance2 >= (node.maxRadius * node.maxRadius))
+		return 0.0;
+		
+	return node.power / std::max(std::max(distance2, radius2), 1e-6);
+}
@@ -0,0 +1,90 @@
+/* ***********************************************************
+	lighttree.hpp
+	
+	The LightTree class definition - A bounding volume hierarchy
+	over the lights in a scene, used to choose lights at random in
+	proportion to an estimate of how much each one contributes to
+	a given point.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef LIGHTTREE_H
+#define LIGHTTREE_H
+
+#include <memory>
+#include <vector>
+#include "lightbase.hpp"
+#include "../qbLinAlg/qbVector.h"
+
+namespace qbRT
+{
+	class LightTree
+	{
+		public:
+			// Constructor / destructor.
+			LightTree();
+			~LightTree();
+			
+			// Function to build the tree over the given list of lights.
+			void Build(const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList);
+			
+			// Function to return the number of lights that the tree was built over.
+			int GetNumLights() const;
+			
+			/* Function to choose a light for the given point, walking down the tree and
+				picking each child in proportion to its importance, using the random number
+				u in [0,1). Returns the index of the light in the list that the tree was built
+				over, and the probability of choosing it in pmf, or -1 if there is no light
+				that could contribute. */
+			int SampleLight(const qbVector<double> &point, double u, double &pmf) const;
+			
+			// Function to return the probability that SampleLight chooses the given light for the given point.
+			double GetLightPMF(const qbVector<double> &point, int lightIndex) const;
+			
+		private:
+			// A node of the tree. Leaves hold a single light.
+			struct Node
+			{
+				double boundsMin[3];
+				double boundsMax[3];
+				double power;
+				double maxRadius;
+				int parent;
+				int left;
+				int right;
+				int lightIndex;
+			};
+			
+			// Function to build the node over the given range of lights, returning its index.
+			int BuildNode(std::vector<int> &lightIndices, int first, int last, int parent);
+			
+			/* Function to return the importance of a node to a point: its power divided by
+				the squared distance to its centre, which is not allowed to fall below the
+				squared radius of the node so that points inside it do not favour it unduly.
+				Nodes whose lights all have a radius that falls short of the point have no
+				importance, so those lights are never chosen. */
+			double GetImportance(const Node &node, const double *point) const;
+			
+		private:
+			std::vector<Node> m_nodes;
+			
+			// The position, power and reach (radius plus extent, or infinite if no radius) of each light, and the leaf that holds it.
+			std::vector<double> m_lightPositions;
+			std::vector<double> m_lightPowers;
+			std::vector<double> m_lightRadii;
+			std::vector<int> m_leafOfLight;
+	};
+}
+
+#endif
@@ -0,0 +1,404 @@
+/* ***********************************************************
+	photonmap.cpp
+	
+	The PhotonMap class implementation - A map of the light that reaches
+	diffuse surfaces after being reflected or refracted by specular
+	ones, such as the bright patterns focused by a glass sphere.
+	Tracing backwards from the camera to a point light can never find
+	these paths, so photons are traced forwards from the lights in a
+	pass before rendering, and the light at each shaded point is then
+	estimated from the density of the photons nearest to it.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "photonmap.hpp"
+#include "arealight.hpp"
+#include "../qbMaterials/materialbase.hpp"
+#include "../threadpool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <future>
+
+// Constructor / destructor.
+qbRT::PhotonMap::PhotonMap()
+{
+
+}
+
+qbRT::PhotonMap::~PhotonMap()
+{
+
+}
+
+// Function to trace the photons and build the map.
+void qbRT::PhotonMap::Build(	const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+															const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList)
+{
+	m_photons.clear();
+	m_isBuilt = true;
+	
+	// Find a bounding sphere around each object that can scatter photons specularly.
+	std::vector<qbVector<double>> targetCentres;
+	std::vector<double> targetRadii;
+	for (auto &object : objectList)
+	{
+		if (!object->m_hasMaterial || (object->m_pMaterial->GetSpecularProbability() <= 0.0))
+			continue;
+			
+		qbVector<double> centre {3};
+		double radius;
+		object->GetBoundingSphere(centre, radius);
+		targetCentres.push_back(centre);
+		targetRadii.push_back(radius);
+	}
+	
+	if (targetCentres.empty() || lightList.empty() || (m_numPhotons <= 0))
+		return;
+		
+	/* Trace the photons for each light in blocks, one block per task. Each block has
+		its own generator, seeded from its position, so that the map is the same however
+		the tasks are scheduled. The tracing only reads the objects, as the intersection
+		tests return the (u,v) coordinates rather than storing them on the objects. */
+	const int blockSize = 4096;
+	int photonsPerLight = std::max(1, m_numPhotons / static_cast<int>(lightList.size()));
+	std::vector<std::vector<Photon>> blockPhotons;
+	std::vector<std::future<void>> tasks;
+	int numBlocks = (photonsPerLight + blockSize - 1) / blockSize;
+	blockPhotons.resize(lightList.size() * numBlocks);
+	for (std::size_t i=0; i<lightList.size(); ++i)
+	{
+		for (int block=0; block<numBlocks; ++block)
+		{
+			int numPhotons = std::min(blockSize, photonsPerLight - (block * blockSize));
+			std::vector<Photon> *output = &blockPhotons[(i * numBlocks) + block];
+			qbRT::LightBase *light = lightList[i].get();
+			unsigned int seed = static_cast<unsigned int>((i * 7919) + block + 1);
+			tasks.push_back(qbRT::ThreadPool::GetShared().Submit([this, &objectList, light, &targetCentres, &targetRadii, numPhotons, photonsPerLight, seed, output]()
+			{
+				std::mt19937 generator (seed);
+				TracePhotons(objectList, *light, targetCentres, targetRadii, numPhotons, photonsPerLight, generator, *output);
+			}));
+		}
+	}
+	
+	for (auto &task : tasks)
+		task.get();
+		
+	// Merge the blocks in order.
+	std::size_t totalStored = 0;
+	for (auto &photons : blockPhotons)
+		totalStored += photons.size();
+	m_photons.reserve(totalStored);
+	for (auto &photons : blockPhotons)
+		m_photons.insert(m_photons.end(), photons.begin(), photons.end());
+		
+	BuildTree(0, static_cast<int>(m_photons.size()));
+}
+
+// Function to discard the photons.
+void qbRT::PhotonMap::Clear()
+{
+	m_photons.clear();
+	m_isBuilt = false;
+}
+
+// Function to return whether the map has been built.
+bool qbRT::PhotonMap::IsBuilt() const
+{
+	return m_isBuilt;
+}
+
+// Function to return the number of photons stored.
+int qbRT::PhotonMap::GetNumPhotons() const
+{
+	return static_cast<int>(m_photons.size());
+}
+
+// Function to find the nearest photons.
+void qbRT::PhotonMap::GatherNearest(const double *point, int k, double maxDistance2, std::vector<std::pair<double, int>> &nearest) const
+{
+	nearest.clear();
+	if (m_photons.empty() || (k <= 0))
+		return;
+		
+	/* Walk the tree with a stack of ranges still to visit, each with the squared
+		distance to the plane that separates it from the point. The nearer side of
+		each split is visited first, and a far side is skipped if, by the time it is
+		reached, k photons closer than its plane have been found. */
+	struct Range
+	{
+		int first;
+		int last;
+		double planeDistance2;
+	};
+	Range stack[128];
+	int stackSize = 0;
+	stack[stackSize++] = {0, static_cast<int>(m_photons.size()), 0.0};
+	while (stackSize > 0)
+	{
+		Range range = stack[--stackSize];
+		if ((range.first >= range.last) || (range.planeDistance2 > maxDistance2))
+			continue;
+			
+		int middle = range.first + ((range.last - range.first) / 2);
+		const Photon &photon = m_photons[middle];
+		double distance2 = 0.0;
+		for (int j=0; j<3; ++j)
+			distance2 += (point[j] - photon.position[j]) * (point[j] - photon.position[j]);
+			
+		// Keep the k nearest in a max-heap, so that the furthest of them can be replaced.
+		if (distance2 < maxDistance2)
+		{
+			if (static_cast<int>(nearest.size()) < k)
+			{
+				nearest.push_back({distance2, middle});
+				std::push_heap(nearest.begin(), nearest.end());
+			}
+			else
+			{
+				std::pop_heap(nearest.begin(), nearest.end());
+				nearest.back() = {distance2, middle};
+				std::push_heap(nearest.begin(), nearest.end());
+			}
+			
+			if (static_cast<int>(nearest.size()) == k)
+				maxDistance2 = nearest.front().first;
+		}
+		
+		if ((range.last - range.first) == 1)
+			continue;
+			
+		double delta = point[photon.axis] - photon.position[photon.axis];
+		Range lower = {range.first, middle, 0.0};
+		Range upper = {middle + 1, range.last, 0.0};
+		if (delta < 0.0)
+		{
+			upper.planeDistance2 = delta * delta;
+			stack[stackSize++] = upper;
+			stack[stackSize++] = lower;
+		}
+		else
+		{
+			lower.planeDistance2 = delta * delta;
+			stack[stackSize++] = lower;
+			stack[stackSize++] = upper;
+		}
+	}
+}
+
+// Function to estimate the irradiance at a point.
+void qbRT::PhotonMap::EstimateIrradiance(const qbVector<double> &point, const qbVector<double> &normal, double *rgb) const
+{
+	for (int c=0; c<3; ++c)
+		rgb[c] = 0.0;
+		
+	double p[3] = {point.GetElement(0), point.GetElement(1), point.GetElement(2)};
+	double n[3] = {normal.GetElement(0), normal.GetElement(1), normal.GetElement(2)};
+	thread_local std::vector<std::pair<double, int>> nearest;
+	GatherNearest(p, m_gatherCount, m_maxGatherRadius * m_maxGatherRadius, nearest);
+	if (nearest.empty())
+		return;
+		
+	double radius2 = 0.0;
+	for (auto &found : nearest)
+		radius2 = std::max(radius2, found.first);
+	double radius = sqrt(radius2);
+	if (radius <= 0.0)
+		return;
+		
+	for (auto &found : nearest)
+	{
+		const Photon &photon = m_photons[found.second];
+		
+		/* Ignore photons that arrived from behind the surface, or that lie well off
+			its plane, as they belong to a different surface. */
+		double arrival = 0.0;
+		double height = 0.0;
+		for (int j=0; j<3; ++j)
+		{
+			arrival += photon.direction[j] * n[j];
+			height += (photon.position[j] - p[j]) * n[j];
+		}
+		if ((arrival >= 0.0) || (std::abs(height) > (0.25 * radius)))
+			continue;
+			
+		double weight = 1.0 - (sqrt(found.first) / radius);
+		for (int c=0; c<3; ++c)
+			rgb[c] += weight * photon.power[c];
+	}
+	
+	// The cone filter integrates to a third of the area of the disk.
+	double area = M_PI * radius2 / 3.0;
+	for (int c=0; c<3; ++c)
+		rgb[c] /= area;
+}
+
+// Function to trace the photons from one light.
+void qbRT::PhotonMap::TracePhotons(	const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+																		qbRT::LightBase &light, const std::vector<qbVector<double>> &targetCentres,
+																		const std::vector<double> &targetRadii, int numPhotons, int totalPhotons,
+																		std::mt19937 &generator, std::vector<Photon> &photons) const
+{
+	std::uniform_real_distribution<double> uniform (0.0, 1.0);
+	int numTargets = static_cast<int>(targetCentres.size());
+	qbRT::AreaLight *areaLight = dynamic_cast<qbRT::AreaLight *>(&light);
+	std::vector<qbVector<double>> axes (numTargets, qbVector<double>{3});
+	std::vector<double> cosMax (numTargets, 0.0);
+	
+	for (int i=0; i<numPhotons; ++i)
+	{
+		// Choose one of the targets, and a point on the light to send the photon from.
+		int target = std::min(static_cast<int>(uniform(generator) * numTargets), numTargets - 1);
+		qbVector<double> origin = light.m_location;
+		if (areaLight)
+			origin = areaLight->SamplePoint(uniform(generator), uniform(generator), targetCentres[target]);
+			
+		/* Find the cone of directions around each target. A target around the light
+			has no cone, and is covered by sending photons over the whole sphere. */
+		for (int t=0; t<numTargets; ++t)
+		{
+			axes[t] = targetCentres[t] - origin;
+			double distance = axes[t].norm();
+			if (distance <= targetRadii[t])
+			{
+				cosMax[t] = -1.0;
+				continue;
+			}
+			axes[t] = axes[t] * (1.0 / distance);
+			cosMax[t] = sqrt(1.0 - ((targetRadii[t] * targetRadii[t]) / (distance * distance)));
+		}
+		
+		/* Choose a direction within the cone around the chosen target. The probability
+			density of the direction is the average over the targets of the density with
+			which each of them would choose it. */
+		double u1 = uniform(generator);
+		double u2 = uniform(generator);
+		double phi = 2.0 * M_PI * u2;
+		qbVector<double> direction {3};
+		if (cosMax[target] < 0.0)
+		{
+			double z = 1.0 - (2.0 * u1);
+			double r = sqrt(std::max(0.0, 1.0 - (z * z)));
+			direction = qbVector<double>{std::vector<double> {r * cos(phi), r * sin(phi), z}};
+		}
+		else
+		{
+			const qbVector<double> &w = axes[target];
+			qbVector<double> helper {std::vector<double> {1.0, 0.0, 0.0}};
+			if (std::abs(w.GetElement(0)) > 0.9)
+				helper = qbVector<double>{std::vector<double> {0.0, 1.0, 0.0}};
+			qbVector<double> tangent = qbVector<double>::cross(w, helper);
+			tangent.Normalize();
+			qbVector<double> bitangent = qbVector<double>::cross(w, tangent);
+			
+			double cosTheta = 1.0 - (u1 * (1.0 - cosMax[target]));
+			double sinTheta = sqrt(std::max(0.0, 1.0 - (cosTheta * cosTheta)));
+			direction = (tangent * (sinTheta * cos(phi))) + (bitangent * (sinTheta * sin(phi))) + (w * cosTheta);
+		}
+		
+		double pdf = 0.0;
+		for (int t=0; t<numTargets; ++t)
+		{
+			if (cosMax[t] < 0.0)
+				pdf += 1.0 / (4.0 * M_PI);
+			else if (qbVector<double>::dot(direction, axes[t]) >= cosMax[t])
+				pdf += 1.0 / (2.0 * M_PI * std::max(1.0 - cosMax[t], 1e-12));
+		}
+		pdf /= static_cast<double>(numTargets);
+		
+		if (pdf <= 0.0)
+			continue;
+			
+		// Each photon carries its share of the light's power over every direction.
+		double power[3];
+		for (int c=0; c<3; ++c)
+			power[c] = light.m_color.GetElement(c) * light.m_intensity / (static_cast<double>(totalPhotons) * pdf);
+			
+		// Follow the photon through specular bounces, storing it wherever it lands on a diffuse surface after one.
+		qbRT::Ray ray (origin, origin + direction);
+		std::shared_ptr<qbRT::ObjectBase> lastObject;
+		bool specularBounce = false;
+		for (int bounce=0; bounce<=m_maxBounces; ++bounce)
+		{
+			std::shared_ptr<qbRT::ObjectBase> hitObject;
+			qbVector<double> hitPoint		{3};
+			qbVector<double> hitNormal	{3};
+			qbVector<double> hitColor		{3};
+			qbVector<double> hitUV			{2};
+			if (!qbRT::MaterialBase::CastRay(ray, objectList, lastObject, hitObject, hitPoint, hitNormal, hitColor, hitUV))
+				break;
+				
+			/* Only surfaces with some diffuse reflection store photons; a purely specular one
+				shows the light that it passes on through its reflection or refraction instead.
+				Objects without a material are diffuse. */
+			bool isDiffuse = !hitObject->m_hasMaterial || (hitObject->m_pMaterial->GetSpecularProbability() < 1.0);
+			if (specularBounce && isDiffuse)
+			{
+				Photon photon;
+				qbVector<double> arrival = ray.m_lab;
+				arrival.Normalize();
+				for (int j=0; j<3; ++j)
+				{
+					photon.position[j] = static_cast<float>(hitPoint.GetElement(j));
+					photon.power[j] = static_cast<float>(power[j]);
+					photon.direction[j] = static_cast<float>(arrival.GetElement(j));
+				}
+				photon.axis = 0;
+				photons.push_back(photon);
+			}
+			
+			qbRT::Ray scatteredRay;
+			if (!hitObject->m_hasMaterial || !hitObject->m_pMaterial->ScatterPhoton(hitObject, hitPoint, hitNormal, ray, uniform(generator), scatteredRay))
+				break;
+				
+			specularBounce = true;
+			ray = scatteredRay;
+			lastObject = hitObject;
+		}
+	}
+}
+
+// Function to arrange the photons into a kd-tree.
+void qbRT::PhotonMap::BuildTree(int first, int last)
+{
+	if ((last - first) <= 1)
+		return;
+		
+	// Split at the median along the longest side of the bounds of the range.
+	float boundsMin[3] = {1e30f, 1e30f, 1e30f};
+	float boundsMax[3] = {-1e30f, -1e30f, -1e30f};
+	for (int i=first; i<last; ++i)
+	{
+		for (int j=0; j<3; ++j)
+		{
+			boundsMin[j] = std::min(boundsMin[j], m_photons[i].position[j]);
+			boundsMax[j] = std::max(boundsMax[j], m_photons[i].position[j]);
+		}
+	}
+	
+	int axis = 0;
+	for (int j=1; j<3; ++j)
+	{
+		if ((boundsMax[j] - boundsMin[j]) > (boundsMax[axis] - boundsMin[axis]))
+			axis = j;
+	}
+	
+	int middle = first + ((last - first) / 2);
+	std::nth_element(m_photons.begin() + first, m_photons.begin() + middle, m_photons.begin() + last,
+										[axis](const Photon &a, const Photon &b) {return a.position[axis] < b.position[axis];});
+	m_photons[middle].axis = axis;
+	
+	BuildTree(first, middle);
+	BuildTree(middle + 1, last);
+}
@@ -0,0 +1,111 @@
+/* ***********************************************************
+	photonmap.hpp
+	
+	The PhotonMap class definition - A map of the light that reaches
+	diffuse surfaces after being reflected or refracted by specular
+	ones, such as the bright patterns focused by a glass sphere.
+	Tracing backwards from the camera to a point light can never find
+	these paths, so photons are traced forwards from the lights in a
+	pass before rendering, and the light at each shaded point is then
+	estimated from the density of the photons nearest to it.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef PHOTONMAP_H
+#define PHOTONMAP_H
+
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+#include "lightbase.hpp"
+#include "../qbLinAlg/qbVector.h"
+#include "../qbPrimatives/objectbase.hpp"
+
+namespace qbRT
+{
+	class PhotonMap
+	{
+		public:
+			/* A photon stored where it landed, with its power and the direction it arrived
+				along. The photons are held in a single array in the order of a balanced
+				kd-tree: the photon at the middle of any range splits the rest of that range
+				along the given axis. */
+			struct Photon
+			{
+				float position[3];
+				float power[3];
+				float direction[3];
+				int axis;
+			};
+			
+		public:
+			// Constructor / destructor.
+			PhotonMap();
+			~PhotonMap();
+			
+			/* Function to trace m_numPhotons photons from the lights, shared equally
+				between them, and build the kd-tree over those that land on a diffuse
+				surface after at least one specular bounce. Photons are only sent towards
+				objects whose materials can scatter them specularly. The photons are traced
+				on the shared thread pool. */
+			void Build(	const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+									const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList);
+									
+			// Function to discard the photons, so that the map will be built again.
+			void Clear();
+			
+			// Function to return whether the map has been built.
+			bool IsBuilt() const;
+			
+			// Function to return the number of photons stored.
+			int GetNumPhotons() const;
+			
+			/* Function to find the k photons nearest to a point, within the given squared
+				distance. They are returned as pairs of squared distance and photon index,
+				in no particular order. */
+			void GatherNearest(const double *point, int k, double maxDistance2, std::vector<std::pair<double, int>> &nearest) const;
+			
+			/* Function to estimate the irradiance at a point on a surface from the
+				m_gatherCount nearest photons, with a cone filter to keep the edges of the
+				caustics sharp. Photons that arrived from behind the surface are ignored. */
+			void EstimateIrradiance(const qbVector<double> &point, const qbVector<double> &normal, double *rgb) const;
+			
+		public:
+			// The number of photons to trace, and the most specular bounces to follow.
+			int m_numPhotons = 100000;
+			int m_maxBounces = 8;
+			
+			// The number of photons used for each estimate, and the furthest that they may be from the point.
+			int m_gatherCount = 50;
+			double m_maxGatherRadius = 0.25;
+			
+		private:
+			/* Function to trace photons from one light, with their power divided between
+				totalPhotons, adding those that are stored to the list. */
+			void TracePhotons(	const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+													qbRT::LightBase &light, const std::vector<qbVector<double>> &targetCentres,
+													const std::vector<double> &targetRadii, int numPhotons, int totalPhotons,
+													std::mt19937 &generator, std::vector<Photon> &photons) const;
+													
+			// Function to arrange a range of the photons into a balanced kd-tree, in place.
+			void BuildTree(int first, int last);
+			
+		private:
+			std::vector<Photon> m_photons;
+			bool m_isBuilt = false;
+	};
+}
+
+#endif
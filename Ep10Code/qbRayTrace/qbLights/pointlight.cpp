@@ -47,38 +47,18 @@ bool qbRT::PointLight::ComputeIllumination(	const qbVector<double> &intPoint, co
 	qbVector<double> lightDir = (m_location - intPoint).Normalized();
 	double lightDist = (m_location - intPoint).norm();
 	
-	// Compute a starting point.
-	qbVector<double> startPoint = intPoint;
-	
-	// Construct a ray from the point of intersection to the light.
-	qbRT::Ray lightRay (startPoint, startPoint + lightDir);
-	
-	/* Check for intersections with all of the objects
-		in the scene, except for the current one. */
-	qbVector<double> poi				{3};
-	qbVector<double> poiNormal	{3};
-	qbVector<double> poiColor		{3};
-	bool validInt = false;
-	for (auto sceneObject : objectList)
+	// If the point is out of range, then there is no need for a shadow ray.
+	if (!IsInRange(lightDist))
 	{
-		if (sceneObject != currentObject)
-		{
-			validInt = sceneObject -> TestIntersection(lightRay, poi, poiNormal, poiColor);
-			if (validInt)
-			{
-				double dist = (poi - startPoint).norm();
-				if (dist > lightDist)
-					validInt = false;
-			}
-		}
-		
-		/* If we have an intersection, then there is no point checking further
-			so we can break out of the loop. In other words, this object is
-			blocking light from this light source. */
-		if (validInt)
-			break;
+		color = m_color;
+		intensity = 0.0;
+		return false;
 	}
-
+	
+	/* Check whether any of the other objects in the scene are casting
+		a shadow from this light source. */
+	bool validInt = IsOccluded(intPoint, m_location, objectList, currentObject);
+	
 	/* Only continue to compute illumination if the light ray didn't
 		intersect with any objects in the scene. Ie. no objects are
 		casting a shadow from this light source. */
@@ -100,7 +80,7 @@ bool qbRT::PointLight::ComputeIllumination(	const qbVector<double> &intPoint, co
 		{
 			// We do have illumination.
 			color = m_color;
-			intensity = m_intensity * (1.0 - (angle / 1.5708));
+			intensity = m_intensity * (1.0 - (angle / 1.5708)) * GetAttenuation(lightDist);
 			return true;
 		}
 	}
@@ -0,0 +1,56 @@
+/* ***********************************************************
+	rectlight.cpp
+	
+	The RectLight class implementation - A rectangular area light, centred on m_location
+	and spanning m_halfU and m_halfV either side of it.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "rectlight.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Constructor / destructor.
+qbRT::RectLight::RectLight()
+{
+
+}
+
+qbRT::RectLight::~RectLight()
+{
+
+}
+
+// Function to return a point on the light.
+qbVector<double> qbRT::RectLight::SamplePoint(double u1, double u2, const qbVector<double> &)
+{
+	// Map [0,1) x [0,1) across the rectangle.
+	return m_location + (m_halfU * ((2.0 * u1) - 1.0)) + (m_halfV * ((2.0 * u2) - 1.0));
+}
+
+// Function to return the size of the light.
+double qbRT::RectLight::GetExtent() const
+{
+	// The furthest points are the corners at the ends of the longer diagonal.
+	double diagonal1 = 0.0;
+	double diagonal2 = 0.0;
+	for (int j=0; j<3; ++j)
+	{
+		double u = m_halfU.GetElement(j);
+		double v = m_halfV.GetElement(j);
+		diagonal1 += (u + v) * (u + v);
+		diagonal2 += (u - v) * (u - v);
+	}
+	return sqrt(std::max(diagonal1, diagonal2));
+}
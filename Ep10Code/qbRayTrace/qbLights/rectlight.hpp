@@ -0,0 +1,47 @@
+/* ***********************************************************
+	rectlight.hpp
+	
+	The RectLight class definition - A rectangular area light, centred on m_location
+	and spanning m_halfU and m_halfV either side of it.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef RECTLIGHT_H
+#define RECTLIGHT_H
+
+#include "arealight.hpp"
+
+namespace qbRT
+{
+	class RectLight : public AreaLight
+	{
+		public:
+			// Constructor / destructor.
+			RectLight();
+			virtual ~RectLight() override;
+			
+			// Function to return a point on the light.
+			virtual qbVector<double> SamplePoint(double u1, double u2, const qbVector<double> &intPoint) override;
+			
+			// Function to return the distance from the centre to the furthest point of the light.
+			virtual double GetExtent() const override;
+			
+		public:
+			// Half of each edge of the rectangle.
+			qbVector<double> m_halfU {std::vector<double> {0.5, 0.0, 0.0}};
+			qbVector<double> m_halfV {std::vector<double> {0.0, 0.5, 0.0}};
+	};
+}
+
+#endif
@@ -0,0 +1,68 @@
+/* ***********************************************************
+	spherelight.cpp
+	
+	The SphereLight class implementation - A spherical area light, centred on m_location.
+	Points are sampled evenly over the cone of directions in which the sphere
+	is seen from the point being lit.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "spherelight.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Constructor / destructor.
+qbRT::SphereLight::SphereLight()
+{
+
+}
+
+qbRT::SphereLight::~SphereLight()
+{
+
+}
+
+// Function to return a point on the light.
+qbVector<double> qbRT::SphereLight::SamplePoint(double u1, double u2, const qbVector<double> &intPoint)
+{
+	qbVector<double> toCentre = m_location - intPoint;
+	double distance = toCentre.norm();
+	if (distance <= m_sphereRadius)
+		return m_location;
+		
+	// Choose a direction evenly within the cone that the sphere subtends at the point.
+	qbVector<double> w = toCentre * (1.0 / distance);
+	qbVector<double> tangent {3};
+	qbVector<double> bitangent {3};
+	BuildBasis(w, tangent, bitangent);
+	
+	double sinThetaMax = m_sphereRadius / distance;
+	double cosThetaMax = sqrt(std::max(0.0, 1.0 - (sinThetaMax * sinThetaMax)));
+	double cosTheta = 1.0 - (u1 * (1.0 - cosThetaMax));
+	double sinTheta = sqrt(std::max(0.0, 1.0 - (cosTheta * cosTheta)));
+	double phi = 2.0 * M_PI * u2;
+	qbVector<double> direction = (tangent * (sinTheta * cos(phi))) + (bitangent * (sinTheta * sin(phi))) + (w * cosTheta);
+	
+	/* And find where it first meets the sphere. Directions at the edge of the cone
+		only graze it, so rounding may leave them just outside. */
+	double discriminant = (m_sphereRadius * m_sphereRadius) - (distance * distance * sinTheta * sinTheta);
+	double t = (distance * cosTheta) - sqrt(std::max(0.0, discriminant));
+	return intPoint + (direction * t);
+}
+
+// Function to return the size of the light.
+double qbRT::SphereLight::GetExtent() const
+{
+	return m_sphereRadius;
+}
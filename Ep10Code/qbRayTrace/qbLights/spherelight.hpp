@@ -0,0 +1,46 @@
+/* ***********************************************************
+	spherelight.hpp
+	
+	The SphereLight class definition - A spherical area light, centred on m_location.
+	Only the half of the sphere facing the point being lit is sampled.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef SPHERELIGHT_H
+#define SPHERELIGHT_H
+
+#include "arealight.hpp"
+
+namespace qbRT
+{
+	class SphereLight : public AreaLight
+	{
+		public:
+			// Constructor / destructor.
+			SphereLight();
+			virtual ~SphereLight() override;
+			
+			// Function to return a point on the light.
+			virtual qbVector<double> SamplePoint(double u1, double u2, const qbVector<double> &intPoint) override;
+			
+			// Function to return the distance from the centre to the furthest point of the light.
+			virtual double GetExtent() const override;
+			
+		public:
+			// The radius of the sphere.
+			double m_sphereRadius = 0.5;
+	};
+}
+
+#endif
@@ -0,0 +1,258 @@
+/* ***********************************************************
+	bsdf.cpp
+	
+	The BSDF class implementation - Describes how a surface scatters
+	light, for use by the path tracer, as a mix of up to four lobes:
+	Lambertian diffuse reflection, mirror reflection, a normalised
+	Phong glossy lobe and smooth transmission.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "bsdf.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Constructor / destructor.
+qbRT::BSDF::BSDF()
+{
+
+}
+
+qbRT::BSDF::~BSDF()
+{
+
+}
+
+// Function to set up the lobes that match the Whitted shading.
+void qbRT::BSDF::SetWhittedLobes(const qbVector<double> &color, double reflectivity, double shininess)
+{
+	/* The Whitted highlight has a peak of reflectivity times the light intensity,
+		while a normalised Phong lobe of weight g has a peak of g * (n + 2) / 2 once
+		the light is scaled as the path tracer does, so g = 2r / (n + 2). */
+	double glossy = 0.0;
+	if (shininess > 0.0)
+		glossy = (2.0 * reflectivity) / (shininess + 2.0);
+		
+	for (int i=0; i<3; ++i)
+	{
+		m_diffuse[i] = color.GetElement(i) * (1.0 - reflectivity);
+		m_mirror[i] = reflectivity - glossy;
+		m_glossy[i] = glossy;
+		m_transmission[i] = 0.0;
+	}
+	
+	m_exponent = shininess;
+}
+
+// Function to scale every lobe.
+void qbRT::BSDF::Scale(double factor)
+{
+	for (int i=0; i<3; ++i)
+	{
+		m_diffuse[i] *= factor;
+		m_mirror[i] *= factor;
+		m_glossy[i] *= factor;
+		m_transmission[i] *= factor;
+	}
+}
+
+// Function to return true if the diffuse or glossy lobes can scatter light.
+bool qbRT::BSDF::HasSmoothLobes() const
+{
+	double probabilities[4];
+	GetLobeProbabilities(probabilities);
+	return (probabilities[0] > 0.0) || (probabilities[2] > 0.0);
+}
+
+// Function to return the value of the diffuse and glossy lobes.
+bool qbRT::BSDF::Evaluate(const qbVector<double> &wo, const qbVector<double> &wi, double *f) const
+{
+	f[0] = 0.0;
+	f[1] = 0.0;
+	f[2] = 0.0;
+	
+	// Only reflection is smooth, so wi must lie on the same side as wo.
+	qbVector<double> normal = GetFacingNormal(wo);
+	if (qbVector<double>::dot(normal, wi) <= 0.0)
+		return false;
+		
+	for (int i=0; i<3; ++i)
+		f[i] = m_diffuse[i] / M_PI;
+		
+	if ((m_glossy[0] > 0.0) || (m_glossy[1] > 0.0) || (m_glossy[2] > 0.0))
+	{
+		qbVector<double> reflected = (2.0 * qbVector<double>::dot(wo, normal) * normal) - wo;
+		double cosAlpha = qbVector<double>::dot(reflected, wi);
+		if (cosAlpha > 0.0)
+		{
+			double lobe = ((m_exponent + 2.0) / (2.0 * M_PI)) * std::pow(cosAlpha, m_exponent);
+			for (int i=0; i<3; ++i)
+				f[i] += m_glossy[i] * lobe;
+		}
+	}
+	
+	return (f[0] > 0.0) || (f[1] > 0.0) || (f[2] > 0.0);
+}
+
+// Function to return the probability density of choosing wi through the diffuse and glossy lobes.
+double qbRT::BSDF::GetPDF(const qbVector<double> &wo, const qbVector<double> &wi) const
+{
+	double probabilities[4];
+	GetLobeProbabilities(probabilities);
+	
+	qbVector<double> normal = GetFacingNormal(wo);
+	double cosTheta = qbVector<double>::dot(normal, wi);
+	if (cosTheta <= 0.0)
+		return 0.0;
+		
+	double pdf = probabilities[0] * cosTheta / M_PI;
+	if (probabilities[2] > 0.0)
+	{
+		qbVector<double> reflected = (2.0 * qbVector<double>::dot(wo, normal) * normal) - wo;
+		double cosAlpha = qbVector<double>::dot(reflected, wi);
+		if (cosAlpha > 0.0)
+			pdf += probabilities[2] * ((m_exponent + 1.0) / (2.0 * M_PI)) * std::pow(cosAlpha, m_exponent);
+	}
+	
+	return pdf;
+}
+
+// Function to choose a direction for the light arriving at the surface.
+bool qbRT::BSDF::Sample(	const qbVector<double> &wo, double uLobe, double u1, double u2,
+												qbVector<double> &wi, double *weight, double &pdf, bool &isSpecular) const
+{
+	double probabilities[4];
+	GetLobeProbabilities(probabilities);
+	qbVector<double> normal = GetFacingNormal(wo);
+	qbVector<double> reflected = (2.0 * qbVector<double>::dot(wo, normal) * normal) - wo;
+	
+	if (uLobe < probabilities[0])
+	{
+		// Cosine weighted about the normal.
+		double cosTheta = sqrt(std::max(0.0, 1.0 - u1));
+		wi = GetDirectionAroundAxis(normal, cosTheta, 2.0 * M_PI * u2);
+	}
+	else if (uLobe < probabilities[0] + probabilities[1])
+	{
+		// The mirror reflection.
+		wi = reflected;
+		pdf = 0.0;
+		isSpecular = true;
+		for (int i=0; i<3; ++i)
+			weight[i] = m_mirror[i] / probabilities[1];
+		return true;
+	}
+	else if (uLobe < probabilities[0] + probabilities[1] + probabilities[2])
+	{
+		// Phong weighted about the mirror direction.
+		double cosAlpha = std::pow(u1, 1.0 / (m_exponent + 1.0));
+		wi = GetDirectionAroundAxis(reflected, cosAlpha, 2.0 * M_PI * u2);
+	}
+	else if (probabilities[3] > 0.0)
+	{
+		// Refract through the surface, into the object if wo is outside it.
+		qbVector<double> throughNormal = m_normal;
+		throughNormal.Normalize();
+		double cosOut = qbVector<double>::dot(throughNormal, wo);
+		double eta = 1.0 / m_ior;
+		if (cosOut < 0.0)
+		{
+			throughNormal = throughNormal * -1.0;
+			cosOut = -cosOut;
+			eta = m_ior;
+		}
+		
+		// Total internal reflection sends the light back the way of the mirror.
+		double k = 1.0 - (eta * eta * (1.0 - (cosOut * cosOut)));
+		if (k < 0.0)
+			wi = (2.0 * cosOut * throughNormal) - wo;
+		else
+			wi = (-eta * wo) + (((eta * cosOut) - sqrt(k)) * throughNormal);
+			
+		wi.Normalize();
+		pdf = 0.0;
+		isSpecular = true;
+		for (int i=0; i<3; ++i)
+			weight[i] = m_transmission[i] / probabilities[3];
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+	
+	// Both smooth lobes are weighted by the density of choosing wi through either of them.
+	isSpecular = false;
+	double cosTheta = qbVector<double>::dot(normal, wi);
+	if (cosTheta <= 0.0)
+		return false;
+		
+	pdf = GetPDF(wo, wi);
+	double f[3];
+	if ((pdf <= 0.0) || !Evaluate(wo, wi, f))
+		return false;
+		
+	for (int i=0; i<3; ++i)
+		weight[i] = f[i] * cosTheta / pdf;
+		
+	return true;
+}
+
+// Function to return the probabilities of choosing each lobe.
+void qbRT::BSDF::GetLobeProbabilities(double *probabilities) const
+{
+	probabilities[0] = (m_diffuse[0] + m_diffuse[1] + m_diffuse[2]) / 3.0;
+	probabilities[1] = (m_mirror[0] + m_mirror[1] + m_mirror[2]) / 3.0;
+	probabilities[2] = (m_glossy[0] + m_glossy[1] + m_glossy[2]) / 3.0;
+	probabilities[3] = (m_transmission[0] + m_transmission[1] + m_transmission[2]) / 3.0;
+	
+	double total = 0.0;
+	for (int i=0; i<4; ++i)
+	{
+		probabilities[i] = std::max(0.0, probabilities[i]);
+		total += probabilities[i];
+	}
+	
+	for (int i=0; i<4; ++i)
+		probabilities[i] = (total > 0.0) ? (probabilities[i] / total) : 0.0;
+}
+
+// Function to return the normal turned to face the same side as wo.
+qbVector<double> qbRT::BSDF::GetFacingNormal(const qbVector<double> &wo) const
+{
+	qbVector<double> normal = m_normal;
+	normal.Normalize();
+	if (qbVector<double>::dot(normal, wo) < 0.0)
+		normal = normal * -1.0;
+		
+	return normal;
+}
+
+// Function to return the direction at the given angles from an axis.
+qbVector<double> qbRT::BSDF::GetDirectionAroundAxis(const qbVector<double> &axis, double cosTheta, double phi)
+{
+	// Start from whichever axis is furthest from the one given.
+	qbVector<double> other {std::vector<double> {1.0, 0.0, 0.0}};
+	if (std::abs(axis.GetElement(0)) > 0.9)
+		other = qbVector<double> {std::vector<double> {0.0, 1.0, 0.0}};
+		
+	qbVector<double> tangent = qbVector<double>::cross(axis, other);
+	tangent.Normalize();
+	qbVector<double> bitangent = qbVector<double>::cross(axis, tangent);
+	
+	double sinTheta = sqrt(std::max(0.0, 1.0 - (cosTheta * cosTheta)));
+	qbVector<double> direction = (tangent * (sinTheta * cos(phi))) + (bitangent * (sinTheta * sin(phi))) + (axis * cosTheta);
+	direction.Normalize();
+	return direction;
+}
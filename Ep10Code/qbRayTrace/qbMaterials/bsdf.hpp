@@ -0,0 +1,97 @@
+/* ***********************************************************
+	bsdf.hpp
+	
+	The BSDF class definition - Describes how a surface scatters
+	light, for use by the path tracer, as a mix of up to four lobes:
+	Lambertian diffuse reflection, mirror reflection, a normalised
+	Phong glossy lobe and smooth transmission. Directions can be
+	chosen in proportion to the lobes, and the value and probability
+	density of any direction found for the diffuse and glossy lobes,
+	so that light sampling and BSDF sampling can be combined. The
+	mirror and transmission lobes each scatter along one direction
+	only, and can only be sampled.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef BSDF_H
+#define BSDF_H
+
+#include "../qbLinAlg/qbVector.h"
+
+namespace qbRT
+{
+	class BSDF
+	{
+		public:
+			// Constructor / destructor.
+			BSDF();
+			~BSDF();
+			
+			/* Function to set up the lobes that match the Whitted shading of a material
+				with the given color, reflectivity and shininess. The diffuse part is the
+				color less the reflectivity. The Phong highlight that the Whitted shading
+				adds for each light becomes a glossy lobe, with the weight that gives the
+				same peak brightness, taken from the mirror reflection. */
+			void SetWhittedLobes(const qbVector<double> &color, double reflectivity, double shininess);
+			
+			// Function to scale every lobe by the same factor.
+			void Scale(double factor);
+			
+			// Function to return true if the diffuse or glossy lobes can scatter light, so that lights can be sampled.
+			bool HasSmoothLobes() const;
+			
+			/* Function to return the value of the diffuse and glossy lobes for light
+				arriving along wi and leaving along wo, both pointing away from the surface,
+				into f[0..3]. Returns false if it is zero. */
+			bool Evaluate(const qbVector<double> &wo, const qbVector<double> &wi, double *f) const;
+			
+			/* Function to return the probability density, over solid angle, with which
+				Sample would choose wi through the diffuse and glossy lobes. */
+			double GetPDF(const qbVector<double> &wo, const qbVector<double> &wi) const;
+			
+			/* Function to choose a direction wi for light arriving at the surface and
+				leaving along wo. uLobe chooses the lobe and u1 and u2 the direction within
+				it. Returns the value times the cosine over the density into weight[0..3],
+				the density in pdf and whether a mirror or transmission lobe was chosen.
+				Returns false if the direction lies on the wrong side of the surface. */
+			bool Sample(	const qbVector<double> &wo, double uLobe, double u1, double u2,
+										qbVector<double> &wi, double *weight, double &pdf, bool &isSpecular) const;
+										
+		public:
+			// The surface normal, which for transmission must point out of the object.
+			qbVector<double> m_normal {3};
+			
+			// The weights of the lobes.
+			double m_diffuse[3] = {0.0, 0.0, 0.0};
+			double m_mirror[3] = {0.0, 0.0, 0.0};
+			double m_glossy[3] = {0.0, 0.0, 0.0};
+			double m_transmission[3] = {0.0, 0.0, 0.0};
+			
+			// The Phong exponent of the glossy lobe, and the refractive index for transmission.
+			double m_exponent = 1.0;
+			double m_ior = 1.0;
+			
+		private:
+			// Function to return the probabilities of choosing each lobe, from their average weights.
+			void GetLobeProbabilities(double *probabilities) const;
+			
+			// Function to return the normal turned to face the same side as wo.
+			qbVector<double> GetFacingNormal(const qbVector<double> &wo) const;
+			
+			// Function to return the direction at the given angles from an axis.
+			static qbVector<double> GetDirectionAroundAxis(const qbVector<double> &axis, double cosTheta, double phi);
+	};
+}
+
+#endif
@@ -24,12 +24,15 @@
 // materialbase.cpp
 
 #include "materialbase.hpp"
+#include "../random.hpp"
+
+// Flag to show that this thread is computing an irradiance cache record.
+static thread_local bool t_computingRecord = false;
 
 // Constructor / destructor.
 qbRT::MaterialBase::MaterialBase()
 {
 	m_maxReflectionRays = 3;
-	m_reflectionRayCount = 0;
 }
 
 qbRT::MaterialBase::~MaterialBase()
@@ -42,7 +45,7 @@ qbVector<double> qbRT::MaterialBase::ComputeColor(	const std::vector<std::shared
 																										const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
 																										const std::shared_ptr<qbRT::ObjectBase> &currentObject,
 																										const qbVector<double> &intPoint, const qbVector<double> &localNormal,
-																										const qbRT::Ray &cameraRay)
+																										const qbRT::Ray &cameraRay, int reflectionDepth)
 {
 	// Define an initial material color.
 	qbVector<double> matColor	{3};
@@ -50,6 +53,29 @@ qbVector<double> qbRT::MaterialBase::ComputeColor(	const std::vector<std::shared
 	return matColor;
 }
 
+// Function to return the probability of specular scattering.
+double qbRT::MaterialBase::GetSpecularProbability() const
+{
+	return 0.0;
+}
+
+// Function to scatter a photon.
+bool qbRT::MaterialBase::ScatterPhoton(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																				const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																				const qbRT::Ray &incidentRay, double u, qbRT::Ray &scatteredRay)
+{
+	return false;
+}
+
+// Function to describe the material as a BSDF.
+void qbRT::MaterialBase::GetBSDF(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																	const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																	const qbRT::Ray &incidentRay, qbRT::BSDF &bsdf)
+{
+	bsdf = qbRT::BSDF();
+	bsdf.m_normal = localNormal;
+}
+
 // Function to compute the diffuse color.
 qbVector<double> qbRT::MaterialBase::ComputeDiffuseColor(	const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
 																													const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
@@ -66,18 +92,42 @@ qbVector<double> qbRT::MaterialBase::ComputeDiffuseColor(	const std::vector<std:
 	double blue = 0.0;
 	bool validIllum = false;
 	bool illumFound = false;
-	for (auto currentLight : lightList)
+	const std::vector<LightSample> &lightSamples = SelectLights(lightList, intPoint);
+	for (auto &lightSample : lightSamples)
 	{
-		validIllum = currentLight -> ComputeIllumination(intPoint, localNormal, objectList, currentObject, color, intensity);
+		validIllum = lightSample.light -> ComputeIllumination(intPoint, localNormal, objectList, currentObject, color, intensity);
 		if (validIllum)
 		{
 			illumFound = true;
+			intensity *= lightSample.weight;
 			red += color.GetElement(0) * intensity;
 			green += color.GetElement(1) * intensity;
 			blue += color.GetElement(2) * intensity;
 		}
 	}
 	
+	// Add the light from the environment.
+	if (m_environmentLight && m_environmentLight->IsValid())
+	{
+		double envColor[3];
+		m_environmentLight->ComputeIllumination(intPoint, localNormal, objectList, currentObject, envColor);
+		red += envColor[0];
+		green += envColor[1];
+		blue += envColor[2];
+		illumFound = true;
+	}
+	
+	// Add the light reflected from other surfaces.
+	if (m_irradianceCache)
+	{
+		double indirectColor[3];
+		ComputeIndirectDiffuse(objectList, lightList, currentObject, intPoint, localNormal, indirectColor);
+		red += indirectColor[0];
+		green += indirectColor[1];
+		blue += indirectColor[2];
+		illumFound = true;
+	}
+	
 	if (illumFound)
 	{
 		diffuseColor.SetElement(0, red * baseColor.GetElement(0));
@@ -86,9 +136,22 @@ qbVector<double> qbRT::MaterialBase::ComputeDiffuseColor(	const std::vector<std:
 	}
 	else
 	{
-		// The ambient light condition.
+		// The ambient light condition, less whatever is blocked by nearby objects.
+		double ambientIntensity = m_ambientIntensity;
+		if (m_ambientOcclusion && (ambientIntensity > 0.0))
+			ambientIntensity *= m_ambientOcclusion->ComputeVisibility(intPoint, localNormal, objectList, currentObject);
+			
 		for (int i=0; i<3; ++i)
-			diffuseColor.SetElement(i, (m_ambientColor.GetElement(i) * m_ambientIntensity) * baseColor.GetElement(i));
+			diffuseColor.SetElement(i, (m_ambientColor.GetElement(i) * ambientIntensity) * baseColor.GetElement(i));
+	}
+	
+	// Add the light focused onto the point by specular surfaces, which is in addition to any ambient light.
+	if (m_photonMap && (m_photonMap->GetNumPhotons() > 0))
+	{
+		double causticColor[3];
+		m_photonMap->EstimateIrradiance(intPoint, localNormal, causticColor);
+		for (int i=0; i<3; ++i)
+			diffuseColor.SetElement(i, diffuseColor.GetElement(i) + (causticColor[i] * baseColor.GetElement(i)));
 	}
 	
 	// Return the material color.
@@ -101,7 +164,7 @@ qbVector<double> qbRT::MaterialBase::ComputeReflectionColor(	const std::vector<s
 																															const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
 																															const std::shared_ptr<qbRT::ObjectBase> &currentObject,
 																															const qbVector<double> &intPoint, const qbVector<double> &localNormal,
-																															const qbRT::Ray &incidentRay)
+																															const qbRT::Ray &incidentRay, int reflectionDepth)
 {
 	qbVector<double> reflectionColor {3};
 	
@@ -119,34 +182,130 @@ qbVector<double> qbRT::MaterialBase::ComputeReflectionColor(	const std::vector<s
 	qbVector<double> closestLocalColor		{3};
 	bool intersectionFound = CastRay(reflectionRay, objectList, currentObject, closestObject, closestIntPoint, closestLocalNormal, closestLocalColor);
 	
+	/* Reflect the ray differentials too, about the surface where each of them
+		hits, so that textures seen in the reflection are filtered correctly, but
+		only if the object seen in the reflection has such a texture. */
+	if (intersectionFound && incidentRay.HasDifferentials() && NeedsDifferentials(closestObject))
+	{
+		qbRT::Ray auxRays[2];
+		bool validAux = true;
+		for (int i=0; (i<2) && validAux; ++i)
+		{
+			qbVector<double> auxPoint		{3};
+			qbVector<double> auxNormal	{3};
+			qbVector<double> auxUV			{2};
+			bool uvValid;
+			qbRT::Ray incidentAuxRay = incidentRay.GetDifferential(i);
+			validAux = IntersectDifferential(currentObject, intPoint, localNormal, incidentAuxRay, auxPoint, auxNormal, auxUV, uvValid);
+			if (validAux)
+			{
+				qbVector<double> auxD = incidentAuxRay.m_lab;
+				qbVector<double> auxReflectionVector = auxD - (2 * qbVector<double>::dot(auxD, auxNormal) * auxNormal);
+				auxRays[i] = qbRT::Ray (auxPoint, auxPoint + auxReflectionVector);
+			}
+		}
+		
+		if (validAux)
+			reflectionRay.SetDifferentials(auxRays[0], auxRays[1]);
+	}
+	
 	/* Compute illumination for closest object assuming that there was a
 		valid intersection. */
 	qbVector<double> matColor	{3};
-	if ((intersectionFound) && (m_reflectionRayCount < m_maxReflectionRays))
+	if ((intersectionFound) && (reflectionDepth < m_maxReflectionRays))
 	{
-		// Increment the reflectionRayCount.
-		m_reflectionRayCount++;
-		
 		// Check if a material has been assigned.
 		if (closestObject -> m_hasMaterial)
 		{
-			// Use the material to compute the color.
-			matColor = closestObject -> m_pMaterial -> ComputeColor(objectList, lightList, closestObject, closestIntPoint, closestLocalNormal, reflectionRay);
+			// Use the material to compute the color, one reflection deeper.
+			matColor = closestObject -> m_pMaterial -> ComputeColor(objectList, lightList, closestObject, closestIntPoint, closestLocalNormal, reflectionRay, reflectionDepth + 1);
 		}
 		else
 		{
 			matColor = qbRT::MaterialBase::ComputeDiffuseColor(objectList, lightList, closestObject, closestIntPoint, closestLocalNormal, closestObject->m_baseColor);
 		}
 	}
-	else
+	else if (!intersectionFound)
 	{
-		// Leave matColor as it is.
+		// The reflection sees the background.
+		matColor = ComputeBackgroundColor(reflectionRay);
 	}
 	
 	reflectionColor = matColor;
 	return reflectionColor;
 }
 
+// Function to compute the indirect diffuse light.
+void qbRT::MaterialBase::ComputeIndirectDiffuse(	const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+																									const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
+																									const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																									const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																									double *rgb)
+{
+	for (int i=0; i<3; ++i)
+		rgb[i] = 0.0;
+		
+	// Points shaded while computing a record get no indirect light.
+	if (!m_irradianceCache || t_computingRecord)
+		return;
+		
+	if (m_irradianceCache->Lookup(intPoint, localNormal, rgb))
+		return;
+		
+	/* Trace a new record. The surfaces that it sees are shaded without reflections,
+		by starting them at the greatest reflection depth, and the current object's
+		(u,v) coordinates are kept, as shading other points may overwrite them. */
+	qbVector<double> uvCoords = currentObject->m_uvCoords;
+	t_computingRecord = true;
+	
+	auto traceRay = [&](const qbVector<double> &direction, double *radiance, double &distance)
+	{
+		qbRT::Ray ray (intPoint, intPoint + direction);
+		std::shared_ptr<qbRT::ObjectBase> closestObject;
+		qbVector<double> closestIntPoint		{3};
+		qbVector<double> closestLocalNormal	{3};
+		qbVector<double> closestLocalColor	{3};
+		if (!CastRay(ray, objectList, currentObject, closestObject, closestIntPoint, closestLocalNormal, closestLocalColor))
+			return false;
+			
+		qbVector<double> color {3};
+		if (closestObject -> m_hasMaterial)
+			color = closestObject -> m_pMaterial -> ComputeColor(objectList, lightList, closestObject, closestIntPoint, closestLocalNormal, ray, m_maxReflectionRays);
+		else
+			color = ComputeDiffuseColor(objectList, lightList, closestObject, closestIntPoint, closestLocalNormal, closestObject->m_baseColor);
+			
+		for (int i=0; i<3; ++i)
+			radiance[i] = color.GetElement(i);
+		distance = (closestIntPoint - intPoint).norm();
+		return true;
+	};
+	
+	qbRT::IrradianceCache::Record record;
+	m_irradianceCache->ComputeRecord(intPoint, localNormal, traceRay, record);
+	
+	t_computingRecord = false;
+	currentObject->m_uvCoords = uvCoords;
+	
+	m_irradianceCache->Insert(record);
+	for (int i=0; i<3; ++i)
+		rgb[i] = record.irradiance[i];
+}
+
+// Function to return the background color.
+qbVector<double> qbRT::MaterialBase::ComputeBackgroundColor(const qbRT::Ray &ray)
+{
+	qbVector<double> backgroundColor {3};
+	if (m_environmentLight && m_environmentLight->IsValid())
+	{
+		double rgb[3];
+		m_environmentLight->GetRadiance(ray.m_lab, rgb);
+		for (int i=0; i<3; ++i)
+			backgroundColor.SetElement(i, rgb[i]);
+	}
+	
+	return backgroundColor;
+}
+
 // Function to cast a ray into the scene.
 bool qbRT::MaterialBase::CastRay( const qbRT::Ray &castRay, const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
 																	const std::shared_ptr<qbRT::ObjectBase> &thisObject,
@@ -161,11 +320,14 @@ bool qbRT::MaterialBase::CastRay( const qbRT::Ray &castRay, const std::vector<st
 	
 	double minDist = 1e6;
 	bool intersectionFound = false;
+	
+	// Test the central ray only, so that the objects do not also transform the differentials.
+	qbRT::Ray testRay = castRay.GetBaseRay();
 	for (auto currentObject : objectList)
 	{
 		if (currentObject != thisObject)
 		{
-			bool validInt = currentObject -> TestIntersection(castRay, intPoint, localNormal, localColor);
+			bool validInt = currentObject -> TestIntersection(testRay, intPoint, localNormal, localColor);
 			
 			// If we have a valid intersection.
 			if (validInt)
@@ -192,6 +354,109 @@ bool qbRT::MaterialBase::CastRay( const qbRT::Ray &castRay, const std::vector<st
 	return intersectionFound;
 }
 
+// Function to cast a ray into the scene without changing the objects.
+bool qbRT::MaterialBase::CastRay( const qbRT::Ray &castRay, const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+																	const std::shared_ptr<qbRT::ObjectBase> &thisObject,
+																	std::shared_ptr<qbRT::ObjectBase> &closestObject,
+																	qbVector<double> &closestIntPoint, qbVector<double> &closestLocalNormal,
+																	qbVector<double> &closestLocalColor, qbVector<double> &closestUVCoords)
+{
+	qbVector<double> intPoint			{3};
+	qbVector<double> localNormal	{3};
+	qbVector<double> localColor		{3};
+	qbVector<double> uvCoords			{2};
+	
+	double minDist = 1e6;
+	bool intersectionFound = false;
+	
+	qbRT::Ray testRay = castRay.GetBaseRay();
+	for (auto &currentObject : objectList)
+	{
+		if ((currentObject != thisObject) && currentObject -> TestIntersection(testRay, intPoint, localNormal, localColor, uvCoords))
+		{
+			intersectionFound = true;
+			double dist = (intPoint - castRay.m_point1).norm();
+			if (dist < minDist)
+			{
+				minDist = dist;
+				closestObject = currentObject;
+				closestIntPoint = intPoint;
+				closestLocalNormal = localNormal;
+				closestLocalColor = localColor;
+				closestUVCoords = uvCoords;
+			}
+		}
+	}
+	
+	return intersectionFound;
+}
+
+// Function to choose the lights used to shade a point.
+void qbRT::MaterialBase::SelectLights(	const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
+																				const qbVector<double> &intPoint, std::vector<LightSample> &lightSamples)
+{
+	lightSamples.clear();
+	
+	int numLights = static_cast<int>(lightList.size());
+	bool useTree = m_lightTree && (m_lightTree->GetNumLights() == numLights) && (m_numLightSamples >= 1);
+	
+	// Find the lights within range through the grid, if there is one built over this list.
+	if (m_lightGrid && (m_lightGrid->GetNumLights() == numLights))
+	{
+		// Only the lights listed in this cell can be in range, along with those without a radius.
+		for (int lightIndex : m_lightGrid->GetUnboundedLights())
+			lightSamples.push_back({lightList[lightIndex].get(), 1.0});
+			
+		const int *cellLights;
+		int numCellLights = m_lightGrid->GetCellLights(intPoint, cellLights);
+		for (int i=0; i<numCellLights; ++i)
+		{
+			qbRT::LightBase *currentLight = lightList[cellLights[i]].get();
+			double distance2 = 0.0;
+			for (int j=0; j<3; ++j)
+			{
+				double offset = currentLight->m_location.GetElement(j) - intPoint.GetElement(j);
+				distance2 += offset * offset;
+			}
+			double reach = currentLight->m_radius + currentLight->GetExtent();
+			if (distance2 < (reach * reach))
+				lightSamples.push_back({currentLight, 1.0});
+		}
+		
+		/* With no more lights in range than the tree would choose, using all of them
+			is both exact and cheaper than sampling. */
+		if (!useTree || (static_cast<int>(lightSamples.size()) <= m_numLightSamples))
+			return;
+			
+		lightSamples.clear();
+	}
+	else if (!useTree)
+	{
+		for (auto &currentLight : lightList)
+			lightSamples.push_back({currentLight.get(), 1.0});
+		return;
+	}
+	
+	// Stratify the random numbers, so that the choices are spread across the tree.
+	for (int i=0; i<m_numLightSamples; ++i)
+	{
+		double u = (static_cast<double>(i) + qbRT::Random::Uniform()) / static_cast<double>(m_numLightSamples);
+		double pmf;
+		int lightIndex = m_lightTree->SampleLight(intPoint, u, pmf);
+		if ((lightIndex >= 0) && (pmf > 0.0))
+			lightSamples.push_back({lightList[lightIndex].get(), 1.0 / (static_cast<double>(m_numLightSamples) * pmf)});
+	}
+}
+
+// Function to choose the lights used to shade a point, into the buffer for this thread.
+const std::vector<qbRT::MaterialBase::LightSample> &qbRT::MaterialBase::SelectLights(	const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
+																																											const qbVector<double> &intPoint)
+{
+	thread_local std::vector<LightSample> lightSamples;
+	SelectLights(lightList, intPoint, lightSamples);
+	return lightSamples;
+}
+
 // Function to assign a texture.
 void qbRT::MaterialBase::AssignTexture(const std::shared_ptr<qbRT::Texture::TextureBase> &inputTexture)
 {
@@ -199,6 +464,124 @@ void qbRT::MaterialBase::AssignTexture(const std::shared_ptr<qbRT::Texture::Text
 	m_hasTexture = true;
 }
 
+// Function to return the composited texture color.
+qbVector<double> qbRT::MaterialBase::GetTextureColor(const qbVector<double> &uvCoords, const qbVector<double> &baseColor, double footprint)
+{
+	// Blend in plain arrays, so that sampling the textures does not allocate.
+	double u = uvCoords.GetElement(0);
+	double v = uvCoords.GetElement(1);
+	double layerColor[4];
+	double blendedColor[3] = {0.0, 0.0, 0.0};
+	double blendedAlpha = 0.0;
+	bool opaque = false;
+	
+	// Work down from the most recently assigned texture, which is on top.
+	for (auto texture = m_textureList.rbegin(); (texture != m_textureList.rend()) && !opaque; ++texture)
+	{
+		(*texture)->SampleColor(u, v, footprint, layerColor);
+		
+		// The first texture assigned hides the base color, unless it is to blend with it.
+		if (!m_blendWithBaseColor && (std::next(texture) == m_textureList.rend()))
+			layerColor[3] = 1.0;
+		opaque = qbRT::Texture::TextureBase::BlendUnder(layerColor, blendedColor, blendedAlpha);
+	}
+	
+	// Anything still uncovered shows the base color.
+	if (!opaque)
+	{
+		for (int i=0; i<3; ++i)
+			layerColor[i] = baseColor.GetElement(i);
+		layerColor[3] = 1.0;
+		qbRT::Texture::TextureBase::BlendUnder(layerColor, blendedColor, blendedAlpha);
+	}
+	
+	qbVector<double> outputColor {3};
+	for (int i=0; i<3; ++i)
+		outputColor.SetElement(i, blendedColor[i]);
+	
+	return outputColor;
+}
+
+// Function to return whether any texture uses the footprint.
+bool qbRT::MaterialBase::UsesFootprint() const
+{
+	for (auto &texture : m_textureList)
+	{
+		if (texture->UsesFootprint())
+			return true;
+	}
+	
+	return false;
+}
+
+// Function to return whether a ray hitting an object needs its differentials.
+bool qbRT::MaterialBase::NeedsDifferentials(const std::shared_ptr<qbRT::ObjectBase> &object)
+{
+	return object && object->m_hasMaterial && object->m_pMaterial->UsesFootprint();
+}
+
+// Function to compute the texture footprint from the ray differentials.
+double qbRT::MaterialBase::ComputeTextureFootprint(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																										const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																										const qbRT::Ray &incidentRay)
+{
+	if (!incidentRay.HasDifferentials())
+		return -1.0;
+		
+	// Find the (u,v) coordinates where each auxiliary ray meets the object.
+	qbVector<double> uvCoords = currentObject -> m_uvCoords;
+	double footprint = -1.0;
+	for (int i=0; i<2; ++i)
+	{
+		qbVector<double> auxPoint		{3};
+		qbVector<double> auxNormal	{3};
+		qbVector<double> auxUV			{2};
+		bool uvValid = false;
+		if (!IntersectDifferential(currentObject, intPoint, localNormal, incidentRay.GetDifferential(i), auxPoint, auxNormal, auxUV, uvValid) || !uvValid)
+			continue;
+			
+		/* The footprint is the larger of the two steps in (u,v). A step of more than
+			half the (u,v) range means that the rays lie either side of a seam, so
+			ignore it. */
+		double du = auxUV.GetElement(0) - uvCoords.GetElement(0);
+		double dv = auxUV.GetElement(1) - uvCoords.GetElement(1);
+		if ((std::abs(du) > 1.0) || (std::abs(dv) > 1.0))
+			continue;
+			
+		footprint = std::max(footprint, sqrt((du * du) + (dv * dv)));
+	}
+	
+	return footprint;
+}
+
+// Function to find where an auxiliary ray meets the current object.
+bool qbRT::MaterialBase::IntersectDifferential(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																								const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																								const qbRT::Ray &auxRay, qbVector<double> &auxPoint,
+																								qbVector<double> &auxNormal, qbVector<double> &auxUV, bool &uvValid)
+{
+	/* Test the auxiliary ray against the object, leaving the (u,v) coordinates
+		of the main intersection in place. */
+	qbVector<double> auxColor {3};
+	uvValid = currentObject -> TestIntersection(auxRay, auxPoint, auxNormal, auxColor, auxUV);
+	if (uvValid)
+		return true;
+		
+	/* The auxiliary ray misses the object, as happens near its silhouette, so
+		intersect it with the tangent plane at the main intersection instead. */
+	double denom = qbVector<double>::dot(auxRay.m_lab, localNormal);
+	if (std::abs(denom) < 1e-12)
+		return false;
+		
+	double t = qbVector<double>::dot(intPoint - auxRay.m_point1, localNormal) / denom;
+	if (t <= 0.0)
+		return false;
+		
+	auxPoint = auxRay.m_point1 + (t * auxRay.m_lab);
+	auxNormal = localNormal;
+	return true;
+}
+
 
 
 
@@ -27,9 +27,18 @@
 #define MATERIALBASE_H
 
 #include <memory>
+#include <algorithm>
+#include <cmath>
 #include "../qbTextures/texturebase.hpp"
 #include "../qbPrimatives/objectbase.hpp"
 #include "../qbLights/lightbase.hpp"
+#include "../qbLights/lighttree.hpp"
+#include "../qbLights/lightgrid.hpp"
+#include "../qbLights/environmentlight.hpp"
+#include "../qbLights/irradiancecache.hpp"
+#include "../qbLights/photonmap.hpp"
+#include "../qbLights/ambientocclusion.hpp"
+#include "bsdf.hpp"
 #include "../qbLinAlg/qbVector.h"
 #include "../ray.hpp"
 
@@ -37,17 +46,46 @@ namespace qbRT
 {
 	class MaterialBase
 	{
+		public:
+			// A light chosen to shade a point, and the weight to give its contribution.
+			struct LightSample
+			{
+				qbRT::LightBase *light;
+				double weight;
+			};
+			
 		public:
 			MaterialBase();
 			virtual ~MaterialBase();
 			
-			// Function to return the color of the material.
+			/* Function to return the color of the material, seen along a ray that has
+				already been reflected reflectionDepth times. */
 			virtual qbVector<double> ComputeColor(	const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
 																							const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
 																							const std::shared_ptr<qbRT::ObjectBase> &currentObject,
 																							const qbVector<double> &intPoint, const qbVector<double> &localNormal,
-																							const qbRT::Ray &cameraRay);
+																							const qbRT::Ray &cameraRay, int reflectionDepth);
 																							
+			// Function to return the probability that a photon hitting the material is reflected or transmitted specularly.
+			virtual double GetSpecularProbability() const;
+			
+			/* Function to choose what happens to a photon arriving along the incident ray,
+				given a random number in [0,1). Returns true, with the ray that the photon
+				leaves along, if it is reflected or transmitted specularly, which happens
+				with the probability from GetSpecularProbability; otherwise returns false.
+				Photons are traced from several threads at once, so this must not change
+				the object or the material. */
+			virtual bool ScatterPhoton(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																	const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																	const qbRT::Ray &incidentRay, double u, qbRT::Ray &scatteredRay);
+																	
+			/* Function to describe the material at the intersection point as a BSDF, for
+				the path tracer, matching the shading from ComputeColor as closely as the
+				lobes allow. The base material scatters no light. */
+			virtual void GetBSDF(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+														const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+														const qbRT::Ray &incidentRay, qbRT::BSDF &bsdf);
+																	
 			// Function to compute diffuse color.
 			static qbVector<double> ComputeDiffuseColor(	const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
 																										const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
@@ -55,37 +93,137 @@ namespace qbRT
 																										const qbVector<double> &intPoint, const qbVector<double> &localNormal,
 																										const qbVector<double> &baseColor);
 																										
-			// Function to compute the reflection color.
+			/* Function to compute the reflection color, following the reflection only if
+				fewer than m_maxReflectionRays reflections led to this point. */
 			qbVector<double> ComputeReflectionColor(	const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
 																								const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
 																								const std::shared_ptr<qbRT::ObjectBase> &currentObject,
 																								const qbVector<double> &intPoint, const qbVector<double> &localNormal,
-																								const qbRT::Ray &incidentRay);
+																								const qbRT::Ray &incidentRay, int reflectionDepth);
 																										
+			/* Function to compute the diffuse light reflected onto a point by the other
+				surfaces in the scene, from the irradiance cache. A new record is computed
+				if none nearby can be used. The surfaces seen from a new record are shaded
+				with direct light only, so only a single bounce is included. */
+			static void ComputeIndirectDiffuse(	const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+																					const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
+																					const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																					const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																					double *rgb);
+																					
 			// Function to cast a ray into the scene.
-			bool CastRay(	const qbRT::Ray &castRay, const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+			static bool CastRay(	const qbRT::Ray &castRay, const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
 										const std::shared_ptr<qbRT::ObjectBase> &thisObject,
 										std::shared_ptr<qbRT::ObjectBase> &closestObject,
 										qbVector<double> &closestIntPoint, qbVector<double> &closestLocalNormal,
 										qbVector<double> &closestLocalColor);
 										
+			/* Function to cast a ray into the scene, returning the (u,v) coordinates of the
+				closest intersection instead of storing them on the objects, so that it may be
+				called from several threads at once. */
+			static bool CastRay(	const qbRT::Ray &castRay, const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
+										const std::shared_ptr<qbRT::ObjectBase> &thisObject,
+										std::shared_ptr<qbRT::ObjectBase> &closestObject,
+										qbVector<double> &closestIntPoint, qbVector<double> &closestLocalNormal,
+										qbVector<double> &closestLocalColor, qbVector<double> &closestUVCoords);
+										
+			// Function to return the color seen along a ray that misses every object.
+			static qbVector<double> ComputeBackgroundColor(const qbRT::Ray &ray);
+			
+			/* Function to choose the lights used to shade a point. Normally this is every
+				light within range, each with a weight of one, found through the light grid
+				if one has been built over the list. When a light tree has been built over
+				the list too, and more than m_numLightSamples lights are within range, that
+				many are chosen at random from the tree in proportion to their estimated
+				contribution instead, each weighted by the inverse of the number chosen and
+				of its probability, so that the weighted sum is an unbiased estimate of the
+				sum over every light. */
+			static void SelectLights(	const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
+																const qbVector<double> &intPoint, std::vector<LightSample> &lightSamples);
+																
+			/* Function to choose the lights in the same way, into a buffer kept for each
+				thread so that shading a point allocates nothing once the buffer has grown.
+				The result is only valid until the next call on the same thread, so it must
+				not be held while shading another point. */
+			static const std::vector<LightSample> &SelectLights(	const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
+																														const qbVector<double> &intPoint);
+										
 			// Function to assign a texture.
 			void AssignTexture(const std::shared_ptr<qbRT::Texture::TextureBase> &inputTexture);
+			
+			/* Function to return the color of the assigned textures at the given (u,v),
+				with each texture placed over those assigned before it. The first texture
+				covers the base color fully unless m_blendWithBaseColor is set, in which
+				case the result is placed over the base color by its alpha. The textures are
+				sampled from the top down, and any that are hidden by those above are never
+				sampled at all. If a footprint is given, the textures are filtered over it. */
+			qbVector<double> GetTextureColor(const qbVector<double> &uvCoords, const qbVector<double> &baseColor, double footprint = -1.0);
+			
+			// Function to return whether any of the assigned textures is filtered over a footprint.
+			bool UsesFootprint() const;
+			
+			/* Function to return whether a ray that hits the given object needs its ray
+				differentials, which is only so if the object's material filters a texture
+				over the footprint that they give. Differentials are neither traced nor
+				carried through reflections and refractions otherwise, so a texture seen
+				through an untextured mirror or lens is not filtered. */
+			static bool NeedsDifferentials(const std::shared_ptr<qbRT::ObjectBase> &object);
+			
+			/* Function to return the width of the region of (u,v) space covered by
+				the incident ray where it hits the current object, using its ray
+				differentials. Returns -1.0 if no footprint can be found. */
+			static double ComputeTextureFootprint(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																							const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																							const qbRT::Ray &incidentRay);
+			
+			/* Function to find where an auxiliary ray meets the current object. If it
+				misses the object, the tangent plane at the main intersection is used
+				instead and uvValid is set to false. */
+			static bool IntersectDifferential(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																					const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																					const qbRT::Ray &auxRay, qbVector<double> &auxPoint,
+																					qbVector<double> &auxNormal, qbVector<double> &auxUV, bool &uvValid);
 										
 		public:
-			// Counter for the number of relection rays.
+			// The largest number of reflections to follow from each camera ray.
 			inline static int m_maxReflectionRays;
-			inline static int m_reflectionRayCount;
 			
 			// The ambient lighting conditions.
 			inline static qbVector<double> m_ambientColor {std::vector<double> {1.0, 1.0, 1.0}};
 			inline static double m_ambientIntensity = 0.2;
 			
+			/* The light tree used by SelectLights, or null to use every light, and the
+				number of lights to choose at each point when it is used. */
+			inline static std::shared_ptr<qbRT::LightTree> m_lightTree;
+			inline static int m_numLightSamples = 4;
+			
+			// The grid used by SelectLights to find the lights within range, or null to visit every light.
+			inline static std::shared_ptr<qbRT::LightGrid> m_lightGrid;
+			
+			/* The environment light, or null for none. It lights every diffuse surface and
+				is seen by any ray that misses every object. */
+			inline static std::shared_ptr<qbRT::EnvironmentLight> m_environmentLight;
+			
+			/* The irradiance cache, or null for none. When it is used, it provides the
+				indirect diffuse light in place of the ambient light. */
+			inline static std::shared_ptr<qbRT::IrradianceCache> m_irradianceCache;
+			
+			// The photon map giving the caustics on diffuse surfaces, or null for none.
+			inline static std::shared_ptr<qbRT::PhotonMap> m_photonMap;
+			
+			// The ambient occlusion used to darken the ambient light where it is blocked, or null for none.
+			inline static std::shared_ptr<qbRT::AmbientOcclusion> m_ambientOcclusion;
+			
 			// List of texures assigned to this material.
 			std::vector<std::shared_ptr<qbRT::Texture::TextureBase>> m_textureList;
 			
 			// Flat to indicate whether at least one texture has been assigned.
 			bool m_hasTexture = false;
+			
+			/* Whether the base color shows through where the textures are transparent.
+				By default the alpha of the first texture is ignored, as it always was
+				before textures could be layered. */
+			bool m_blendWithBaseColor = false;
 		
 		private:
 		
@@ -40,7 +40,7 @@ qbVector<double> qbRT::SimpleMaterial::ComputeColor(	const std::vector<std::shar
 																											const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
 																											const std::shared_ptr<qbRT::ObjectBase> &currentObject,
 																											const qbVector<double> &intPoint, const qbVector<double> &localNormal,
-																											const qbRT::Ray &cameraRay)
+																											const qbRT::Ray &cameraRay, int reflectionDepth)
 {
 	// Define the initial material colors.
 	qbVector<double> matColor	{3};
@@ -52,11 +52,15 @@ qbVector<double> qbRT::SimpleMaterial::ComputeColor(	const std::vector<std::shar
 	if (!m_hasTexture)
 		difColor = ComputeDiffuseColor(objectList, lightList, currentObject, intPoint, localNormal, m_baseColor);
 	else
-		difColor = ComputeDiffuseColor(objectList, lightList, currentObject, intPoint, localNormal, m_textureList.at(0)->GetColor(currentObject->m_uvCoords));
+	{
+		// Filter the textures over the footprint of the incoming ray.
+		double footprint = ComputeTextureFootprint(currentObject, intPoint, localNormal, cameraRay);
+		difColor = ComputeDiffuseColor(objectList, lightList, currentObject, intPoint, localNormal, GetTextureColor(currentObject->m_uvCoords, m_baseColor, footprint));
+	}
 	
 	// Compute the reflection component.
 	if (m_reflectivity > 0.0)
-		refColor = ComputeReflectionColor(objectList, lightList, currentObject, intPoint, localNormal, cameraRay);
+		refColor = ComputeReflectionColor(objectList, lightList, currentObject, intPoint, localNormal, cameraRay, reflectionDepth);
 		
 	// Combine reflection and diffuse components.
 	matColor = (refColor * m_reflectivity) + (difColor * (1 - m_reflectivity));
@@ -82,12 +86,20 @@ qbVector<double> qbRT::SimpleMaterial::ComputeSpecular(	const std::vector<std::s
 	double green = 0.0;
 	double blue = 0.0;
 	
-	// Loop through all of the lights in the scene.
-	for (auto currentLight : lightList)
+	// Loop through the lights chosen to shade this point.
+	const std::vector<LightSample> &lightSamples = SelectLights(lightList, intPoint);
+	for (auto &lightSample : lightSamples)
 	{
+		const qbRT::LightBase *currentLight = lightSample.light;
+		
 		/* Check for intersections with all objects in the scene. */
 		double intensity = 0.0;
 		
+		// Skip lights that cannot reach this point without casting a shadow ray.
+		double lightDist = (currentLight->m_location - intPoint).norm();
+		if (!currentLight->IsInRange(lightDist))
+			continue;
+			
 		// Construct a vector pointing from the intersection point to the light.
 		qbVector<double> lightDir = (currentLight->m_location - intPoint).Normalized();
 		
@@ -127,7 +139,7 @@ qbVector<double> qbRT::SimpleMaterial::ComputeSpecular(	const std::vector<std::s
 			// Only proceed if the dot product is positive.
 			if (dotProduct > 0.0)
 			{
-				intensity = m_reflectivity * std::pow(dotProduct, m_shininess);
+				intensity = m_reflectivity * std::pow(dotProduct, m_shininess) * lightSample.weight * currentLight->GetAttenuation(lightDist);
 			}
 		}
 		
@@ -142,31 +154,39 @@ qbVector<double> qbRT::SimpleMaterial::ComputeSpecular(	const std::vector<std::s
 	return spcColor;
 }
 
+// Function to return the probability of specular scattering.
+double qbRT::SimpleMaterial::GetSpecularProbability() const
+{
+	return m_reflectivity;
+}
 
+// Function to scatter a photon.
+bool qbRT::SimpleMaterial::ScatterPhoton(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																					const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																					const qbRT::Ray &incidentRay, double u, qbRT::Ray &scatteredRay)
+{
+	if (u >= m_reflectivity)
+		return false;
+		
+	qbVector<double> d = incidentRay.m_lab;
+	qbVector<double> reflectionVector = d - (2 * qbVector<double>::dot(d, localNormal) * localNormal);
+	scatteredRay = qbRT::Ray (intPoint, intPoint + reflectionVector);
+	return true;
+}
 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
+// Function to describe the material as a BSDF.
+void qbRT::SimpleMaterial::GetBSDF(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																		const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																		const qbRT::Ray &incidentRay, qbRT::BSDF &bsdf)
+{
+	qbVector<double> color = m_baseColor;
+	if (m_hasTexture)
+	{
+		double footprint = ComputeTextureFootprint(currentObject, intPoint, localNormal, incidentRay);
+		color = GetTextureColor(currentObject->m_uvCoords, m_baseColor, footprint);
+	}
+	
+	bsdf = qbRT::BSDF();
+	bsdf.m_normal = localNormal;
+	bsdf.SetWhittedLobes(color, m_reflectivity, m_shininess);
+}
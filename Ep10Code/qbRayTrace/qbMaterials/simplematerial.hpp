@@ -42,7 +42,7 @@ namespace qbRT
 																							const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
 																							const std::shared_ptr<qbRT::ObjectBase> &currentObject,
 																							const qbVector<double> &intPoint, const qbVector<double> &localNormal,
-																							const qbRT::Ray &cameraRay) override;
+																							const qbRT::Ray &cameraRay, int reflectionDepth) override;
 																							
 			// Function to compute specular highlights.
 			qbVector<double> ComputeSpecular(	const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
@@ -50,6 +50,17 @@ namespace qbRT
 																				const qbVector<double> &intPoint, const qbVector<double> &localNormal,
 																				const qbRT::Ray &cameraRay);
 																				
+			// Functions to choose what happens to a photon that hits the material.
+			virtual double GetSpecularProbability() const override;
+			virtual bool ScatterPhoton(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																	const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																	const qbRT::Ray &incidentRay, double u, qbRT::Ray &scatteredRay) override;
+																	
+			// Function to describe the material as a BSDF.
+			virtual void GetBSDF(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+														const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+														const qbRT::Ray &incidentRay, qbRT::BSDF &bsdf) override;
+																	
 		public:
 			qbVector<double> m_baseColor {std::vector<double> {1.0, 0.0, 1.0}};
 			double m_reflectivity = 0.0;
@@ -38,7 +38,7 @@ qbVector<double> qbRT::SimpleRefractive::ComputeColor(	const std::vector<std::sh
 																												const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
 																												const std::shared_ptr<qbRT::ObjectBase> &currentObject,
 																												const qbVector<double> &intPoint, const qbVector<double> &localNormal,
-																												const qbRT::Ray &cameraRay)
+																												const qbRT::Ray &cameraRay, int reflectionDepth)
 {
 	// Define the initial material colors.
 	qbVector<double> matColor	{3};
@@ -51,18 +51,22 @@ qbVector<double> qbRT::SimpleRefractive::ComputeColor(	const std::vector<std::sh
 	if (!m_hasTexture)
 		difColor = ComputeDiffuseColor(objectList, lightList, currentObject, intPoint, localNormal, m_baseColor);
 	else
-		difColor = ComputeDiffuseColor(objectList, lightList, currentObject, intPoint, localNormal, m_textureList.at(0)->GetColor(currentObject->m_uvCoords));
+	{
+		// Filter the textures over the footprint of the incoming ray.
+		double footprint = ComputeTextureFootprint(currentObject, intPoint, localNormal, cameraRay);
+		difColor = ComputeDiffuseColor(objectList, lightList, currentObject, intPoint, localNormal, GetTextureColor(currentObject->m_uvCoords, m_baseColor, footprint));
+	}
 		
 	// Compute the reflection component.
 	if (m_reflectivity > 0.0)
-		refColor = ComputeReflectionColor(objectList, lightList, currentObject, intPoint, localNormal, cameraRay);
+		refColor = ComputeReflectionColor(objectList, lightList, currentObject, intPoint, localNormal, cameraRay, reflectionDepth);
 		
 	// Combine the reflection and diffuse components.
 	matColor = (refColor * m_reflectivity) + (difColor * (1.0 - m_reflectivity));
 	
 	// Compute the refractive component.
 	if (m_translucency > 0.0)
-		trnColor = ComputeTranslucency(objectList, lightList, currentObject, intPoint, localNormal, cameraRay);
+		trnColor = ComputeTranslucency(objectList, lightList, currentObject, intPoint, localNormal, cameraRay, reflectionDepth);
 		
 	// And combine with the current color.
 	matColor = (trnColor * m_translucency) + (matColor * (1.0 - m_translucency));
@@ -82,65 +86,30 @@ qbVector<double> qbRT::SimpleRefractive::ComputeTranslucency(	const std::vector<
 																															const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
 																															const std::shared_ptr<qbRT::ObjectBase> &currentObject,
 																															const qbVector<double> &intPoint, const qbVector<double> &localNormal,
-																															const qbRT::Ray &incidentRay)
+																															const qbRT::Ray &incidentRay, int reflectionDepth)
 {
 	qbVector<double> trnColor {3};
 	
-	// Compute the refracted vector.
-	qbVector<double> p = incidentRay.m_lab;
-	p.Normalize();
-	qbVector<double> tempNormal = localNormal;
-	double r = 1.0 / m_ior;
-	double c = -qbVector<double>::dot(tempNormal, p);
-	if (c < 0.0)
-	{
-		tempNormal = tempNormal * -1.0;
-		c = -qbVector<double>::dot(tempNormal, p);
-	}
-	
-	qbVector<double> refractedVector = r*p + (r*c - sqrtf(1.0-pow(r,2.0) * (1.0-pow(c,2.0)))) * tempNormal;
-	
-	// Construct the refracted ray.
-	qbRT::Ray refractedRay (intPoint + (refractedVector * 0.01), intPoint + refractedVector);
+	// Follow the refracted ray through the object.
+	qbRT::Ray finalRay;
+	bool test = TraceRefractedRay(currentObject, intPoint, localNormal, incidentRay, finalRay);
 	
-	// Test for secondary intersection with this object.
+	// Cast the ray leaving the object into the scene.
 	std::shared_ptr<qbRT::ObjectBase> closestObject;
 	qbVector<double> closestIntPoint		{3};
 	qbVector<double> closestLocalNormal	{3};
 	qbVector<double> closestLocalColor	{3};
-	qbVector<double> newIntPoint				{3};
-	qbVector<double> newLocalNormal			{3};
-	qbVector<double> newLocalColor			{3};
-	bool test = currentObject -> TestIntersection(refractedRay, newIntPoint, newLocalNormal, newLocalColor);
-	bool intersectionFound = false;
-	qbRT::Ray finalRay;
-	if (test)
-	{
-		// Compute the refracted vector.
-		qbVector<double> p2 = refractedRay.m_lab;
-		p2.Normalize();
-		qbVector<double> tempNormal2 = newLocalNormal;
-		double r2 = m_ior;
-		double c2 = -qbVector<double>::dot(tempNormal2, p2);
-		if (c2 < 0.0)
-		{
-			tempNormal2 = tempNormal2 * -1.0;
-			c2 = -qbVector<double>::dot(tempNormal2, p2);
-		}
-		qbVector<double> refractedVector2 = r2*p2 + (r2*c2 - sqrtf(1.0-pow(r2,2.0) * (1.0-pow(c2,2.0)))) * tempNormal2;
-		
-		// Compute the refracted ray.
-		qbRT::Ray refractedRay2 (newIntPoint + (refractedVector2 * 0.01), newIntPoint + refractedVector2);
-		
-		// Cast this ray into the scene.
-		intersectionFound = CastRay(refractedRay2, objectList, currentObject, closestObject, closestIntPoint, closestLocalNormal, closestLocalColor);
-		finalRay = refractedRay2;
-	}
-	else
+	bool intersectionFound = CastRay(finalRay, objectList, currentObject, closestObject, closestIntPoint, closestLocalNormal, closestLocalColor);
+	
+	/* Trace the ray differentials along the same path, so that textures seen
+		through the object are filtered correctly, if the object seen has any. */
+	if (intersectionFound && incidentRay.HasDifferentials() && NeedsDifferentials(closestObject))
 	{
-		/* No secondary intersections were found, so continue the original refracted ray. */
-		intersectionFound = CastRay(refractedRay, objectList, currentObject, closestObject, closestIntPoint, closestLocalNormal, closestLocalColor);
-		finalRay = refractedRay;
+		qbRT::Ray auxRayX;
+		qbRT::Ray auxRayY;
+		if (RefractDifferential(currentObject, intPoint, localNormal, incidentRay.GetDifferential(0), test, auxRayX) &&
+				RefractDifferential(currentObject, intPoint, localNormal, incidentRay.GetDifferential(1), test, auxRayY))
+			finalRay.SetDifferentials(auxRayX, auxRayY);
 	}
 	
 	// Compute the color for closest object.
@@ -150,7 +119,7 @@ qbVector<double> qbRT::SimpleRefractive::ComputeTranslucency(	const std::vector<
 		// Check if a material has been assigned.
 		if (closestObject -> m_hasMaterial)
 		{
-			matColor = closestObject -> m_pMaterial -> ComputeColor(objectList, lightList, closestObject, closestIntPoint, closestLocalNormal, finalRay);
+			matColor = closestObject -> m_pMaterial -> ComputeColor(objectList, lightList, closestObject, closestIntPoint, closestLocalNormal, finalRay, reflectionDepth);
 		}
 		else
 		{
@@ -159,13 +128,166 @@ qbVector<double> qbRT::SimpleRefractive::ComputeTranslucency(	const std::vector<
 	}
 	else
 	{
-		// Leave matColor as it is.
+		// The refracted ray sees the background.
+		matColor = ComputeBackgroundColor(finalRay);
 	}
 	
 	trnColor = matColor;
 	return trnColor;
 }
 
+// Function to follow a refracted ray through the object.
+bool qbRT::SimpleRefractive::TraceRefractedRay(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																								const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																								const qbRT::Ray &incidentRay, qbRT::Ray &finalRay)
+{
+	// Compute the refracted vector.
+	qbVector<double> refractedVector {3};
+	ComputeRefractedVector(incidentRay.m_lab, localNormal, 1.0 / m_ior, refractedVector);
+	
+	// Construct the refracted ray.
+	qbRT::Ray refractedRay (intPoint + (refractedVector * 0.01), intPoint + refractedVector);
+	
+	/* Test for secondary intersection with this object, without changing it, as
+		photons are traced through the object from several threads at once. */
+	qbVector<double> newIntPoint		{3};
+	qbVector<double> newLocalNormal	{3};
+	qbVector<double> newLocalColor	{3};
+	qbVector<double> newUVCoords		{2};
+	bool test = currentObject -> TestIntersection(refractedRay, newIntPoint, newLocalNormal, newLocalColor, newUVCoords);
+	if (test)
+	{
+		// Compute the refracted vector.
+		qbVector<double> refractedVector2 {3};
+		ComputeRefractedVector(refractedRay.m_lab, newLocalNormal, m_ior, refractedVector2);
+		
+		// Compute the refracted ray.
+		finalRay = qbRT::Ray (newIntPoint + (refractedVector2 * 0.01), newIntPoint + refractedVector2);
+	}
+	else
+	{
+		/* No secondary intersections were found, so continue the original refracted ray. */
+		finalRay = refractedRay;
+	}
+	
+	return test;
+}
+
+// Function to return the probability of specular scattering.
+double qbRT::SimpleRefractive::GetSpecularProbability() const
+{
+	return m_translucency + ((1.0 - m_translucency) * m_reflectivity);
+}
+
+// Function to scatter a photon.
+bool qbRT::SimpleRefractive::ScatterPhoton(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																						const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																						const qbRT::Ray &incidentRay, double u, qbRT::Ray &scatteredRay)
+{
+	// Choose in the same proportions that ComputeColor mixes the components.
+	if (u < m_translucency)
+	{
+		TraceRefractedRay(currentObject, intPoint, localNormal, incidentRay, scatteredRay);
+		return true;
+	}
+	
+	if (u < GetSpecularProbability())
+	{
+		qbVector<double> d = incidentRay.m_lab;
+		qbVector<double> reflectionVector = d - (2 * qbVector<double>::dot(d, localNormal) * localNormal);
+		scatteredRay = qbRT::Ray (intPoint, intPoint + reflectionVector);
+		return true;
+	}
+	
+	return false;
+}
+
+// Function to describe the material as a BSDF.
+void qbRT::SimpleRefractive::GetBSDF(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																			const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																			const qbRT::Ray &incidentRay, qbRT::BSDF &bsdf)
+{
+	qbVector<double> color = m_baseColor;
+	if (m_hasTexture)
+	{
+		double footprint = ComputeTextureFootprint(currentObject, intPoint, localNormal, incidentRay);
+		color = GetTextureColor(currentObject->m_uvCoords, m_baseColor, footprint);
+	}
+	
+	// The translucency is taken from the other lobes, as ComputeColor mixes them.
+	bsdf = qbRT::BSDF();
+	bsdf.m_normal = localNormal;
+	bsdf.SetWhittedLobes(color, m_reflectivity, m_shininess);
+	bsdf.Scale(1.0 - m_translucency);
+	for (int i=0; i<3; ++i)
+		bsdf.m_transmission[i] = m_translucency;
+		
+	bsdf.m_ior = m_ior;
+}
+
+// Function to compute the refracted direction.
+bool qbRT::SimpleRefractive::ComputeRefractedVector(	const qbVector<double> &incidentVector, const qbVector<double> &normal,
+																											double r, qbVector<double> &refractedVector)
+{
+	qbVector<double> p = incidentVector;
+	p.Normalize();
+	qbVector<double> tempNormal = normal;
+	double c = -qbVector<double>::dot(tempNormal, p);
+	if (c < 0.0)
+	{
+		tempNormal = tempNormal * -1.0;
+		c = -qbVector<double>::dot(tempNormal, p);
+	}
+	
+	double k = 1.0-pow(r,2.0) * (1.0-pow(c,2.0));
+	refractedVector = r*p + (r*c - sqrtf(k)) * tempNormal;
+	
+	return (k >= 0.0);
+}
+
+// Function to trace an auxiliary ray through the object.
+bool qbRT::SimpleRefractive::RefractDifferential(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																									const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																									const qbRT::Ray &auxRay, bool exitsObject, qbRT::Ray &outputRay)
+{
+	// Find where the auxiliary ray enters the object.
+	qbVector<double> auxPoint		{3};
+	qbVector<double> auxNormal	{3};
+	qbVector<double> auxUV			{2};
+	bool uvValid;
+	if (!IntersectDifferential(currentObject, intPoint, localNormal, auxRay, auxPoint, auxNormal, auxUV, uvValid))
+		return false;
+		
+	// Refract it into the object.
+	qbVector<double> refractedVector {3};
+	if (!ComputeRefractedVector(auxRay.m_lab, auxNormal, 1.0 / m_ior, refractedVector))
+		return false;
+	
+	qbRT::Ray refractedRay (auxPoint + (refractedVector * 0.01), auxPoint + refractedVector);
+	if (!exitsObject)
+	{
+		outputRay = refractedRay;
+		return true;
+	}
+	
+	// Find where it leaves the object, keeping the (u,v) coordinates of the main intersection.
+	qbVector<double> newIntPoint		{3};
+	qbVector<double> newLocalNormal	{3};
+	qbVector<double> newLocalColor	{3};
+	qbVector<double> newUVCoords		{2};
+	bool test = currentObject -> TestIntersection(refractedRay, newIntPoint, newLocalNormal, newLocalColor, newUVCoords);
+	if (!test)
+		return false;
+		
+	// And refract it out again.
+	qbVector<double> refractedVector2 {3};
+	if (!ComputeRefractedVector(refractedRay.m_lab, newLocalNormal, m_ior, refractedVector2))
+		return false;
+		
+	outputRay = qbRT::Ray (newIntPoint + (refractedVector2 * 0.01), newIntPoint + refractedVector2);
+	return true;
+}
+
 // Function to compute the specular highlights.
 qbVector<double> qbRT::SimpleRefractive::ComputeSpecular(	const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
 																													const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
@@ -177,12 +299,20 @@ qbVector<double> qbRT::SimpleRefractive::ComputeSpecular(	const std::vector<std:
 	double green = 0.0;
 	double blue = 0.0;
 	
-	// Loop through all of the lights in the scene.
-	for (auto currentLight : lightList)
+	// Loop through the lights chosen to shade this point.
+	const std::vector<LightSample> &lightSamples = SelectLights(lightList, intPoint);
+	for (auto &lightSample : lightSamples)
 	{
+		const qbRT::LightBase *currentLight = lightSample.light;
+		
 		/* Check for intersections with all objects in the scene. */
 		double intensity = 0.0;
 		
+		// Skip lights that cannot reach this point without casting a shadow ray.
+		double lightDist = (currentLight->m_location - intPoint).norm();
+		if (!currentLight->IsInRange(lightDist))
+			continue;
+			
 		// Construct a vector pointing from the intersection point to the light.
 		qbVector<double> lightDir = (currentLight->m_location - intPoint).Normalized();
 		
@@ -222,7 +352,7 @@ qbVector<double> qbRT::SimpleRefractive::ComputeSpecular(	const std::vector<std:
 			// Only proceed if the dot product is positive.
 			if (dotProduct > 0.0)
 			{
-				intensity = m_reflectivity * std::pow(dotProduct, m_shininess);
+				intensity = m_reflectivity * std::pow(dotProduct, m_shininess) * lightSample.weight * currentLight->GetAttenuation(lightDist);
 			}
 		}
 		
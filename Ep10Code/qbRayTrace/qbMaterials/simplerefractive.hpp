@@ -40,7 +40,7 @@ namespace qbRT
 																							const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
 																							const std::shared_ptr<qbRT::ObjectBase> &currentObject,
 																							const qbVector<double> &intPoint, const qbVector<double> &localNormal,
-																							const qbRT::Ray &cameraRay) override;
+																							const qbRT::Ray &cameraRay, int reflectionDepth) override;
 																							
 			// Function to compute specular highlights.
 			qbVector<double> ComputeSpecular(	const std::vector<std::shared_ptr<qbRT::ObjectBase>> &objectList,
@@ -53,7 +53,38 @@ namespace qbRT
 																						const std::vector<std::shared_ptr<qbRT::LightBase>> &lightList,
 																						const std::shared_ptr<qbRT::ObjectBase> &currentObject,
 																						const qbVector<double> &intPoint, const qbVector<double> &localNormal,
-																						const qbRT::Ray &incidentRay);
+																						const qbRT::Ray &incidentRay, int reflectionDepth);
+																						
+			// Functions to choose what happens to a photon that hits the material.
+			virtual double GetSpecularProbability() const override;
+			virtual bool ScatterPhoton(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																	const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																	const qbRT::Ray &incidentRay, double u, qbRT::Ray &scatteredRay) override;
+																	
+			// Function to describe the material as a BSDF.
+			virtual void GetBSDF(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+														const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+														const qbRT::Ray &incidentRay, qbRT::BSDF &bsdf) override;
+																	
+		private:
+			/* Function to follow a ray refracted into the object at the intersection
+				point, returning the ray that leaves it. Returns false if the refracted
+				ray did not meet the object again, in which case it is returned as it is. */
+			bool TraceRefractedRay(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+															const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+															const qbRT::Ray &incidentRay, qbRT::Ray &finalRay);
+															
+			/* Function to compute the refracted direction for a ray arriving along the
+				given direction, where r is the ratio of refractive indices. Returns false
+				in the case of total internal reflection. */
+			static bool ComputeRefractedVector(	const qbVector<double> &incidentVector, const qbVector<double> &normal,
+																					double r, qbVector<double> &refractedVector);
+																					
+			/* Function to trace an auxiliary ray into the object in the same way as the
+				main refracted ray, and out again if exitsObject is set. */
+			bool RefractDifferential(	const std::shared_ptr<qbRT::ObjectBase> &currentObject,
+																const qbVector<double> &intPoint, const qbVector<double> &localNormal,
+																const qbRT::Ray &auxRay, bool exitsObject, qbRT::Ray &outputRay);
 																						
 		public:
 			qbVector<double> m_baseColor {std::vector<double> {1.0, 0.0, 1.0}};
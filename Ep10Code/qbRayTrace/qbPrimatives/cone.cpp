@@ -38,7 +38,7 @@ qbRT::Cone::~Cone()
 
 // The function to test for intersections.
 bool qbRT::Cone::TestIntersection(	const qbRT::Ray &castRay, qbVector<double> &intPoint,
-																		qbVector<double> &localNormal, qbVector<double> &localColor)
+																		qbVector<double> &localNormal, qbVector<double> &localColor, qbVector<double> &uvCoords)
 {
 	// Copy the ray and apply the backwards transform.
 	qbRT::Ray bckRay = m_transformMatrix.Apply(castRay, qbRT::BCKTFORM);
@@ -174,8 +174,8 @@ bool qbRT::Cone::TestIntersection(	const qbRT::Ray &castRay, qbVector<double> &i
 		double u = atan2(y,x) / M_PI;
 		double v = (z * 2.0) + 1.0;
 		//double v = (-z * 2.0) + 0.5;
-		m_uvCoords.SetElement(0, u);
-		m_uvCoords.SetElement(1, v);
+		uvCoords.SetElement(0, u);
+		uvCoords.SetElement(1, v);
 	
 		return true;
 	}
@@ -204,8 +204,8 @@ bool qbRT::Cone::TestIntersection(	const qbRT::Ray &castRay, qbVector<double> &i
 				double x = validPOI.GetElement(0);
 				double y = validPOI.GetElement(1);
 				double z = validPOI.GetElement(2);
-				m_uvCoords.SetElement(0, x);
-				m_uvCoords.SetElement(1, y);
+				uvCoords.SetElement(0, x);
+				uvCoords.SetElement(1, y);
 						
 				return true;				
 			}
@@ -38,7 +38,7 @@ qbRT::Cylinder::~Cylinder()
 
 // The function to test for intersections.
 bool qbRT::Cylinder::TestIntersection(	const qbRT::Ray &castRay, qbVector<double> &intPoint,
-																				qbVector<double> &localNormal, qbVector<double> &localColor)
+																				qbVector<double> &localNormal, qbVector<double> &localColor, qbVector<double> &uvCoords)
 {
 	// Copy the ray and apply the backwards transform.
 	qbRT::Ray bckRay = m_transformMatrix.Apply(castRay, qbRT::BCKTFORM);
@@ -188,8 +188,8 @@ bool qbRT::Cylinder::TestIntersection(	const qbRT::Ray &castRay, qbVector<double
 		double z = validPOI.GetElement(2);
 		double u = atan2(y, x) / M_PI;
 		double v = z;
-		m_uvCoords.SetElement(0, u);
-		m_uvCoords.SetElement(1, v);
+		uvCoords.SetElement(0, u);
+		uvCoords.SetElement(1, v);
 		
 		return true;
 	}
@@ -218,8 +218,8 @@ bool qbRT::Cylinder::TestIntersection(	const qbRT::Ray &castRay, qbVector<double
 				double x = validPOI.GetElement(0);
 				double y = validPOI.GetElement(1);
 				double z = validPOI.GetElement(2);
-				m_uvCoords.SetElement(0, x);
-				m_uvCoords.SetElement(1, y);
+				uvCoords.SetElement(0, x);
+				uvCoords.SetElement(1, y);
 				
 				return true;
 			}
@@ -40,7 +40,7 @@ namespace qbRT
 			
 			// Override the function to test for intersections.
 			virtual bool TestIntersection(	const qbRT::Ray &castRay, qbVector<double> &intPoint,
-																			qbVector<double> &localNormal, qbVector<double> &localColor) override;
+																			qbVector<double> &localNormal, qbVector<double> &localColor, qbVector<double> &uvCoords) override;
 	};
 }
 
@@ -25,6 +25,7 @@
 
 #include "objectbase.hpp"
 #include <math.h>
+#include <algorithm>
 
 #define EPSILON 1e-21f;
 
@@ -42,6 +43,12 @@ qbRT::ObjectBase::~ObjectBase()
 
 // Function to test for intersections.
 bool qbRT::ObjectBase::TestIntersection(const Ray &castRay, qbVector<double> &intPoint, qbVector<double> &localNormal, qbVector<double> &localColor)
+{
+	return TestIntersection(castRay, intPoint, localNormal, localColor, m_uvCoords);
+}
+
+// Function to test for intersections without changing the object.
+bool qbRT::ObjectBase::TestIntersection(const Ray &castRay, qbVector<double> &intPoint, qbVector<double> &localNormal, qbVector<double> &localColor, qbVector<double> &uvCoords)
 {
 	return false;
 }
@@ -59,6 +66,19 @@ bool qbRT::ObjectBase::AssignMaterial(const std::shared_ptr<qbRT::MaterialBase>
 	return m_hasMaterial;
 }
 
+// Function to return a bounding sphere.
+void qbRT::ObjectBase::GetBoundingSphere(qbVector<double> &centre, double &radius) const
+{
+	qbRT::GTform transform = m_transformMatrix;
+	centre = transform.Apply(qbVector<double>{std::vector<double> {0.0, 0.0, 0.0}}, qbRT::FWDTFORM);
+	radius = 0.0;
+	for (int corner=0; corner<8; ++corner)
+	{
+		qbVector<double> cornerPoint {std::vector<double> {(corner & 1) ? 1.0 : -1.0, (corner & 2) ? 1.0 : -1.0, (corner & 4) ? 1.0 : -1.0}};
+		radius = std::max(radius, (transform.Apply(cornerPoint, qbRT::FWDTFORM) - centre).norm());
+	}
+}
+
 // Function to test whether two floating-point numbers are close to being equal.
 bool qbRT::ObjectBase::CloseEnough(const double f1, const double f2)
 {
@@ -44,8 +44,14 @@ namespace qbRT
 			ObjectBase();
 			virtual ~ObjectBase();
 			
-			// Function to test for intersections.
-			virtual bool TestIntersection(const Ray &castRay, qbVector<double> &intPoint, qbVector<double> &localNormal, qbVector<double> &localColor);
+			/* Function to test for intersections, storing the (u,v) coordinates of
+				the intersection in m_uvCoords for the material to use. */
+			bool TestIntersection(const Ray &castRay, qbVector<double> &intPoint, qbVector<double> &localNormal, qbVector<double> &localColor);
+			
+			/* Function to test for intersections, returning the (u,v) coordinates
+				instead. This does not change the object, so it may be called from
+				several threads at once. */
+			virtual bool TestIntersection(const Ray &castRay, qbVector<double> &intPoint, qbVector<double> &localNormal, qbVector<double> &localColor, qbVector<double> &uvCoords);
 			
 			// Function to set the transform matrix.
 			void SetTransformMatrix(const qbRT::GTform &transformMatrix);
@@ -56,6 +62,11 @@ namespace qbRT
 			// Function to assign a material.
 			bool AssignMaterial(const std::shared_ptr<qbRT::MaterialBase> &objectMaterial);
 			
+			/* Function to return a sphere in world coordinates that encloses the object.
+				Every primitive lies within the cube from -1 to 1 in its own coordinates, so
+				the sphere is centred on the origin and reaches the furthest corner. */
+			void GetBoundingSphere(qbVector<double> &centre, double &radius) const;
+			
 		// Public member variables.
 		public:
 			// The base colour of the object.
@@ -40,7 +40,7 @@ qbRT::ObjPlane::~ObjPlane()
 
 // The function to test for intersections.
 bool qbRT::ObjPlane::TestIntersection(	const qbRT::Ray &castRay, qbVector<double> &intPoint,
-																				qbVector<double> &localNormal, qbVector<double> &localColor)
+																				qbVector<double> &localNormal, qbVector<double> &localColor, qbVector<double> &uvCoords)
 {
 	// Copy the ray and apply the backwards transform.
 	qbRT::Ray bckRay = m_transformMatrix.Apply(castRay, qbRT::BCKTFORM);
@@ -85,8 +85,8 @@ bool qbRT::ObjPlane::TestIntersection(	const qbRT::Ray &castRay, qbVector<double
 				localColor = m_baseColor;
 				
 				// Store the (u,v) coordinates for possible later use.
-				m_uvCoords.SetElement(0, u);
-				m_uvCoords.SetElement(1, v);
+				uvCoords.SetElement(0, u);
+				uvCoords.SetElement(1, v);
 				
 				return true;
 			}
@@ -39,7 +39,7 @@ qbRT::ObjSphere::~ObjSphere()
 }
 
 // Function to test for intersections.
-bool qbRT::ObjSphere::TestIntersection(const qbRT::Ray &castRay, qbVector<double> &intPoint, qbVector<double> &localNormal, qbVector<double> &localColor)
+bool qbRT::ObjSphere::TestIntersection(const qbRT::Ray &castRay, qbVector<double> &intPoint, qbVector<double> &localNormal, qbVector<double> &localColor, qbVector<double> &uvCoords)
 {
 	// Copy the ray and apply the backwards transform.
 	qbRT::Ray bckRay = m_transformMatrix.Apply(castRay, qbRT::BCKTFORM);
@@ -142,8 +142,8 @@ bool qbRT::ObjSphere::TestIntersection(const qbRT::Ray &castRay, qbVector<double
 			u /= M_PI;
 			v /= M_PI;
 			
-			m_uvCoords.SetElement(0, u);
-			m_uvCoords.SetElement(1, v);
+			uvCoords.SetElement(0, u);
+			uvCoords.SetElement(1, v);
 			
 		}
 		
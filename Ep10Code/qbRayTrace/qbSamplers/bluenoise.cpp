@@ -0,0 +1,185 @@
+/* ***********************************************************
+	bluenoise.cpp
+	
+	The BlueNoise sampler class implementation - Shifts a sequence
+	that is the same for every pixel by an amount read from a tile
+	of blue noise repeated across the image, so that the error in
+	each pixel is unlike that of its neighbours.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "bluenoise.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Constructor / destructor.
+qbRT::Sampler::BlueNoise::BlueNoise()
+{
+
+}
+
+qbRT::Sampler::BlueNoise::~BlueNoise()
+{
+
+}
+
+// Function to return the next dimension of the current sample.
+double qbRT::Sampler::BlueNoise::Get1D()
+{
+	/* Every pixel follows the golden ratio sequence, shifted by its value from the
+		tile. The tile is read at an offset that depends only on the dimension, as a
+		different offset for each pixel would destroy the blue noise. */
+	double u = GetTileValue(GetDimensionHash()) + (static_cast<double>(m_sampleIndex) * 0.6180339887498949);
+	m_dimension++;
+	
+	return u - floor(u);
+}
+
+// Function to return the next two dimensions of the current sample.
+void qbRT::Sampler::BlueNoise::Get2D(double &u1, double &u2)
+{
+	// The two dimensional version of the sequence, based on the plastic number.
+	uint32_t hash = GetDimensionHash();
+	u1 = GetTileValue(HashRNG::Hash(hash, 0)) + (static_cast<double>(m_sampleIndex) * 0.7548776662466927);
+	u2 = GetTileValue(HashRNG::Hash(hash, 1)) + (static_cast<double>(m_sampleIndex) * 0.5698402909980532);
+	m_dimension += 2;
+	
+	u1 -= floor(u1);
+	u2 -= floor(u2);
+}
+
+// Function to return the tile.
+const std::vector<uint16_t> &qbRT::Sampler::BlueNoise::GetTile()
+{
+	static const std::vector<uint16_t> tile = BuildTile(TILE_SIZE);
+	return tile;
+}
+
+// Function to return the value of the tile at the current pixel.
+double qbRT::Sampler::BlueNoise::GetTileValue(uint32_t hash) const
+{
+	const std::vector<uint16_t> &tile = GetTile();
+	int x = (std::abs(m_pixelX) + static_cast<int>(hash % TILE_SIZE)) % TILE_SIZE;
+	int y = (std::abs(m_pixelY) + static_cast<int>((hash >> 16) % TILE_SIZE)) % TILE_SIZE;
+	
+	return (static_cast<double>(tile[(y * TILE_SIZE) + x]) + 0.5) / static_cast<double>(TILE_SIZE * TILE_SIZE);
+}
+
+// Function to make the tile.
+std::vector<uint16_t> qbRT::Sampler::BlueNoise::BuildTile(int size)
+{
+	int numTexels = size * size;
+	
+	/* The energy of a texel is the sum of a Gaussian of its distance to each point
+		in the pattern, measured around the edges of the tile so that it repeats
+		seamlessly. Store the Gaussian for every offset. */
+	const double sigma = 1.5;
+	std::vector<double> kernel (numTexels);
+	for (int dy=0; dy<size; ++dy)
+	{
+		for (int dx=0; dx<size; ++dx)
+		{
+			double wrapX = static_cast<double>(std::min(dx, size - dx));
+			double wrapY = static_cast<double>(std::min(dy, size - dy));
+			kernel[(dy * size) + dx] = exp(-((wrapX * wrapX) + (wrapY * wrapY)) / (2.0 * sigma * sigma));
+		}
+	}
+	
+	std::vector<char> pattern (numTexels, 0);
+	std::vector<double> energy (numTexels, 0.0);
+	auto setTexel = [&](int texel, char value)
+	{
+		pattern[texel] = value;
+		double sign = value ? 1.0 : -1.0;
+		int texelX = texel % size;
+		int texelY = texel / size;
+		for (int y=0; y<size; ++y)
+		{
+			const double *kernelRow = &kernel[((y - texelY + size) % size) * size];
+			double *energyRow = &energy[y * size];
+			for (int x=0; x<size; ++x)
+				energyRow[x] += sign * kernelRow[(x - texelX + size) % size];
+		}
+	};
+	
+	// The tightest cluster is the point with the most energy, and the largest void the gap with the least.
+	auto findTightestCluster = [&]()
+	{
+		int best = -1;
+		for (int i=0; i<numTexels; ++i)
+		{
+			if (pattern[i] && ((best < 0) || (energy[i] > energy[best])))
+				best = i;
+		}
+		return best;
+	};
+	
+	auto findLargestVoid = [&]()
+	{
+		int best = -1;
+		for (int i=0; i<numTexels; ++i)
+		{
+			if (!pattern[i] && ((best < 0) || (energy[i] < energy[best])))
+				best = i;
+		}
+		return best;
+	};
+	
+	// Start with a tenth of the texels chosen at random.
+	int numInitial = std::max(1, numTexels / 10);
+	HashRNG rng (0x5eed);
+	for (int placed=0; placed<numInitial; )
+	{
+		int texel = static_cast<int>(rng.NextUInt() % static_cast<uint32_t>(numTexels));
+		if (!pattern[texel])
+		{
+			setTexel(texel, 1);
+			placed++;
+		}
+	}
+	
+	// Spread them out, by moving the tightest cluster to the largest void until it would move straight back.
+	for (int i=0; i<numTexels; ++i)
+	{
+		int cluster = findTightestCluster();
+		setTexel(cluster, 0);
+		int gap = findLargestVoid();
+		setTexel(gap, 1);
+		if (gap == cluster)
+			break;
+	}
+	
+	/* Rank the initial points by removing the tightest cluster each time, and then
+		the rest by filling the largest void each time. */
+	std::vector<uint16_t> rank (numTexels, 0);
+	std::vector<char> initialPattern = pattern;
+	std::vector<double> initialEnergy = energy;
+	for (int r=numInitial-1; r>=0; --r)
+	{
+		int cluster = findTightestCluster();
+		setTexel(cluster, 0);
+		rank[cluster] = static_cast<uint16_t>(r);
+	}
+	
+	pattern = initialPattern;
+	energy = initialEnergy;
+	for (int r=numInitial; r<numTexels; ++r)
+	{
+		int gap = findLargestVoid();
+		setTexel(gap, 1);
+		rank[gap] = static_cast<uint16_t>(r);
+	}
+	
+	return rank;
+}
@@ -0,0 +1,67 @@
+/* ***********************************************************
+	bluenoise.hpp
+	
+	The BlueNoise sampler class definition - Shifts a sequence that
+	is the same for every pixel by an amount read from a tile of
+	blue noise repeated across the image, following "Distributing
+	Monte Carlo Errors as a Blue Noise in Screen Space". The error
+	in each pixel is then unlike that of its neighbours, so it is
+	spread as fine, even grain rather than clumps, which looks much
+	less noisy at low sample counts and is easily filtered out. Each
+	dimension reads the tile at a different offset.
+	
+	The tile is made with the void-and-cluster method the first time
+	that it is needed.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef BLUENOISE_H
+#define BLUENOISE_H
+
+#include <vector>
+#include "samplerbase.hpp"
+
+namespace qbRT
+{
+	namespace Sampler
+	{
+		class BlueNoise : public SamplerBase
+		{
+			public:
+				// Constructor / destructor.
+				BlueNoise();
+				virtual ~BlueNoise() override;
+				
+				// Functions to return the next dimensions of the current sample.
+				virtual double Get1D() override;
+				virtual void Get2D(double &u1, double &u2) override;
+				
+				/* Function to return the tile, of TILE_SIZE by TILE_SIZE values, each the rank
+					of its texel from 0 to TILE_SIZE^2 - 1, in rows. */
+				static const std::vector<uint16_t> &GetTile();
+				
+			public:
+				static const int TILE_SIZE = 64;
+				
+			private:
+				// Function to return the value of the tile at the current pixel, shifted by the given hash.
+				double GetTileValue(uint32_t hash) const;
+				
+				// Function to make the tile.
+				static std::vector<uint16_t> BuildTile(int size);
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,124 @@
+/* ***********************************************************
+	hashrng.cpp
+	
+	The HashRNG class implementation - A counter-based random number
+	generator. Each number is a hash of a key and a counter, rather
+	than the next state of a sequence, so any number in any stream
+	can be found directly. Work split between threads in any order
+	therefore always gives the same result.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "hashrng.hpp"
+
+// Constructor / destructor.
+qbRT::Sampler::HashRNG::HashRNG(uint32_t key, uint32_t counter)
+{
+	SetKey(key, counter);
+}
+
+qbRT::Sampler::HashRNG::~HashRNG()
+{
+
+}
+
+// Function to return the next number in the stream.
+double qbRT::Sampler::HashRNG::Uniform()
+{
+	return ToUnit(NextUInt());
+}
+
+// Function to return the next 32 random bits in the stream.
+uint32_t qbRT::Sampler::HashRNG::NextUInt()
+{
+	return Hash(m_key, m_counter++);
+}
+
+// Function to start a different stream.
+void qbRT::Sampler::HashRNG::SetKey(uint32_t key, uint32_t counter)
+{
+	m_key = key;
+	m_counter = counter;
+}
+
+// Function to hash a single value.
+uint32_t qbRT::Sampler::HashRNG::Hash(uint32_t x)
+{
+	// An integer finaliser, in which every input bit affects every output bit.
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+// Functions to hash two and three values.
+uint32_t qbRT::Sampler::HashRNG::Hash(uint32_t a, uint32_t b)
+{
+	return Hash(a ^ (Hash(b) + 0x9e3779b9u + (a << 6) + (a >> 2)));
+}
+
+uint32_t qbRT::Sampler::HashRNG::Hash(uint32_t a, uint32_t b, uint32_t c)
+{
+	return Hash(Hash(a, b), c);
+}
+
+// Function to convert 32 random bits to a number in the range [0,1).
+double qbRT::Sampler::HashRNG::ToUnit(uint32_t x)
+{
+	return static_cast<double>(x) * (1.0 / 4294967296.0);
+}
+
+// Function to find the position of an index in a random permutation.
+uint32_t qbRT::Sampler::HashRNG::Permute(uint32_t index, uint32_t length, uint32_t seed)
+{
+	if (length <= 1)
+		return 0;
+		
+	/* Kensler's hash-based permutation. The hash is invertible over the smallest
+		power of two that holds the length, so repeating it until the result is in
+		range visits every index exactly once. */
+	uint32_t mask = length - 1;
+	mask |= mask >> 1;
+	mask |= mask >> 2;
+	mask |= mask >> 4;
+	mask |= mask >> 8;
+	mask |= mask >> 16;
+	
+	uint32_t i = index;
+	do
+	{
+		i ^= seed;
+		i *= 0xe170893du;
+		i ^= seed >> 16;
+		i ^= (i & mask) >> 4;
+		i ^= seed >> 8;
+		i *= 0x0929eb3fu;
+		i ^= seed >> 23;
+		i ^= (i & mask) >> 1;
+		i *= 1u | (seed >> 27);
+		i *= 0x6935fa69u;
+		i ^= (i & mask) >> 11;
+		i *= 0x74dcb303u;
+		i ^= (i & mask) >> 2;
+		i *= 0x9e501cc3u;
+		i ^= (i & mask) >> 2;
+		i *= 0xc860a3dfu;
+		i &= mask;
+		i ^= i >> 5;
+	} while (i >= length);
+	
+	return (i + seed) % length;
+}
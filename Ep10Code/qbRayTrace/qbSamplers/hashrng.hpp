@@ -0,0 +1,67 @@
+/* ***********************************************************
+	hashrng.hpp
+	
+	The HashRNG class definition - A counter-based random number
+	generator. Each number is a hash of a key and a counter, rather
+	than the next state of a sequence, so any number in any stream
+	can be found directly. Work split between threads in any order
+	therefore always gives the same result.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef HASHRNG_H
+#define HASHRNG_H
+
+#include <cstdint>
+
+namespace qbRT
+{
+	namespace Sampler
+	{
+		class HashRNG
+		{
+			public:
+				// Constructor / destructor.
+				HashRNG(uint32_t key = 0, uint32_t counter = 0);
+				~HashRNG();
+				
+				// Function to return the next number in the stream, in the range [0,1).
+				double Uniform();
+				
+				// Function to return the next 32 random bits in the stream.
+				uint32_t NextUInt();
+				
+				// Function to start a different stream.
+				void SetKey(uint32_t key, uint32_t counter = 0);
+				
+				// Functions to hash one, two or three values to 32 well-mixed bits.
+				static uint32_t Hash(uint32_t x);
+				static uint32_t Hash(uint32_t a, uint32_t b);
+				static uint32_t Hash(uint32_t a, uint32_t b, uint32_t c);
+				
+				// Function to convert 32 random bits to a number in the range [0,1).
+				static double ToUnit(uint32_t x);
+				
+				/* Function to return the position of index in a random permutation of
+					0 to length-1 chosen by the seed, without storing the permutation. */
+				static uint32_t Permute(uint32_t index, uint32_t length, uint32_t seed);
+				
+			private:
+				uint32_t m_key;
+				uint32_t m_counter;
+		};
+	}
+}
+
+#endif
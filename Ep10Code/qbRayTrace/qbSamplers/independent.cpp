@@ -0,0 +1,48 @@
+/* ***********************************************************
+	independent.cpp
+	
+	The Independent sampler class implementation - Supplies
+	independent uniform random numbers, with no attempt to spread
+	the samples out. It is the reference that the other samplers
+	are measured against.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "independent.hpp"
+
+// Constructor / destructor.
+qbRT::Sampler::Independent::Independent()
+{
+
+}
+
+qbRT::Sampler::Independent::~Independent()
+{
+
+}
+
+// Function to return the next dimension of the current sample.
+double qbRT::Sampler::Independent::Get1D()
+{
+	double u = HashRNG::ToUnit(HashRNG::Hash(GetPixelHash(), static_cast<uint32_t>(m_sampleIndex)));
+	m_dimension++;
+	return u;
+}
+
+// Function to return the next two dimensions of the current sample.
+void qbRT::Sampler::Independent::Get2D(double &u1, double &u2)
+{
+	u1 = Get1D();
+	u2 = Get1D();
+}
@@ -0,0 +1,45 @@
+/* ***********************************************************
+	independent.hpp
+	
+	The Independent sampler class definition - Supplies independent
+	uniform random numbers, with no attempt to spread the samples
+	out. It is the reference that the other samplers are measured
+	against.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef INDEPENDENT_H
+#define INDEPENDENT_H
+
+#include "samplerbase.hpp"
+
+namespace qbRT
+{
+	namespace Sampler
+	{
+		class Independent : public SamplerBase
+		{
+			public:
+				// Constructor / destructor.
+				Independent();
+				virtual ~Independent() override;
+				
+				// Functions to return the next dimensions of the current sample.
+				virtual double Get1D() override;
+				virtual void Get2D(double &u1, double &u2) override;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,54 @@
+/* ***********************************************************
+	samplerbase.cpp
+	
+	The SamplerBase class implementation - A base class for samplers,
+	which supply the numbers used to place the samples taken for
+	each pixel.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "samplerbase.hpp"
+
+// Constructor / destructor.
+qbRT::Sampler::SamplerBase::SamplerBase()
+{
+
+}
+
+qbRT::Sampler::SamplerBase::~SamplerBase()
+{
+
+}
+
+// Function to start a sample.
+void qbRT::Sampler::SamplerBase::StartPixelSample(int x, int y, int sampleIndex)
+{
+	m_pixelX = x;
+	m_pixelY = y;
+	m_sampleIndex = sampleIndex;
+	m_dimension = 0;
+}
+
+// Function to return a hash of the seed, the pixel and the current dimension.
+uint32_t qbRT::Sampler::SamplerBase::GetPixelHash() const
+{
+	uint32_t pixel = HashRNG::Hash(static_cast<uint32_t>(m_pixelX), static_cast<uint32_t>(m_pixelY));
+	return HashRNG::Hash(m_seed, pixel, static_cast<uint32_t>(m_dimension));
+}
+
+// Function to return a hash of the seed and the current dimension.
+uint32_t qbRT::Sampler::SamplerBase::GetDimensionHash() const
+{
+	return HashRNG::Hash(m_seed, static_cast<uint32_t>(m_dimension));
+}
@@ -0,0 +1,82 @@
+/* ***********************************************************
+	samplerbase.hpp
+	
+	The SamplerBase class definition - A base class for samplers,
+	which supply the numbers used to place the samples taken for
+	each pixel. A sample is a point in a space of many dimensions,
+	one for each random choice made along the way, such as where
+	in the pixel the ray passes and which point on a light is used.
+	Samplers spread the samples for a pixel more evenly over that
+	space than independent random numbers would, and give each pixel
+	and each dimension a different pattern so that they do not line
+	up with one another.
+	
+	The numbers depend only on the seed, the pixel, the sample and
+	the dimension, so samples may be taken in any order, on any
+	thread, and always come out the same.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef SAMPLERBASE_H
+#define SAMPLERBASE_H
+
+#include <cstdint>
+#include "hashrng.hpp"
+
+namespace qbRT
+{
+	namespace Sampler
+	{
+		class SamplerBase
+		{
+			public:
+				// Constructor / destructor.
+				SamplerBase();
+				virtual ~SamplerBase();
+				
+				// Function to start the given sample of a pixel, from its first dimension.
+				void StartPixelSample(int x, int y, int sampleIndex);
+				
+				// Function to return the next dimension of the current sample, in the range [0,1).
+				virtual double Get1D() = 0;
+				
+				/* Function to return the next two dimensions of the current sample, which
+					are spread evenly over the unit square together as well as separately. */
+				virtual void Get2D(double &u1, double &u2) = 0;
+				
+			public:
+				// The seed, which chooses a different set of patterns.
+				uint32_t m_seed = 0;
+				
+				/* The number of samples expected for each pixel. Only the stratified sampler
+					needs to know; the others are spread evenly however many are taken. */
+				int m_samplesPerPixel = 16;
+				
+			protected:
+				// Function to return a hash of the seed, the pixel and the current dimension.
+				uint32_t GetPixelHash() const;
+				
+				// Function to return a hash of the seed and the current dimension alone.
+				uint32_t GetDimensionHash() const;
+				
+			protected:
+				int m_pixelX = 0;
+				int m_pixelY = 0;
+				int m_sampleIndex = 0;
+				int m_dimension = 0;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,104 @@
+/* ***********************************************************
+	sobol.cpp
+	
+	The Sobol sampler class implementation - Takes samples from the
+	first two dimensions of the Sobol sequence, with Owen scrambling
+	applied through a hash, following Burley's "Practical Hash-based
+	Owen Scrambling".
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "sobol.hpp"
+
+// Constructor / destructor.
+qbRT::Sampler::Sobol::Sobol()
+{
+
+}
+
+qbRT::Sampler::Sobol::~Sobol()
+{
+
+}
+
+// Function to return the next dimension of the current sample.
+double qbRT::Sampler::Sobol::Get1D()
+{
+	// Shuffle the order of the samples, and then scramble the value.
+	uint32_t seed = GetPixelHash();
+	uint32_t index = OwenScramble(static_cast<uint32_t>(m_sampleIndex), HashRNG::Hash(seed, 0));
+	uint32_t x = OwenScramble(SobolSample(index, 0), HashRNG::Hash(seed, 1));
+	m_dimension++;
+	
+	return HashRNG::ToUnit(x);
+}
+
+// Function to return the next two dimensions of the current sample.
+void qbRT::Sampler::Sobol::Get2D(double &u1, double &u2)
+{
+	// Both dimensions must use the same shuffled index, so that they stay a (0,2)-sequence together.
+	uint32_t seed = GetPixelHash();
+	uint32_t index = OwenScramble(static_cast<uint32_t>(m_sampleIndex), HashRNG::Hash(seed, 0));
+	uint32_t x = OwenScramble(SobolSample(index, 0), HashRNG::Hash(seed, 1));
+	uint32_t y = OwenScramble(SobolSample(index, 1), HashRNG::Hash(seed, 2));
+	m_dimension += 2;
+	
+	u1 = HashRNG::ToUnit(x);
+	u2 = HashRNG::ToUnit(y);
+}
+
+// Function to return a sample from the Sobol sequence.
+uint32_t qbRT::Sampler::Sobol::SobolSample(uint32_t index, int dimension)
+{
+	// The first dimension is the van der Corput sequence.
+	if (dimension == 0)
+		return ReverseBits(index);
+		
+	/* The direction numbers of the second dimension, whose primitive polynomial
+		is x + 1, are each the one before combined with itself shifted by one. */
+	uint32_t result = 0;
+	uint32_t direction = 0x80000000u;
+	for (; index != 0; index >>= 1)
+	{
+		if (index & 1u)
+			result ^= direction;
+		direction ^= direction >> 1;
+	}
+	return result;
+}
+
+// Function to apply a nested uniform scramble.
+uint32_t qbRT::Sampler::Sobol::OwenScramble(uint32_t x, uint32_t seed)
+{
+	/* The Laine-Karras hash only lets each bit affect those above it, which is
+		what an Owen scramble does to the bits below the radix point read from the
+		top, so reverse the bits on either side of it. */
+	x = ReverseBits(x);
+	x += seed;
+	x ^= x * 0x6c50b47cu;
+	x ^= x * 0xb82f1e52u;
+	x ^= x * 0xc7afe638u;
+	x ^= x * 0x8d22f6e6u;
+	return ReverseBits(x);
+}
+
+// Function to reverse the order of 32 bits.
+uint32_t qbRT::Sampler::Sobol::ReverseBits(uint32_t x)
+{
+	x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+	x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+	x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+	x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+	return (x >> 16) | (x << 16);
+}
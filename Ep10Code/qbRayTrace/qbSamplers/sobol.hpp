@@ -0,0 +1,60 @@
+/* ***********************************************************
+	sobol.hpp
+	
+	The Sobol sampler class definition - Takes samples from the
+	first two dimensions of the Sobol sequence, with Owen scrambling
+	applied through a hash, following Burley's "Practical Hash-based
+	Owen Scrambling". Every pair of dimensions uses the same two
+	Sobol dimensions, with the order of the samples shuffled and
+	their values scrambled differently for each pixel and pair, so
+	any number of dimensions can be used without the correlation
+	of higher Sobol dimensions. Any number of samples taken from
+	the start are well spread, so it suits adaptive and progressive
+	rendering, and it gives the fastest convergence of the samplers.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef SOBOL_H
+#define SOBOL_H
+
+#include "samplerbase.hpp"
+
+namespace qbRT
+{
+	namespace Sampler
+	{
+		class Sobol : public SamplerBase
+		{
+			public:
+				// Constructor / destructor.
+				Sobol();
+				virtual ~Sobol() override;
+				
+				// Functions to return the next dimensions of the current sample.
+				virtual double Get1D() override;
+				virtual void Get2D(double &u1, double &u2) override;
+				
+				// Function to return the given sample from the first (0) or second (1) dimension of the Sobol sequence, unscrambled.
+				static uint32_t SobolSample(uint32_t index, int dimension);
+				
+				// Function to apply a nested uniform (Owen) scramble to 32 bits, chosen by the seed.
+				static uint32_t OwenScramble(uint32_t x, uint32_t seed);
+				
+				// Function to reverse the order of 32 bits.
+				static uint32_t ReverseBits(uint32_t x);
+		};
+	}
+}
+
+#endif
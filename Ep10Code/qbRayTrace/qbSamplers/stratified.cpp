@@ -0,0 +1,71 @@
+/* ***********************************************************
+	stratified.cpp
+	
+	The Stratified sampler class implementation - Divides each
+	dimension, and each pair of dimensions, into m_samplesPerPixel
+	equal strata and places one jittered sample in each, visiting
+	the strata in a different random order for every pixel and
+	dimension. Samples beyond m_samplesPerPixel start a fresh set
+	of strata.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "stratified.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Constructor / destructor.
+qbRT::Sampler::Stratified::Stratified()
+{
+
+}
+
+qbRT::Sampler::Stratified::~Stratified()
+{
+
+}
+
+// Function to return the next dimension of the current sample.
+double qbRT::Sampler::Stratified::Get1D()
+{
+	uint32_t numStrata = static_cast<uint32_t>(std::max(1, m_samplesPerPixel));
+	uint32_t sampleIndex = static_cast<uint32_t>(m_sampleIndex);
+	
+	// Each complete set of samples has its own order and jitter.
+	uint32_t seed = HashRNG::Hash(GetPixelHash(), sampleIndex / numStrata);
+	uint32_t sample = sampleIndex % numStrata;
+	uint32_t stratum = HashRNG::Permute(sample, numStrata, seed);
+	double jitter = HashRNG::ToUnit(HashRNG::Hash(seed, sample));
+	m_dimension++;
+	
+	return (static_cast<double>(stratum) + jitter) / static_cast<double>(numStrata);
+}
+
+// Function to return the next two dimensions of the current sample.
+void qbRT::Sampler::Stratified::Get2D(double &u1, double &u2)
+{
+	uint32_t gridSize = static_cast<uint32_t>(std::max(1, static_cast<int>(sqrt(static_cast<double>(std::max(1, m_samplesPerPixel))))));
+	uint32_t numStrata = gridSize * gridSize;
+	uint32_t sampleIndex = static_cast<uint32_t>(m_sampleIndex);
+	
+	uint32_t seed = HashRNG::Hash(GetPixelHash(), sampleIndex / numStrata);
+	uint32_t sample = sampleIndex % numStrata;
+	uint32_t stratum = HashRNG::Permute(sample, numStrata, seed);
+	double jitter1 = HashRNG::ToUnit(HashRNG::Hash(seed, sample, 0));
+	double jitter2 = HashRNG::ToUnit(HashRNG::Hash(seed, sample, 1));
+	m_dimension += 2;
+	
+	u1 = (static_cast<double>(stratum % gridSize) + jitter1) / static_cast<double>(gridSize);
+	u2 = (static_cast<double>(stratum / gridSize) + jitter2) / static_cast<double>(gridSize);
+}
@@ -0,0 +1,48 @@
+/* ***********************************************************
+	stratified.hpp
+	
+	The Stratified sampler class definition - Divides each dimension,
+	and each pair of dimensions, into m_samplesPerPixel equal strata
+	and places one jittered sample in each, visiting the strata in a
+	different random order for every pixel and dimension. Samples
+	beyond m_samplesPerPixel start a fresh set of strata.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef STRATIFIED_H
+#define STRATIFIED_H
+
+#include "samplerbase.hpp"
+
+namespace qbRT
+{
+	namespace Sampler
+	{
+		class Stratified : public SamplerBase
+		{
+			public:
+				// Constructor / destructor.
+				Stratified();
+				virtual ~Stratified() override;
+				
+				/* Functions to return the next dimensions of the current sample. Pairs of
+					dimensions are stratified over the largest square grid with no more cells
+					than m_samplesPerPixel. */
+				virtual double Get1D() override;
+				virtual void Get2D(double &u1, double &u2) override;
+		};
+	}
+}
+
+#endif
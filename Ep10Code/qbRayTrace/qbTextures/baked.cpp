@@ -0,0 +1,218 @@
+/* ***********************************************************
+	baked.cpp
+	
+	The Baked class implementation - A texture that wraps another one,
+	typically an expensive procedural texture, and can bake it into
+	a mip mapped image.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "baked.hpp"
+#include "mipmap.hpp"
+#include "tiledformat.hpp"
+#include "../threadpool.hpp"
+#include <vector>
+#include <future>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <cstdio>
+
+// Function to hash a parameter key (64 bit FNV-1a).
+static uint64_t HashKey(const std::string &key)
+{
+	uint64_t hash = 1469598103934665603ULL;
+	for (unsigned char c : key)
+	{
+		hash ^= c;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// Constructor / destructor.
+qbRT::Texture::Baked::Baked()
+{
+
+}
+
+qbRT::Texture::Baked::~Baked()
+{
+
+}
+
+// Function to set the texture to be baked.
+void qbRT::Texture::Baked::SetSource(const std::shared_ptr<TextureBase> &sourceTexture)
+{
+	m_sourceTexture = sourceTexture;
+	m_isBaked = false;
+}
+
+// Function to return whether a baked version is available.
+bool qbRT::Texture::Baked::IsBaked() const
+{
+	return m_isBaked;
+}
+
+// Function to return the name of the cache file.
+std::string qbRT::Texture::Baked::GetCacheFileName(const std::string &key, int resolution) const
+{
+	std::ostringstream fileName;
+	fileName << m_cacheDirectory << "/baked_" << std::hex << HashKey(key) << std::dec << "_" << resolution
+						<< "_" << static_cast<int>(m_format) << ".qbtx";
+	return fileName.str();
+}
+
+// Function to bake the source texture.
+bool qbRT::Texture::Baked::Bake(int resolution)
+{
+	if (!m_sourceTexture || (resolution < 1))
+		return false;
+		
+	/* If the source texture can describe itself, then a previous bake of it
+		may be waiting in the cache. */
+	std::string key = m_sourceTexture->GetParameterKey();
+	std::string cacheFileName;
+	if (!m_cacheDirectory.empty() && !key.empty())
+	{
+		cacheFileName = GetCacheFileName(key, resolution);
+		if (std::ifstream(cacheFileName).good())
+		{
+			m_bakedImage.m_useTextureCache = false;
+			if (m_bakedImage.LoadImage(cacheFileName))
+			{
+				m_isBaked = true;
+				return true;
+			}
+		}
+	}
+	
+	/* Evaluate the source at the centre of each texel, using the same mapping
+		from (u,v) to texels as the image texture, one block of rows per task. */
+	std::vector<float> rgba (static_cast<std::size_t>(resolution) * resolution * 4);
+	int numTasks = std::max(1, ThreadPool::GetShared().GetNumThreads() * 4);
+	int rowsPerTask = std::max(1, (resolution + numTasks - 1) / numTasks);
+	std::vector<std::future<void>> tasks;
+	for (int firstRow=0; firstRow<resolution; firstRow+=rowsPerTask)
+	{
+		int lastRow = std::min(resolution, firstRow + rowsPerTask);
+		tasks.push_back(ThreadPool::GetShared().Submit([this, &rgba, resolution, firstRow, lastRow]()
+		{
+			double color[4];
+			for (int y=firstRow; y<lastRow; ++y)
+			{
+				double v = ((2.0 * static_cast<double>(resolution - y)) / resolution) - 1.0;
+				for (int x=0; x<resolution; ++x)
+				{
+					double u = ((2.0 * static_cast<double>(x)) / resolution) - 1.0;
+					m_sourceTexture->SampleColor(u, v, -1.0, color);
+					float *texel = &rgba[((static_cast<std::size_t>(y) * resolution) + x) * 4];
+					for (int c=0; c<4; ++c)
+						texel[c] = static_cast<float>(color[c]);
+				}
+			}
+		}));
+	}
+	
+	for (auto &task : tasks)
+		task.get();
+		
+	/* Store the result in the cache if we can, and map it back in from there. Write
+		puts the file in place with a rename, so that a bake interrupted part way through
+		never leaves a truncated file under the cache name. */
+	if (!cacheFileName.empty())
+	{
+		if (TiledFormat::Write(cacheFileName, resolution, resolution, rgba, m_format, false))
+		{
+			m_bakedImage.m_useTextureCache = false;
+			if (m_bakedImage.LoadImage(cacheFileName))
+			{
+				m_isBaked = true;
+				return true;
+			}
+		}
+	}
+	
+	/* Keep the bake in memory instead, but report the failure to cache it so that
+		the caller can decide whether it matters. */
+	auto mipMap = std::make_shared<MipMap>();
+	mipMap->Build(resolution, resolution, rgba, m_format, false);
+	m_bakedImage.SetTexels(mipMap);
+	m_isBaked = true;
+	
+	return cacheFileName.empty();
+}
+
+// Function to return the color.
+qbVector<double> qbRT::Texture::Baked::GetColor(const qbVector<double> &uvCoords)
+{
+	return GetColor(uvCoords, -1.0);
+}
+
+// Function to return the color filtered over the given footprint.
+qbVector<double> qbRT::Texture::Baked::GetColor(const qbVector<double> &uvCoords, double footprint)
+{
+	double rgba[4];
+	SampleColor(uvCoords.GetElement(0), uvCoords.GetElement(1), footprint, rgba);
+	return GetColorVector(rgba);
+}
+
+// Function to write the color filtered over the given footprint into an array.
+void qbRT::Texture::Baked::SampleColor(double u, double v, double footprint, double *rgba)
+{
+	// Apply the local transform to the (u,v) coordinates.
+	double newU, newV;
+	ApplyTransform(u, v, newU, newV);
+	
+	if (m_isBaked && m_useBaked)
+	{
+		m_bakedImage.SampleColor(newU, newV, footprint * GetTransformScale(), rgba);
+	}
+	else if (m_sourceTexture)
+	{
+		m_sourceTexture->SampleColor(newU, newV, footprint * GetTransformScale(), rgba);
+	}
+	else
+	{
+		// With nothing to show, use the same purple as a missing image.
+		rgba[0] = 1.0;
+		rgba[1] = 0.0;
+		rgba[2] = 1.0;
+		rgba[3] = 1.0;
+	}
+}
+
+// Function to return the parameter key.
+std::string qbRT::Texture::Baked::GetParameterKey()
+{
+	// The source texture, seen through this texture's own transform.
+	if (!m_sourceTexture)
+		return std::string();
+	
+	std::string sourceKey = m_sourceTexture->GetParameterKey();
+	if (sourceKey.empty())
+		return std::string();
+		
+	return "Baked;" + GetTransformKey() + ";" + sourceKey;
+}
+
+// Function to return whether the footprint is used.
+bool qbRT::Texture::Baked::UsesFootprint() const
+{
+	if (m_isBaked && m_useBaked)
+		return m_bakedImage.UsesFootprint();
+		
+	return m_sourceTexture && m_sourceTexture->UsesFootprint();
+}
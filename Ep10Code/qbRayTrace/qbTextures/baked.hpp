@@ -0,0 +1,95 @@
+/* ***********************************************************
+	baked.hpp
+	
+	The Baked class definition - A texture that wraps another one,
+	typically an expensive procedural texture, and can bake it into
+	a mip mapped image. Lookups then go to the image, unless the
+	baked version is switched off, in which case they go to the
+	original texture as before.
+	
+	The bake covers the (u,v) range [-1,1] in both directions, which
+	then repeats, in the same way as an image texture. Baking is
+	spread over the shared thread pool, and if a cache directory is
+	given, the result is stored there as a tiled texture file named
+	after a hash of the parameters of the original texture, so that
+	later runs can simply map it in.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef BAKED_H
+#define BAKED_H
+
+#include <memory>
+#include <string>
+#include "texturebase.hpp"
+#include "image.hpp"
+
+namespace qbRT
+{
+	namespace Texture
+	{
+		class Baked : public TextureBase
+		{
+			public:
+				// Constructor / destructor.
+				Baked();
+				virtual ~Baked() override;
+				
+				// Function to set the texture to be baked.
+				void SetSource(const std::shared_ptr<TextureBase> &sourceTexture);
+				
+				/* Function to bake the source texture into a square image with the given
+					number of texels along each side. This must not be called from a task
+					running on the shared thread pool. Returns false if the texture could not
+					be baked, or if it was baked but could not be stored in the cache, in
+					which case IsBaked returns true and it is kept in memory instead. */
+				bool Bake(int resolution);
+				
+				// Function to return whether a baked version is available.
+				bool IsBaked() const;
+				
+				// Functions to return the color.
+				virtual qbVector<double> GetColor(const qbVector<double> &uvCoords) override;
+				virtual qbVector<double> GetColor(const qbVector<double> &uvCoords, double footprint) override;
+				virtual void SampleColor(double u, double v, double footprint, double *rgba) override;
+				
+				// Function to return the parameter key.
+				virtual std::string GetParameterKey() override;
+				
+				// Function to return whether the footprint is used, by whichever texture is shown.
+				virtual bool UsesFootprint() const override;
+				
+			public:
+				// Whether to use the baked version, when there is one, or the source texture.
+				bool m_useBaked = true;
+				
+				// The directory in which to cache baked textures. If empty, nothing is cached.
+				std::string m_cacheDirectory;
+				
+				// The format to bake into.
+				TexelSource::Format m_format = TexelSource::Format::RGBA8;
+				
+			private:
+				// Function to return the name of the cache file for the given key and resolution.
+				std::string GetCacheFileName(const std::string &key, int resolution) const;
+				
+			private:
+				std::shared_ptr<TextureBase> m_sourceTexture;
+				Image m_bakedImage;
+				bool m_isBaked = false;
+		};
+	}
+}
+
+#endif
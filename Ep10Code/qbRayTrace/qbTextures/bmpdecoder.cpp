@@ -0,0 +1,75 @@
+/* ***********************************************************
+	bmpdecoder.cpp
+	
+	A function to load a bitmap image file and decode it into
+	linear RGBA values, shared by the image texture and the tiled
+	texture converter.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "bmpdecoder.hpp"
+#include "texelsource.hpp"
+#include <SDL2/SDL.h>
+#include <iostream>
+#include <cstring>
+
+// Function to load and decode a bitmap.
+bool qbRT::Texture::DecodeBMP(const std::string &fileName, int &xSize, int &ySize, std::vector<float> &rgba, bool linearize)
+{
+	SDL_Surface *imageSurface = SDL_LoadBMP(fileName.c_str());
+	
+	if (!imageSurface)
+	{
+		std::cout << "Failed to load image. " << SDL_GetError() << "." << std::endl;
+		return false;
+	}
+
+	// Extract useful information.
+	xSize = imageSurface->w;
+	ySize = imageSurface->h;
+	int pitch = imageSurface->pitch;
+	SDL_PixelFormat *pixelFormat = imageSurface->format;
+	uint8_t bytesPerPixel = pixelFormat->BytesPerPixel;
+	
+	// Decode every pixel.
+	rgba.assign(xSize * ySize * 4, 0.0f);
+	for (int y=0; y<ySize; ++y)
+	{
+		uint8_t *row = static_cast<uint8_t *>(imageSurface->pixels) + (y * pitch);
+		for (int x=0; x<xSize; ++x)
+		{
+			uint32_t currentPixel = 0;
+			memcpy(&currentPixel, row + (x * bytesPerPixel), bytesPerPixel);
+			uint8_t channels[4];
+			SDL_GetRGBA(currentPixel, pixelFormat, &channels[0], &channels[1], &channels[2], &channels[3]);
+			int index = ((y * xSize) + x) * 4;
+			for (int c=0; c<4; ++c)
+			{
+				if (linearize && (c < 3))
+					rgba.at(index + c) = static_cast<float>(TexelSource::SRGBToLinear(channels[c]));
+				else
+					rgba.at(index + c) = static_cast<float>(channels[c]) / 255.0f;
+			}
+		}
+	}
+	
+	std::cout << "Loaded " << xSize << " by " << ySize << "." << std::endl;
+	std::cout << "Bytes per pixel = " << +bytesPerPixel << std::endl;
+	std::cout << "Pitch = " << pitch << std::endl;
+	
+	// We no longer need the surface.
+	SDL_FreeSurface(imageSurface);
+	
+	return true;
+}
@@ -0,0 +1,38 @@
+/* ***********************************************************
+	bmpdecoder.hpp
+	
+	A function to load a bitmap image file and decode it into
+	linear RGBA values, shared by the image texture and the tiled
+	texture converter.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef BMPDECODER_H
+#define BMPDECODER_H
+
+#include <string>
+#include <vector>
+
+namespace qbRT
+{
+	namespace Texture
+	{
+		/* Function to load a bitmap and decode it into RGBA values, four per texel,
+			with rows running from the top of the image down. If linearize is set, the
+			color channels are converted from sRGB; alpha is always linear. */
+		bool DecodeBMP(const std::string &fileName, int &xSize, int &ySize, std::vector<float> &rgba, bool linearize);
+	}
+}
+
+#endif
@@ -0,0 +1,114 @@
+/* ***********************************************************
+	cachedtexture.cpp
+	
+	The CachedTexture class implementation - A source of texels for a
+	tiled texture file (.qbtx) that reads them through the shared
+	TextureCache, so that only the tiles that are actually sampled
+	are ever loaded.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "cachedtexture.hpp"
+
+/* The tile most recently used by this thread. Neighbouring lookups, such as the
+	four texels of a bilinear sample, usually fall in the same tile, so this saves
+	going through the cache (and its locks) for most of them. Those lookups are
+	not counted in the cache's hit rate, which would need a shared counter. */
+namespace
+{
+	struct LastTile
+	{
+		const qbRT::Texture::TextureCache *cache = nullptr;
+		int fileID = -1;
+		int level = -1;
+		int tileX = -1;
+		int tileY = -1;
+		std::shared_ptr<const qbRT::Texture::TextureCache::Tile> tile;
+	};
+	
+	thread_local LastTile lastTile;
+}
+
+// Constructor / destructor.
+qbRT::Texture::CachedTexture::CachedTexture()
+{
+
+}
+
+qbRT::Texture::CachedTexture::~CachedTexture()
+{
+
+}
+
+// Function to open a tiled file.
+bool qbRT::Texture::CachedTexture::Open(const std::string &fileName, TextureCache &cache)
+{
+	m_cache = &cache;
+	m_fileID = m_cache->OpenFile(fileName);
+	if (m_fileID < 0)
+		return false;
+		
+	m_cache->GetFileInfo(m_fileID, m_header, m_levels);
+	return true;
+}
+
+// Functions to return the number of levels and the size of each level.
+int qbRT::Texture::CachedTexture::GetNumLevels() const
+{
+	return static_cast<int>(m_levels.size());
+}
+
+int qbRT::Texture::CachedTexture::GetXSize(int level) const
+{
+	return m_levels.at(level).xSize;
+}
+
+int qbRT::Texture::CachedTexture::GetYSize(int level) const
+{
+	return m_levels.at(level).ySize;
+}
+
+// Function to return a single texel.
+void qbRT::Texture::CachedTexture::GetTexel(int level, int x, int y, double *rgba) const
+{
+	const TiledFormat::LevelInfo &levelInfo = m_levels[level];
+	x = ((x % levelInfo.xSize) + levelInfo.xSize) % levelInfo.xSize;
+	y = ((y % levelInfo.ySize) + levelInfo.ySize) % levelInfo.ySize;
+	int tileX = x / m_header.tileSize;
+	int tileY = y / m_header.tileSize;
+	
+	// Fetch the tile, unless this thread used it last.
+	if ((lastTile.cache != m_cache) || (lastTile.fileID != m_fileID) || (lastTile.level != level) ||
+			(lastTile.tileX != tileX) || (lastTile.tileY != tileY))
+	{
+		std::shared_ptr<const TextureCache::Tile> tile = m_cache->GetTile(m_fileID, level, tileX, tileY);
+		if (!tile)
+		{
+			// If the tile cannot be read, return the same purple as a missing image.
+			rgba[0] = 1.0;
+			rgba[1] = 0.0;
+			rgba[2] = 1.0;
+			rgba[3] = 1.0;
+			return;
+		}
+		lastTile.cache = m_cache;
+		lastTile.fileID = m_fileID;
+		lastTile.level = level;
+		lastTile.tileX = tileX;
+		lastTile.tileY = tileY;
+		lastTile.tile = std::move(tile);
+	}
+	
+	TiledFormat::DecodeTexel(m_header, lastTile.tile->data(), x % m_header.tileSize, y % m_header.tileSize, rgba);
+}
@@ -0,0 +1,61 @@
+/* ***********************************************************
+	cachedtexture.hpp
+	
+	The CachedTexture class definition - A source of texels for a
+	tiled texture file (.qbtx) that reads them through the shared
+	TextureCache, so that only the tiles that are actually sampled
+	are ever loaded.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef CACHEDTEXTURE_H
+#define CACHEDTEXTURE_H
+
+#include <string>
+#include <vector>
+#include "texelsource.hpp"
+#include "texturecache.hpp"
+
+namespace qbRT
+{
+	namespace Texture
+	{
+		class CachedTexture : public TexelSource
+		{
+			public:
+				// Constructor / destructor.
+				CachedTexture();
+				virtual ~CachedTexture() override;
+				
+				// Function to open a tiled file through the given cache.
+				bool Open(const std::string &fileName, TextureCache &cache = TextureCache::GetShared());
+				
+				// Functions to return the number of levels and the size of each level.
+				virtual int GetNumLevels() const override;
+				virtual int GetXSize(int level) const override;
+				virtual int GetYSize(int level) const override;
+				
+				// Function to return a single texel, wrapping x and y into the image.
+				virtual void GetTexel(int level, int x, int y, double *rgba) const override;
+				
+			private:
+				TextureCache *m_cache = nullptr;
+				int m_fileID = -1;
+				TiledFormat::Header m_header;
+				std::vector<TiledFormat::LevelInfo> m_levels;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,56 @@
+/* ***********************************************************
+	cellular.cpp
+	
+	The Cellular class implementation - A Worley noise texture of
+	cells separated by thin walls, found where the nearest two feature
+	points are almost the same distance away.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "cellular.hpp"
+#include <cmath>
+#include <sstream>
+
+// Constructor / destructor.
+qbRT::Texture::Noise::Cellular::Cellular()
+{
+	m_color1 = qbVector<double>{std::vector<double>{0.8, 0.8, 0.8, 1.0}};
+	m_color2 = qbVector<double>{std::vector<double>{0.1, 0.1, 0.1, 1.0}};
+}
+
+qbRT::Texture::Noise::Cellular::~Cellular()
+{
+
+}
+
+// Function to return the color.
+void qbRT::Texture::Noise::Cellular::SampleColor(double inputU, double inputV, double, double *rgba)
+{
+	// Apply the local transform to the (u,v) coordinates.
+	double u, v;
+	ApplyTransform(inputU, inputV, u, v);
+	
+	// Use the second color on the walls, fading into the first towards the middle of each cell.
+	double f1, f2;
+	Worley2D(u, v, f1, f2);
+	BlendColor(1.0 - ((f2 - f1) / m_edgeWidth), rgba);
+}
+
+// Function to return the parameters of this pattern.
+std::string qbRT::Texture::Noise::Cellular::GetPatternKey()
+{
+	std::ostringstream key;
+	key << std::hexfloat << "Cellular," << m_edgeWidth;
+	return key.str();
+}
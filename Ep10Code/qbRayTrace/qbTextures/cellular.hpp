@@ -0,0 +1,54 @@
+/* ***********************************************************
+	cellular.hpp
+	
+	The Cellular class definition - A Worley noise texture of
+	cells separated by thin walls, found where the nearest two feature
+	points are almost the same distance away.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef CELLULAR_H
+#define CELLULAR_H
+
+#include "noisebase.hpp"
+
+namespace qbRT
+{
+	namespace Texture
+	{
+		namespace Noise
+		{
+			class Cellular : public NoiseBase
+			{
+				public:
+					// Constructor / destructor.
+					Cellular();
+					virtual ~Cellular() override;
+					
+					// Function to return the color.
+					virtual void SampleColor(double u, double v, double footprint, double *rgba) override;
+					
+				protected:
+					// Function to return the parameters of this pattern.
+					virtual std::string GetPatternKey() override;
+					
+				public:
+					// The width of the walls between the cells.
+					double m_edgeWidth = 0.1;
+			};
+		}
+	}
+}
+
+#endif
@@ -37,26 +37,29 @@ qbRT::Texture::Checker::~Checker()
 
 // Function to return the color.
 qbVector<double> qbRT::Texture::Checker::GetColor(const qbVector<double> &uvCoords)
+{
+	double rgba[4];
+	SampleColor(uvCoords.GetElement(0), uvCoords.GetElement(1), -1.0, rgba);
+	return GetColorVector(rgba);
+}
+
+// Function to write the color into an array.
+void qbRT::Texture::Checker::SampleColor(double u, double v, double, double *rgba)
 {
 	// Apply the local transform to the (u,v) coordinates.
-	qbVector<double> inputLoc = uvCoords;
-	qbVector<double> newLoc = ApplyTransform(inputLoc);
-	double newU = newLoc.GetElement(0);
-	double newV = newLoc.GetElement(1);
+	double newU, newV;
+	ApplyTransform(u, v, newU, newV);
 	
-	qbVector<double> localColor {4};
 	int check = static_cast<int>(floor(newU)) + static_cast<int>(floor(newV));
 	
 	if ((check % 2) == 0)
 	{
-		localColor = m_color1;
+		GetColorArray(m_color1, rgba);
 	}
 	else
 	{
-		localColor = m_color2;
+		GetColorArray(m_color2, rgba);
 	}
-	
-	return localColor;
 }
 
 // Function to set the colors.
@@ -65,3 +68,9 @@ void qbRT::Texture::Checker::SetColor(const qbVector<double> &inputColor1, const
 	m_color1 = inputColor1;
 	m_color2 = inputColor2;
 }
+
+// Function to return the parameter key.
+std::string qbRT::Texture::Checker::GetParameterKey()
+{
+	return "Checker;" + GetTransformKey() + ";" + GetVectorKey(m_color1) + ";" + GetVectorKey(m_color2);
+}
@@ -37,11 +37,15 @@ namespace qbRT
 				Checker();
 				virtual ~Checker() override;
 			
-				// Function to return the color.
+				// Functions to return the color.
 				virtual qbVector<double> GetColor(const qbVector<double> &uvCoords) override;
+				virtual void SampleColor(double u, double v, double footprint, double *rgba) override;
 			
 				// Function to set the colors.
 				void SetColor(const qbVector<double> &inputColor1, const qbVector<double> &inputColor2);
+				
+				// Function to return the parameter key.
+				virtual std::string GetParameterKey() override;
 			
 		private:
 			qbVector<double> m_color1 {4};
@@ -0,0 +1,55 @@
+/* ***********************************************************
+	clouds.cpp
+	
+	The Clouds class implementation - A noise texture of clouds,
+	taken from a slice through 3D fBm, so that moving the slice animates
+	the clouds.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "clouds.hpp"
+#include <cmath>
+#include <sstream>
+
+// Constructor / destructor.
+qbRT::Texture::Noise::Clouds::Clouds()
+{
+	m_color1 = qbVector<double>{std::vector<double>{0.35, 0.55, 0.9, 1.0}};
+	m_color2 = qbVector<double>{std::vector<double>{1.0, 1.0, 1.0, 1.0}};
+}
+
+qbRT::Texture::Noise::Clouds::~Clouds()
+{
+
+}
+
+// Function to return the color.
+void qbRT::Texture::Noise::Clouds::SampleColor(double inputU, double inputV, double, double *rgba)
+{
+	// Apply the local transform to the (u,v) coordinates.
+	double u, v;
+	ApplyTransform(inputU, inputV, u, v);
+	
+	// Map the fBm to the range [0,1], and then into cloud where it is above the threshold.
+	double density = 0.5 + (0.5 * FBm3D(u, v, m_z));
+	BlendColor((density - (1.0 - m_coverage)) * m_sharpness, rgba);
+}
+
+// Function to return the parameters of this pattern.
+std::string qbRT::Texture::Noise::Clouds::GetPatternKey()
+{
+	std::ostringstream key;
+	key << std::hexfloat << "Clouds," << m_coverage << "," << m_sharpness << "," << m_z;
+	return key.str();
+}
@@ -0,0 +1,58 @@
+/* ***********************************************************
+	clouds.hpp
+	
+	The Clouds class definition - A noise texture of clouds,
+	taken from a slice through 3D fBm, so that moving the slice animates
+	the clouds.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef CLOUDS_H
+#define CLOUDS_H
+
+#include "noisebase.hpp"
+
+namespace qbRT
+{
+	namespace Texture
+	{
+		namespace Noise
+		{
+			class Clouds : public NoiseBase
+			{
+				public:
+					// Constructor / destructor.
+					Clouds();
+					virtual ~Clouds() override;
+					
+					// Function to return the color.
+					virtual void SampleColor(double u, double v, double footprint, double *rgba) override;
+					
+				protected:
+					// Function to return the parameters of this pattern.
+					virtual std::string GetPatternKey() override;
+					
+				public:
+					// The fraction of the sky that is covered, and how sharp the edges of the clouds are.
+					double m_coverage = 0.5;
+					double m_sharpness = 4.0;
+					
+					// The position of the slice through the 3D noise.
+					double m_z = 0.0;
+			};
+		}
+	}
+}
+
+#endif
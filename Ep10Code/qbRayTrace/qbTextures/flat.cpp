@@ -40,6 +40,12 @@ qbVector<double> qbRT::Texture::Flat::GetColor(const qbVector<double> &uvCoords)
 	return m_color;
 }
 
+// Function to write the color into an array.
+void qbRT::Texture::Flat::SampleColor(double u, double v, double, double *rgba)
+{
+	GetColorArray(m_color, rgba);
+}
+
 // Function to set the color.
 void qbRT::Texture::Flat::SetColor(const qbVector<double> &inputColor)
 {
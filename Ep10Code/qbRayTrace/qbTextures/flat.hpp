@@ -37,8 +37,9 @@ namespace qbRT
 				Flat();
 				virtual ~Flat() override;
 				
-				// Function to return the color.
+				// Functions to return the color.
 				virtual qbVector<double> GetColor(const qbVector<double> &uvCoords) override;
+				virtual void SampleColor(double u, double v, double footprint, double *rgba) override;
 				
 				// Function to set the color.
 				void SetColor(const qbVector<double> &inputColor);
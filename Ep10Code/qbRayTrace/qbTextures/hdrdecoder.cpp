@@ -0,0 +1,181 @@
+/* ***********************************************************
+	hdrdecoder.cpp
+	
+	A function to load a Radiance HDR (RGBE) image file and decode
+	it into linear RGBA values.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "hdrdecoder.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+// Function to read one scanline of RGBE values, in either the flat or the run-length encoded form.
+static bool ReadScanline(std::ifstream &file, int xSize, std::vector<uint8_t> &scanline)
+{
+	uint8_t first[4];
+	if (!file.read(reinterpret_cast<char *>(first), 4))
+		return false;
+		
+	// A new-style run-length encoded scanline starts with 2, 2 and the width.
+	bool encoded = (xSize >= 8) && (xSize < 32768) && (first[0] == 2) && (first[1] == 2) && ((first[2] & 0x80) == 0);
+	if (encoded)
+	{
+		if (((first[2] << 8) | first[3]) != xSize)
+			return false;
+			
+		// Each of the four channels is stored separately, as runs and literal spans.
+		for (int c=0; c<4; ++c)
+		{
+			int x = 0;
+			while (x < xSize)
+			{
+				uint8_t count;
+				if (!file.read(reinterpret_cast<char *>(&count), 1))
+					return false;
+					
+				if (count > 128)
+				{
+					int runLength = count - 128;
+					uint8_t value;
+					if ((runLength > (xSize - x)) || !file.read(reinterpret_cast<char *>(&value), 1))
+						return false;
+					for (int i=0; i<runLength; ++i)
+						scanline[((x++) * 4) + c] = value;
+				}
+				else
+				{
+					if ((count == 0) || (count > (xSize - x)))
+						return false;
+					for (int i=0; i<count; ++i)
+					{
+						if (!file.read(reinterpret_cast<char *>(&scanline[((x++) * 4) + c]), 1))
+							return false;
+					}
+				}
+			}
+		}
+		return true;
+	}
+	
+	/* Otherwise the pixels are stored flat, except that a pixel of 1, 1, 1 repeats
+		the previous pixel, with consecutive repeats counting in higher digits. */
+	int x = 0;
+	int shift = 0;
+	uint8_t pixel[4] = {first[0], first[1], first[2], first[3]};
+	while (true)
+	{
+		if ((pixel[0] == 1) && (pixel[1] == 1) && (pixel[2] == 1))
+		{
+			/* The count can have at most four digits, and must not run past the end
+				of the scanline. */
+			if ((x == 0) || (shift > 24))
+				return false;
+			int64_t repeat = static_cast<int64_t>(pixel[3]) << shift;
+			if (repeat > (xSize - x))
+				return false;
+			for (int i=0; i<repeat; ++i, ++x)
+			{
+				for (int c=0; c<4; ++c)
+					scanline[(x * 4) + c] = scanline[((x - 1) * 4) + c];
+			}
+			shift += 8;
+		}
+		else
+		{
+			for (int c=0; c<4; ++c)
+				scanline[(x * 4) + c] = pixel[c];
+			x++;
+			shift = 0;
+		}
+		
+		if (x >= xSize)
+			return true;
+			
+		if (!file.read(reinterpret_cast<char *>(pixel), 4))
+			return false;
+	}
+}
+
+// Function to load and decode an HDR image.
+bool qbRT::Texture::DecodeHDR(const std::string &fileName, int &xSize, int &ySize, std::vector<float> &rgba)
+{
+	std::ifstream file (fileName, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "Failed to open " << fileName << "." << std::endl;
+		return false;
+	}
+	
+	// The header is a set of text lines, ending with a blank one.
+	std::string line;
+	if (!std::getline(file, line) || (line.compare(0, 2, "#?") != 0))
+	{
+		std::cout << fileName << " is not a Radiance HDR file." << std::endl;
+		return false;
+	}
+	
+	while (std::getline(file, line) && !line.empty())
+	{
+		if ((line.compare(0, 7, "FORMAT=") == 0) && (line != "FORMAT=32-bit_rle_rgbe"))
+		{
+			std::cout << "Unsupported HDR format " << line.substr(7) << "." << std::endl;
+			return false;
+		}
+	}
+	
+	// Followed by the resolution.
+	char yAxis[3];
+	char xAxis[3];
+	if (!std::getline(file, line) || (sscanf(line.c_str(), "%2s %d %2s %d", yAxis, &ySize, xAxis, &xSize) != 4) ||
+			(std::string(yAxis) != "-Y") || (std::string(xAxis) != "+X") || (xSize <= 0) || (ySize <= 0))
+	{
+		std::cout << "Unsupported HDR resolution line in " << fileName << "." << std::endl;
+		return false;
+	}
+	
+	// Refuse images of more than 2^27 pixels (16384 by 8192), rather than try to allocate them.
+	if ((static_cast<int64_t>(xSize) * ySize) > (int64_t(1) << 27))
+	{
+		std::cout << fileName << " is too large, at " << xSize << " by " << ySize << "." << std::endl;
+		return false;
+	}
+	
+	// Decode each scanline, converting the shared exponent to floating point.
+	rgba.assign(static_cast<std::size_t>(xSize) * ySize * 4, 1.0f);
+	std::vector<uint8_t> scanline (static_cast<std::size_t>(xSize) * 4);
+	for (int y=0; y<ySize; ++y)
+	{
+		if (!ReadScanline(file, xSize, scanline))
+		{
+			std::cout << "Failed to read scanline " << y << " of " << fileName << "." << std::endl;
+			return false;
+		}
+		
+		for (int x=0; x<xSize; ++x)
+		{
+			const uint8_t *pixel = &scanline[x * 4];
+			float scale = (pixel[3] == 0) ? 0.0f : static_cast<float>(ldexp(1.0, pixel[3] - (128 + 8)));
+			std::size_t index = ((static_cast<std::size_t>(y) * xSize) + x) * 4;
+			for (int c=0; c<3; ++c)
+				rgba[index + c] = (static_cast<float>(pixel[c]) + 0.5f) * scale;
+		}
+	}
+	
+	std::cout << "Loaded " << xSize << " by " << ySize << " HDR image." << std::endl;
+	return true;
+}
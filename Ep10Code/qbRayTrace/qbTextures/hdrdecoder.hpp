@@ -0,0 +1,38 @@
+/* ***********************************************************
+	hdrdecoder.hpp
+	
+	A function to load a Radiance HDR (RGBE) image file and decode
+	it into linear RGBA values.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef HDRDECODER_H
+#define HDRDECODER_H
+
+#include <string>
+#include <vector>
+
+namespace qbRT
+{
+	namespace Texture
+	{
+		/* Function to load a Radiance HDR image and decode it into RGBA values, four
+			per texel, with rows running from the top of the image down. The values are
+			linear and unbounded, and alpha is always one. Both flat and run-length
+			encoded scanlines are read, but only the standard -Y +X orientation. */
+		bool DecodeHDR(const std::string &fileName, int &xSize, int &ySize, std::vector<float> &rgba);
+	}
+}
+
+#endif
@@ -18,6 +18,8 @@
 ***********************************************************/
 
 #include "image.hpp"
+#include <algorithm>
+#include <sstream>
 
 // Constructor / destructor.
 qbRT::Texture::Image::Image()
@@ -27,124 +29,197 @@ qbRT::Texture::Image::Image()
 
 qbRT::Texture::Image::~Image()
 {
-	if (m_imageLoaded)
-	{
-		// Make sure that we free the image surface.
-		SDL_FreeSurface(m_imageSurface);
-		m_imageLoaded = false;
-	}
+
 }
 
+// Function to return the color.
 qbVector<double> qbRT::Texture::Image::GetColor(const qbVector<double> &uvCoords)
 {
-	qbVector<double> outputColor {4};
+	// With no footprint, use the fixed level of detail.
+	return GetColor(uvCoords, -1.0);
+}
+
+// Function to return the color filtered over the given footprint.
+qbVector<double> qbRT::Texture::Image::GetColor(const qbVector<double> &uvCoords, double footprint)
+{
+	double rgba[4];
+	SampleColor(uvCoords.GetElement(0), uvCoords.GetElement(1), footprint, rgba);
+	return GetColorVector(rgba);
+}
+
+// Function to write the color filtered over the given footprint into an array.
+void qbRT::Texture::Image::SampleColor(double inputU, double inputV, double footprint, double *rgba)
+{
+	// Wait for the image, if it is still loading.
+	const TexelSource *texels = GetTexels();
 	
-	if (!m_imageLoaded)
+	if (!texels)
 	{
 		/* If no image has been loaded yet,
 			set the color to the default purple 
 			regardless of the (u,v) position. */
-		outputColor = qbVector<double>{std::vector<double>{1.0, 0.0, 1.0, 1.0}};
+		rgba[0] = 1.0;
+		rgba[1] = 0.0;
+		rgba[2] = 1.0;
+		rgba[3] = 1.0;
 	}
 	else
 	{
 		// Apply the local transform to the (u,v) coordinates.
-		qbVector<double> inputLoc = uvCoords;
-		qbVector<double> newLoc = ApplyTransform(inputLoc);		
-		double u = newLoc.GetElement(0);
-		double v = newLoc.GetElement(1);
+		double u, v;
+		ApplyTransform(inputU, inputV, u, v);
 		
-		// Convert (u,v) to image dimensions (x,y).
-		int x = static_cast<int>(round(((u + 1.0) / 2.0) * static_cast<double>(m_xSize)));
-		int y = m_ySize - (static_cast<int>(round(((v + 1.0) / 2.0) * static_cast<double>(m_ySize))));
-		
-		/* Modulo arithmetic to account for possible tiling.
-			For example:
-			m_xSize = 10;
-			x = 5 =>
-				((5 % 10) + 10) % 10 = 5
+		switch (m_filter)
+		{
+			case Filter::Nearest:
+				GetNearestColor(*texels, u, v, rgba);
+				break;
 				
-			x = 10 =>
-				((10 % 10) + 10) % 10 = 0
+			case Filter::Bilinear:
+				GetFilteredColor(*texels, u, v, 0.0, rgba);
+				break;
 				
-			x = 11 =>
-				((11 % 10) + 10) % 10 = 1	
+			case Filter::Trilinear:
+			{
+				/* Convert the footprint into texels of the full resolution image.
+					The (u,v) range of 2.0 spans the whole image. */
+				double lod = m_lod;
+				if (footprint > 0.0)
+				{
+					double texelsPerUnit = static_cast<double>(std::max(texels->GetXSize(0), texels->GetYSize(0))) / 2.0;
+					double width = footprint * GetTransformScale() * texelsPerUnit;
+					lod = (width > 1.0) ? log2(width) : 0.0;
+				}
+				GetFilteredColor(*texels, u, v, lod, rgba);
+				break;
+			}
+		}
+	}
+}
+
+// Function to return the color from the original image with no filtering.
+void qbRT::Texture::Image::GetNearestColor(const TexelSource &texels, double u, double v, double *rgba)
+{
+	int xSize = texels.GetXSize(0);
+	int ySize = texels.GetYSize(0);
+	
+	// Convert (u,v) to image dimensions (x,y).
+	int x = static_cast<int>(round(((u + 1.0) / 2.0) * static_cast<double>(xSize)));
+	int y = ySize - (static_cast<int>(round(((v + 1.0) / 2.0) * static_cast<double>(ySize))));
+	
+	/* Modulo arithmetic to account for possible tiling.
+		For example:
+		xSize = 10;
+		x = 5 =>
+			((5 % 10) + 10) % 10 = 5
 			
-			x = -1 =>
-				((-1 % 10) + 10) % 10 = 9
+		x = 10 =>
+			((10 % 10) + 10) % 10 = 0
 			
-			x = -5 =>
-				((-5 % 10) + 10) % 10 = 5
-				
-			x = -10 =>
-				((-10 % 10) + 10) % 10 = 0
-				
-			x = -11 =>
-				((-11 % 10) + 10) % 10 = 9  */
-				
-		x = ((x % m_xSize) + m_xSize) % m_xSize;
-		y = ((y % m_ySize) + m_ySize) % m_ySize;
+		x = 11 =>
+			((11 % 10) + 10) % 10 = 1	
 		
-		// Verify that we are within the image.
-		// Probably not necessary, but seems like a good idea just in case.
-		if ((x >= 0) && (x < m_xSize) && (y >= 0) && (y < m_ySize))
-		{
-			// Convert (x,y) to a linear index.
-			int pixelIndex = x + (y * (m_pitch / m_bytesPerPixel));
-			
-			// Get a pointer to the pixel data.
-			uint32_t *pixels = (uint32_t *)m_imageSurface->pixels;
+		x = -1 =>
+			((-1 % 10) + 10) % 10 = 9
+		
+		x = -5 =>
+			((-5 % 10) + 10) % 10 = 5
 			
-			// Extract the current pixel value.
-			uint32_t currentPixel = pixels[pixelIndex];
+		x = -10 =>
+			((-10 % 10) + 10) % 10 = 0
 			
-			// Convert to RGB.
-			uint8_t r, g, b, a;
-			SDL_GetRGBA(currentPixel, m_imageSurface->format, &r, &g, &b, &a);
+		x = -11 =>
+			((-11 % 10) + 10) % 10 = 9  */
 			
-			// Set the outputColor vector accordingly.
-			outputColor.SetElement(0, static_cast<double>(r) / 255.0);
-			outputColor.SetElement(1, static_cast<double>(g) / 255.0);
-			outputColor.SetElement(2, static_cast<double>(b) / 255.0);
-			outputColor.SetElement(3, static_cast<double>(a) / 255.0);
-		}
-	}
+	x = ((x % xSize) + xSize) % xSize;
+	y = ((y % ySize) + ySize) % ySize;
 	
-	return outputColor;
+	// Look up the texel from the full resolution level of the mip map.
+	texels.GetTexel(0, x, y, rgba);
 }
 
-bool qbRT::Texture::Image::LoadImage(std::string fileName)
+// Function to sample the mip map.
+void qbRT::Texture::Image::GetFilteredColor(const TexelSource &texels, double u, double v, double lod, double *rgba)
 {
-	if (m_imageLoaded)
-		SDL_FreeSurface(m_imageSurface);
+	int xSize = texels.GetXSize(0);
+	int ySize = texels.GetYSize(0);
 	
-	m_fileName = fileName;
-	m_imageSurface = SDL_LoadBMP(fileName.c_str());
+	/* Convert (u,v) to texel coordinates, matching the orientation used
+		by GetNearestColor, with texel (x,y) covering [x,x+1) x [y,y+1). */
+	double s = (((u + 1.0) / 2.0) * static_cast<double>(xSize)) + 0.5;
+	double t = static_cast<double>(ySize) - (((v + 1.0) / 2.0) * static_cast<double>(ySize)) + 0.5;
 	
-	if (!m_imageSurface)
-	{
-		std::cout << "Failed to load image. " << SDL_GetError() << "." << std::endl;
-		m_imageLoaded = false;
-		return false;
-	}
+	texels.SampleTrilinear(s, t, lod, rgba);
+}
 
-	// Extract useful information.
-	m_xSize = m_imageSurface->w;
-	m_ySize = m_imageSurface->h;
-	m_pitch = m_imageSurface->pitch;
-	m_pixelFormat = m_imageSurface->format;
-	m_bytesPerPixel = m_pixelFormat->BytesPerPixel;
-	m_rMask = m_pixelFormat->Rmask;
-	m_gMask = m_pixelFormat->Gmask;
-	m_bMask = m_pixelFormat->Bmask;
-	m_aMask = m_pixelFormat->Amask;
-	
-	std::cout << "Loaded " << m_imageSurface->w << " by " << m_imageSurface->h << "." << std::endl;
-	std::cout << "Bytes per pixel = " << +m_bytesPerPixel << std::endl;
-	std::cout << "Pitch = " << m_pitch << std::endl;
+// Function to return the options to load the image with.
+qbRT::Texture::TextureRegistry::Options qbRT::Texture::Image::GetLoadOptions() const
+{
+	TextureRegistry::Options options;
+	options.format = m_storageFormat;
+	options.linearize = m_linearize;
+	options.useTextureCache = m_useTextureCache;
+	return options;
+}
 
-	m_imageLoaded = true;
-	return true;
+// Function to load the image.
+bool qbRT::Texture::Image::LoadImage(std::string fileName)
+{
+	// Load through the registry, so that a file already loaded elsewhere is shared, and wait for it.
+	LoadImageAsync(fileName);
+	return GetTexels() != nullptr;
 }
 
+// Function to start loading the image in the background.
+void qbRT::Texture::Image::LoadImageAsync(std::string fileName)
+{
+	m_fileName = fileName;
+	m_texels = TextureRegistry::GetShared().Load(fileName, GetLoadOptions());
+	m_resolvedTexels = ResolvedTexels();
+}
 
+// Function to use texels that have already been loaded or generated.
+void qbRT::Texture::Image::SetTexels(const std::shared_ptr<TexelSource> &texels)
+{
+	m_fileName.clear();
+	std::promise<std::shared_ptr<TexelSource>> ready;
+	ready.set_value(texels);
+	m_texels = ready.get_future().share();
+	m_resolvedTexels = ResolvedTexels();
+}
+
+// Function to return the texels.
+const qbRT::Texture::TexelSource *qbRT::Texture::Image::GetTexels()
+{
+	/* After the first lookup the pointer is simply read. Threads that arrive before
+		it is stored all wait on the same handle and store the same pointer. */
+	if (m_resolvedTexels.resolved.load(std::memory_order_acquire))
+		return m_resolvedTexels.texels.load(std::memory_order_relaxed);
+		
+	const TexelSource *texels = m_texels.valid() ? m_texels.get().get() : nullptr;
+	if (m_texels.valid())
+	{
+		m_resolvedTexels.texels.store(texels, std::memory_order_relaxed);
+		m_resolvedTexels.resolved.store(true, std::memory_order_release);
+	}
+	return texels;
+}
+
+// Function to return whether the footprint is used.
+bool qbRT::Texture::Image::UsesFootprint() const
+{
+	return m_filter == Filter::Trilinear;
+}
+
+// Function to return the parameter key.
+std::string qbRT::Texture::Image::GetParameterKey()
+{
+	// Texels that did not come from a file cannot be identified.
+	if (m_fileName.empty())
+		return std::string();
+	
+	std::ostringstream key;
+	key << std::hexfloat << "Image;" << m_fileName << ";" << GetTransformKey() << ";" << static_cast<int>(m_filter) << "," << m_lod << ","
+			<< static_cast<int>(m_storageFormat) << "," << m_linearize;
+	return key.str();
+}
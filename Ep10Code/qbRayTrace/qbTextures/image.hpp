@@ -21,7 +21,9 @@
 #define IMAGE_H
 
 #include "texturebase.hpp"
-#include <SDL2/SDL.h>
+#include "textureregistry.hpp"
+#include <string>
+#include <atomic>
 
 namespace qbRT
 {
@@ -29,25 +31,97 @@ namespace qbRT
 	{
 		class Image : public TextureBase
 		{
+			public:
+				// The available filtering modes.
+				enum class Filter {Nearest, Bilinear, Trilinear};
+				
 			public:
 				Image();
 				virtual ~Image() override;
 				
 				// Function to return the color.
 				virtual qbVector<double> GetColor(const qbVector<double> &uvCoords) override;
+				
+				// Function to return the color filtered over the given footprint.
+				virtual qbVector<double> GetColor(const qbVector<double> &uvCoords, double footprint) override;
+				virtual void SampleColor(double u, double v, double footprint, double *rgba) override;
 			
-				// Function to load the image to be used.
+				/* Function to load the image to be used. Tiled texture files (.qbtx) are
+					memory mapped, or read through the shared texture cache, so that only the
+					tiles that are sampled are read; anything else is loaded as a bitmap and
+					held in memory. */
 				bool LoadImage(std::string fileName);
 				
+				/* Function to start loading the image in the background, through the
+					shared texture registry, and return straight away. The first lookup
+					waits for the load to finish if it has not already done so. */
+				void LoadImageAsync(std::string fileName);
+				
+				// Function to use texels that have already been loaded or generated, rather than a file.
+				void SetTexels(const std::shared_ptr<TexelSource> &texels);
+				
+				// Function to return the parameter key.
+				virtual std::string GetParameterKey() override;
+				
+				// Function to return whether the footprint is used, which it is only for trilinear filtering.
+				virtual bool UsesFootprint() const override;
+				
+			public:
+				/* The filtering mode, and the level of detail used for trilinear
+					filtering when no footprint is given (0 is full resolution). The
+					default is the nearest texel, as images have always been sampled;
+					choose Bilinear or Trilinear to filter. */
+				Filter m_filter = Filter::Nearest;
+				double m_lod = 0.0;
+				
+				/* The format that the image is stored in once loaded, and whether the
+					image should be treated as sRGB encoded and converted to linear values.
+					These must be set before calling LoadImage, and do not apply to tiled
+					files, which record their own format. */
+				TexelSource::Format m_storageFormat = TexelSource::Format::RGBA8;
+				bool m_linearize = false;
+				
+				/* Whether tiled files are read through the shared texture cache, which keeps
+					to a fixed memory budget, rather than memory mapped. */
+				bool m_useTextureCache = false;
+				
+			private:
+				/* The texels once the load has finished, so that lookups need not wait on
+					the handle each time. A copy starts from the state of the original. */
+				struct ResolvedTexels
+				{
+					ResolvedTexels() {}
+					ResolvedTexels(const ResolvedTexels &other) : texels(other.texels.load()), resolved(other.resolved.load()) {}
+					ResolvedTexels &operator=(const ResolvedTexels &other)
+					{
+						texels.store(other.texels.load());
+						resolved.store(other.resolved.load());
+						return *this;
+					}
+					
+					std::atomic<const TexelSource *> texels {nullptr};
+					std::atomic<bool> resolved {false};
+				};
+				
 			private:
+				// Function to return the options to load the image with.
+				TextureRegistry::Options GetLoadOptions() const;
+				
+				// Function to return the color from the original image with no filtering.
+				void GetNearestColor(const TexelSource &texels, double u, double v, double *rgba);
+				
+				// Function to sample the mip map at the given (u,v) and level of detail.
+				void GetFilteredColor(const TexelSource &texels, double u, double v, double lod, double *rgba);
+				
+				/* Function to return the texels, waiting for them the first time if they are
+					still loading, or null if none have been loaded. */
+				const TexelSource *GetTexels();
+				
+			private:
+				TextureRegistry::Handle m_texels;
+				ResolvedTexels m_resolvedTexels;
 				std::string m_fileName;
-				SDL_Surface *m_imageSurface;
-				SDL_PixelFormat *m_pixelFormat;
-				bool m_imageLoaded = false;
-				int m_xSize, m_ySize, m_pitch;
-				uint8_t m_bytesPerPixel;
-				uint32_t m_rMask, m_gMask, m_bMask, m_aMask;				
-							
+
 		};
 	}
 }
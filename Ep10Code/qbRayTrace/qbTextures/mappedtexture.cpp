@@ -0,0 +1,126 @@
+/* ***********************************************************
+	mappedtexture.cpp
+	
+	The MappedTexture class implementation - A source of texels for a
+	tiled texture file (.qbtx) that memory maps the whole file, so
+	that opening even a very large texture is instant and the
+	operating system only reads the pages that are sampled.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "mappedtexture.hpp"
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Constructor / destructor.
+qbRT::Texture::MappedTexture::MappedTexture()
+{
+
+}
+
+qbRT::Texture::MappedTexture::~MappedTexture()
+{
+	Close();
+}
+
+// Function to map a tiled file.
+bool qbRT::Texture::MappedTexture::Open(const std::string &fileName)
+{
+	Close();
+	
+	int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		std::cout << "Failed to open " << fileName << "." << std::endl;
+		return false;
+	}
+	
+	struct stat fileInfo;
+	if ((fstat(fileDescriptor, &fileInfo) != 0) || (fileInfo.st_size <= 0))
+	{
+		std::cout << "Failed to read the size of " << fileName << "." << std::endl;
+		close(fileDescriptor);
+		return false;
+	}
+	
+	// The mapping stays valid after the file is closed.
+	std::size_t dataSize = static_cast<std::size_t>(fileInfo.st_size);
+	void *mapping = mmap(nullptr, dataSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	close(fileDescriptor);
+	if (mapping == MAP_FAILED)
+	{
+		std::cout << "Failed to map " << fileName << "." << std::endl;
+		return false;
+	}
+	
+	m_data = static_cast<const uint8_t *>(mapping);
+	m_dataSize = dataSize;
+	
+	// Lookups jump around the file, so read-ahead would mostly fetch pages that are never used.
+	madvise(mapping, dataSize, MADV_RANDOM);
+	
+	/* Texels are read straight from the mapping, so Parse is given the whole of it,
+		to check that every level has texels and that all of its tiles lie within it. */
+	if (!TiledFormat::Parse(m_data, m_dataSize, m_dataSize, m_header, m_levels))
+	{
+		std::cout << fileName << " is not a valid tiled texture file." << std::endl;
+		Close();
+		return false;
+	}
+	
+	return true;
+}
+
+// Function to unmap the file.
+void qbRT::Texture::MappedTexture::Close()
+{
+	if (m_data)
+	{
+		munmap(const_cast<uint8_t *>(m_data), m_dataSize);
+		m_data = nullptr;
+		m_dataSize = 0;
+	}
+	m_levels.clear();
+}
+
+// Functions to return the number of levels and the size of each level.
+int qbRT::Texture::MappedTexture::GetNumLevels() const
+{
+	return static_cast<int>(m_levels.size());
+}
+
+int qbRT::Texture::MappedTexture::GetXSize(int level) const
+{
+	return m_levels.at(level).xSize;
+}
+
+int qbRT::Texture::MappedTexture::GetYSize(int level) const
+{
+	return m_levels.at(level).ySize;
+}
+
+// Function to return a single texel.
+void qbRT::Texture::MappedTexture::GetTexel(int level, int x, int y, double *rgba) const
+{
+	const TiledFormat::LevelInfo &levelInfo = m_levels[level];
+	x = ((x % levelInfo.xSize) + levelInfo.xSize) % levelInfo.xSize;
+	y = ((y % levelInfo.ySize) + levelInfo.ySize) % levelInfo.ySize;
+	
+	// The tile is read straight from the mapping.
+	const uint8_t *tile = m_data + TiledFormat::GetTileOffset(m_header, levelInfo, x / m_header.tileSize, y / m_header.tileSize);
+	TiledFormat::DecodeTexel(m_header, tile, x % m_header.tileSize, y % m_header.tileSize, rgba);
+}
@@ -0,0 +1,70 @@
+/* ***********************************************************
+	mappedtexture.hpp
+	
+	The MappedTexture class definition - A source of texels for a
+	tiled texture file (.qbtx) that memory maps the whole file, so
+	that opening even a very large texture is instant and the
+	operating system only reads the pages that are sampled.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef MAPPEDTEXTURE_H
+#define MAPPEDTEXTURE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "texelsource.hpp"
+#include "tiledformat.hpp"
+
+namespace qbRT
+{
+	namespace Texture
+	{
+		class MappedTexture : public TexelSource
+		{
+			public:
+				// Constructor / destructor.
+				MappedTexture();
+				virtual ~MappedTexture() override;
+				
+				// The mapping is owned, and so is not copyable.
+				MappedTexture(const MappedTexture &) = delete;
+				MappedTexture &operator= (const MappedTexture &) = delete;
+				
+				// Function to map a tiled file.
+				bool Open(const std::string &fileName);
+				
+				// Function to unmap the file.
+				void Close();
+				
+				// Functions to return the number of levels and the size of each level.
+				virtual int GetNumLevels() const override;
+				virtual int GetXSize(int level) const override;
+				virtual int GetYSize(int level) const override;
+				
+				// Function to return a single texel, wrapping x and y into the image.
+				virtual void GetTexel(int level, int x, int y, double *rgba) const override;
+				
+			private:
+				const uint8_t *m_data = nullptr;
+				std::size_t m_dataSize = 0;
+				TiledFormat::Header m_header;
+				std::vector<TiledFormat::LevelInfo> m_levels;
+		};
+	}
+}
+
+#endif
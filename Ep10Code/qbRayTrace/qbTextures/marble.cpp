@@ -0,0 +1,54 @@
+/* ***********************************************************
+	marble.cpp
+	
+	The Marble class implementation - A noise texture of veins, made
+	by bending regular stripes with fBm turbulence.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "marble.hpp"
+#include <cmath>
+#include <sstream>
+
+// Constructor / destructor.
+qbRT::Texture::Noise::Marble::Marble()
+{
+	m_color1 = qbVector<double>{std::vector<double>{0.9, 0.9, 0.85, 1.0}};
+	m_color2 = qbVector<double>{std::vector<double>{0.3, 0.3, 0.35, 1.0}};
+}
+
+qbRT::Texture::Noise::Marble::~Marble()
+{
+
+}
+
+// Function to return the color.
+void qbRT::Texture::Noise::Marble::SampleColor(double inputU, double inputV, double, double *rgba)
+{
+	// Apply the local transform to the (u,v) coordinates.
+	double u, v;
+	ApplyTransform(inputU, inputV, u, v);
+	
+	// Bend the stripes with fBm, and map the result to the range [0,1].
+	double value = sin(((u * m_frequency) + (m_turbulence * FBm2D(u, v))) * M_PI);
+	BlendColor(0.5 + (0.5 * value), rgba);
+}
+
+// Function to return the parameters of this pattern.
+std::string qbRT::Texture::Noise::Marble::GetPatternKey()
+{
+	std::ostringstream key;
+	key << std::hexfloat << "Marble," << m_frequency << "," << m_turbulence;
+	return key.str();
+}
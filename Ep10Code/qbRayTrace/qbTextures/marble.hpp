@@ -0,0 +1,54 @@
+/* ***********************************************************
+	marble.hpp
+	
+	The Marble class definition - A noise texture of veins, made
+	by bending regular stripes with fBm turbulence.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef MARBLE_H
+#define MARBLE_H
+
+#include "noisebase.hpp"
+
+namespace qbRT
+{
+	namespace Texture
+	{
+		namespace Noise
+		{
+			class Marble : public NoiseBase
+			{
+				public:
+					// Constructor / destructor.
+					Marble();
+					virtual ~Marble() override;
+					
+					// Function to return the color.
+					virtual void SampleColor(double u, double v, double footprint, double *rgba) override;
+					
+				protected:
+					// Function to return the parameters of this pattern.
+					virtual std::string GetPatternKey() override;
+					
+				public:
+					// The number of stripes across the (u,v) range, and how strongly they are bent.
+					double m_frequency = 2.0;
+					double m_turbulence = 4.0;
+			};
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,211 @@
+/* ***********************************************************
+	mipmap.cpp
+	
+	The MipMap class implementation - A class to store a pyramid of
+	successively half-sized copies of an image (a mip map) and to
+	sample it with bilinear or trilinear filtering.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "mipmap.hpp"
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+// Function to interleave the low three bits of x and y to give the position within a block.
+static inline int BlockMorton(int x, int y)
+{
+	return	(x & 1) | ((y & 1) << 1) |
+					((x & 2) << 1) | ((y & 2) << 2) |
+					((x & 4) << 2) | ((y & 4) << 3);
+}
+
+/* Function to return, for each texel of a row of the given new size, the texels
+	of the old row that it covers and the fraction of it that each one makes up. */
+static std::vector<std::vector<std::pair<int, float>>> BoxWeights(int oldSize, int newSize)
+{
+	std::vector<std::vector<std::pair<int, float>>> weights (newSize);
+	double ratio = static_cast<double>(oldSize) / static_cast<double>(newSize);
+	for (int i=0; i<newSize; ++i)
+	{
+		double start = i * ratio;
+		double end = (i + 1) * ratio;
+		for (int j=static_cast<int>(floor(start)); j<std::min(oldSize, static_cast<int>(ceil(end))); ++j)
+		{
+			double overlap = std::min(end, j + 1.0) - std::max(start, static_cast<double>(j));
+			if (overlap > 0.0)
+				weights.at(i).push_back({j, static_cast<float>(overlap / ratio)});
+		}
+	}
+	return weights;
+}
+
+// Constructor / destructor.
+qbRT::Texture::MipMap::MipMap()
+{
+
+}
+
+qbRT::Texture::MipMap::~MipMap()
+{
+
+}
+
+// Function to release all of the levels.
+void qbRT::Texture::MipMap::Clear()
+{
+	m_levels.clear();
+}
+
+// Function to build the pyramid.
+void qbRT::Texture::MipMap::Build(int xSize, int ySize, const std::vector<float> &rgba, Format format, bool sRGB)
+{
+	m_levels.clear();
+	m_format = format;
+	m_sRGB = sRGB && (format == Format::RGBA8);
+	m_decodeTable = GetDecodeTable(m_sRGB);
+	
+	// Start with a plain row-major copy of the input.
+	std::vector<float> current = rgba;
+	int currentX = xSize;
+	int currentY = ySize;
+	while (true)
+	{
+		// Store this level in the blocked layout.
+		Level level;
+		level.xSize = currentX;
+		level.ySize = currentY;
+		level.blocksX = (currentX + MIPBLOCKSIZE - 1) / MIPBLOCKSIZE;
+		int blocksY = (currentY + MIPBLOCKSIZE - 1) / MIPBLOCKSIZE;
+		int numValues = level.blocksX * blocksY * MIPBLOCKSIZE * MIPBLOCKSIZE * 4;
+		if (m_format == Format::RGBA8)
+			level.texels8.assign(numValues, 0);
+		else
+			level.texels32F.assign(numValues, 0.0f);
+		m_levels.push_back(std::move(level));
+		
+		Level &newLevel = m_levels.back();
+		int levelIndex = static_cast<int>(m_levels.size()) - 1;
+		for (int y=0; y<currentY; ++y)
+		{
+			for (int x=0; x<currentX; ++x)
+			{
+				int index = TexelIndex(levelIndex, x, y);
+				const float *source = &current.at(((y * currentX) + x) * 4);
+				if (m_format == Format::RGBA8)
+				{
+					// Alpha is always stored linearly.
+					for (int c=0; c<3; ++c)
+						newLevel.texels8.at(index + c) = m_sRGB ? LinearToSRGB(source[c]) : LinearToByte(source[c]);
+					newLevel.texels8.at(index + 3) = LinearToByte(source[3]);
+				}
+				else
+				{
+					for (int c=0; c<4; ++c)
+						newLevel.texels32F.at(index + c) = source[c];
+				}
+			}
+		}
+		
+		// Stop once we reach a single texel.
+		if ((currentX == 1) && (currentY == 1))
+			break;
+			
+		// Compute the next level.
+		int nextX, nextY;
+		std::vector<float> next;
+		Downsample(currentX, currentY, current, nextX, nextY, next);
+		
+		current.swap(next);
+		currentX = nextX;
+		currentY = nextY;
+	}
+}
+
+// Function to compute the next level down.
+void qbRT::Texture::MipMap::Downsample(	int xSize, int ySize, const std::vector<float> &rgba,
+																				int &nextXSize, int &nextYSize, std::vector<float> &nextRGBA)
+{
+	/* Each new texel is the average of the part of the current level that it
+		covers, so that odd sizes are handled without dropping the last row or column. */
+	nextXSize = std::max(1, xSize / 2);
+	nextYSize = std::max(1, ySize / 2);
+	std::vector<std::vector<std::pair<int, float>>> xWeights = BoxWeights(xSize, nextXSize);
+	std::vector<std::vector<std::pair<int, float>>> yWeights = BoxWeights(ySize, nextYSize);
+	nextRGBA.assign(nextXSize * nextYSize * 4, 0.0f);
+	for (int y=0; y<nextYSize; ++y)
+	{
+		for (int x=0; x<nextXSize; ++x)
+		{
+			float *target = &nextRGBA.at(((y * nextXSize) + x) * 4);
+			for (auto &yw : yWeights.at(y))
+			{
+				for (auto &xw : xWeights.at(x))
+				{
+					float weight = xw.second * yw.second;
+					const float *source = &rgba.at(((yw.first * xSize) + xw.first) * 4);
+					for (int c=0; c<4; ++c)
+						target[c] += source[c] * weight;
+				}
+			}
+		}
+	}
+}
+
+// Functions to return the number of levels and the size of each level.
+int qbRT::Texture::MipMap::GetNumLevels() const
+{
+	return static_cast<int>(m_levels.size());
+}
+
+int qbRT::Texture::MipMap::GetXSize(int level) const
+{
+	return m_levels.at(level).xSize;
+}
+
+int qbRT::Texture::MipMap::GetYSize(int level) const
+{
+	return m_levels.at(level).ySize;
+}
+
+// Function to return the index of the first value of a texel within a level.
+int qbRT::Texture::MipMap::TexelIndex(int level, int x, int y) const
+{
+	int block = ((y / MIPBLOCKSIZE) * m_levels[level].blocksX) + (x / MIPBLOCKSIZE);
+	int offset = BlockMorton(x % MIPBLOCKSIZE, y % MIPBLOCKSIZE);
+	return ((block * MIPBLOCKSIZE * MIPBLOCKSIZE) + offset) * 4;
+}
+
+// Function to return a single texel.
+void qbRT::Texture::MipMap::GetTexel(int level, int x, int y, double *rgba) const
+{
+	const Level &currentLevel = m_levels[level];
+	x = ((x % currentLevel.xSize) + currentLevel.xSize) % currentLevel.xSize;
+	y = ((y % currentLevel.ySize) + currentLevel.ySize) % currentLevel.ySize;
+	int index = TexelIndex(level, x, y);
+	if (m_format == Format::RGBA8)
+	{
+		const uint8_t *texel = &currentLevel.texels8[index];
+		rgba[0] = m_decodeTable[texel[0]];
+		rgba[1] = m_decodeTable[texel[1]];
+		rgba[2] = m_decodeTable[texel[2]];
+		rgba[3] = static_cast<double>(texel[3]) / 255.0;
+	}
+	else
+	{
+		const float *texel = &currentLevel.texels32F[index];
+		for (int c=0; c<4; ++c)
+			rgba[c] = texel[c];
+	}
+}
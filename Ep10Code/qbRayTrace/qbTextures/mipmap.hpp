@@ -0,0 +1,97 @@
+/* ***********************************************************
+	mipmap.hpp
+	
+	The MipMap class definition - A class to store a pyramid of
+	successively half-sized copies of an image (a mip map) and to
+	sample it with bilinear or trilinear filtering.
+	
+	The whole pyramid is held in memory. Each level is stored in
+	blocks of 8 x 8 texels, with the texels inside each block in
+	Morton (Z-order) order, so that texels that are close together
+	in the image are close together in memory. Texels are held
+	either as 8 bit or as 32 bit float RGBA, in cache line aligned
+	storage that the class owns.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <vector>
+#include <cstdint>
+#include "texelsource.hpp"
+#include "../alignedallocator.hpp"
+
+namespace qbRT
+{
+	namespace Texture
+	{
+		// The width and height, in texels, of the blocks that each level is stored in.
+		constexpr int MIPBLOCKSIZE = 8;
+		
+		class MipMap : public TexelSource
+		{
+			public:
+				// Constructor / destructor.
+				MipMap();
+				virtual ~MipMap() override;
+				
+				/* Function to build the pyramid from an image given as linear RGBA
+					values, four per texel, with rows running from the top of the image
+					down. If sRGB is set, RGBA8 storage holds the color channels sRGB
+					encoded, which keeps more precision in the darker tones, and they are
+					decoded back to linear values by the lookups. */
+				void Build(int xSize, int ySize, const std::vector<float> &rgba, Format format, bool sRGB);
+				
+				// Function to release all of the levels.
+				void Clear();
+				
+				/* Function to compute the next level down from a level given as
+					row-major RGBA values, using an area weighted box filter. */
+				static void Downsample(	int xSize, int ySize, const std::vector<float> &rgba,
+																int &nextXSize, int &nextYSize, std::vector<float> &nextRGBA);
+				
+				// Functions to return the number of levels and the size of each level.
+				virtual int GetNumLevels() const override;
+				virtual int GetXSize(int level) const override;
+				virtual int GetYSize(int level) const override;
+				
+				// Function to return a single texel, wrapping x and y into the image.
+				virtual void GetTexel(int level, int x, int y, double *rgba) const override;
+				
+			private:
+				// Function to return the index of the first value of a texel within a level.
+				int TexelIndex(int level, int x, int y) const;
+				
+			private:
+				struct Level
+				{
+					int xSize;
+					int ySize;
+					int blocksX;
+					
+					// Only the vector matching the storage format is used.
+					std::vector<uint8_t, AlignedAllocator<uint8_t>> texels8;
+					std::vector<float, AlignedAllocator<float>> texels32F;
+				};
+				
+				std::vector<Level> m_levels;
+				Format m_format = Format::RGBA8;
+				bool m_sRGB = false;
+				const double *m_decodeTable = GetDecodeTable(false);
+		};
+	}
+}
+
+#endif
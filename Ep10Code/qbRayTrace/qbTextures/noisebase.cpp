@@ -0,0 +1,396 @@
+/* ***********************************************************
+	noisebase.cpp
+	
+	The NoiseBase class implementation - A base class for procedural
+	textures built from noise. It provides 2D and 3D gradient (Perlin)
+	noise, fractal Brownian motion (fBm) built from several octaves of
+	it, and Worley (cellular) noise.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "noisebase.hpp"
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <sstream>
+
+// The 2D gradients; the four diagonals and the four axes.
+static const double GRAD2X[8] = {1.0, -1.0, 1.0, -1.0, 1.0, -1.0, 0.0, 0.0};
+static const double GRAD2Y[8] = {1.0, 1.0, -1.0, -1.0, 0.0, 0.0, 1.0, -1.0};
+
+// The 3D gradients; the twelve edges of a cube, with four repeated to make sixteen.
+static const double GRAD3X[16] = {1.0, -1.0, 1.0, -1.0, 1.0, -1.0, 1.0, -1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, -1.0, 0.0};
+static const double GRAD3Y[16] = {1.0, 1.0, -1.0, -1.0, 0.0, 0.0, 0.0, 0.0, 1.0, -1.0, 1.0, -1.0, 1.0, -1.0, 1.0, -1.0};
+static const double GRAD3Z[16] = {0.0, 0.0, 0.0, 0.0, 1.0, 1.0, -1.0, -1.0, 1.0, 1.0, -1.0, -1.0, 0.0, 1.0, 0.0, -1.0};
+
+// The fade curve, 6t^5 - 15t^4 + 10t^3.
+static inline double Fade(double t)
+{
+	return t * t * t * ((t * ((t * 6.0) - 15.0)) + 10.0);
+}
+
+static inline double Lerp(double a, double b, double t)
+{
+	return a + (t * (b - a));
+}
+
+// Constructor / destructor.
+qbRT::Texture::Noise::NoiseBase::NoiseBase()
+{
+	SetSeed(0);
+}
+
+qbRT::Texture::Noise::NoiseBase::~NoiseBase()
+{
+
+}
+
+// Function to set the seed.
+void qbRT::Texture::Noise::NoiseBase::SetSeed(unsigned int seed)
+{
+	m_seed = seed;
+	
+	// Shuffle the numbers 0 to 255, and then repeat them.
+	for (int i=0; i<256; ++i)
+		m_perm[i] = static_cast<uint8_t>(i);
+		
+	std::mt19937 generator (seed);
+	for (int i=255; i>0; --i)
+	{
+		int j = static_cast<int>(generator() % static_cast<unsigned int>(i + 1));
+		std::swap(m_perm[i], m_perm[j]);
+	}
+	
+	for (int i=0; i<256; ++i)
+		m_perm[i + 256] = m_perm[i];
+}
+
+// Function to set the colors.
+void qbRT::Texture::Noise::NoiseBase::SetColor(const qbVector<double> &inputColor1, const qbVector<double> &inputColor2)
+{
+	m_color1 = inputColor1;
+	m_color2 = inputColor2;
+}
+
+// Function to return the parameter key.
+std::string qbRT::Texture::Noise::NoiseBase::GetParameterKey()
+{
+	std::ostringstream key;
+	key << std::hexfloat << GetPatternKey() << ";" << GetTransformKey() << ";" << GetVectorKey(m_color1) << ";" << GetVectorKey(m_color2)
+			<< ";seed," << m_seed << ",octaves," << m_octaves << ",lacunarity," << m_lacunarity << ",gain," << m_gain;
+	return key.str();
+}
+
+// Function to return the color.
+qbVector<double> qbRT::Texture::Noise::NoiseBase::GetColor(const qbVector<double> &uvCoords)
+{
+	double rgba[4];
+	SampleColor(uvCoords.GetElement(0), uvCoords.GetElement(1), -1.0, rgba);
+	return GetColorVector(rgba);
+}
+
+// Function to blend between the two colors.
+void qbRT::Texture::Noise::NoiseBase::BlendColor(double t, double *rgba) const
+{
+	t = std::min(std::max(t, 0.0), 1.0);
+	for (int c=0; c<3; ++c)
+		rgba[c] = (m_color1.GetElement(c) * (1.0 - t)) + (m_color2.GetElement(c) * t);
+		
+	// Colors given without an alpha channel are opaque.
+	double alpha1 = (m_color1.GetNumDims() > 3) ? m_color1.GetElement(3) : 1.0;
+	double alpha2 = (m_color2.GetNumDims() > 3) ? m_color2.GetElement(3) : 1.0;
+	rgba[3] = (alpha1 * (1.0 - t)) + (alpha2 * t);
+}
+
+// Function to return 2D gradient noise at a single point.
+double qbRT::Texture::Noise::NoiseBase::Perlin2D(double x, double y) const
+{
+	// Split the point into its cell and its position within the cell.
+	double xFloor = floor(x);
+	double yFloor = floor(y);
+	int xi = static_cast<int>(xFloor) & 255;
+	int yi = static_cast<int>(yFloor) & 255;
+	double xf = x - xFloor;
+	double yf = y - yFloor;
+	double u = Fade(xf);
+	double v = Fade(yf);
+	
+	// Hash the four corners of the cell.
+	int a = m_perm[xi] + yi;
+	int b = m_perm[xi + 1] + yi;
+	int h00 = m_perm[a] & 7;
+	int h01 = m_perm[a + 1] & 7;
+	int h10 = m_perm[b] & 7;
+	int h11 = m_perm[b + 1] & 7;
+	
+	// Combine the contribution of each corner.
+	double n00 = (GRAD2X[h00] * xf) + (GRAD2Y[h00] * yf);
+	double n10 = (GRAD2X[h10] * (xf - 1.0)) + (GRAD2Y[h10] * yf);
+	double n01 = (GRAD2X[h01] * xf) + (GRAD2Y[h01] * (yf - 1.0));
+	double n11 = (GRAD2X[h11] * (xf - 1.0)) + (GRAD2Y[h11] * (yf - 1.0));
+	return Lerp(Lerp(n00, n10, u), Lerp(n01, n11, u), v);
+}
+
+// Function to return 3D gradient noise at a single point.
+double qbRT::Texture::Noise::NoiseBase::Perlin3D(double x, double y, double z) const
+{
+	// Split the point into its cell and its position within the cell.
+	double xFloor = floor(x);
+	double yFloor = floor(y);
+	double zFloor = floor(z);
+	int xi = static_cast<int>(xFloor) & 255;
+	int yi = static_cast<int>(yFloor) & 255;
+	int zi = static_cast<int>(zFloor) & 255;
+	double xf = x - xFloor;
+	double yf = y - yFloor;
+	double zf = z - zFloor;
+	double u = Fade(xf);
+	double v = Fade(yf);
+	double w = Fade(zf);
+	
+	// Hash the eight corners of the cell.
+	int a = m_perm[xi] + yi;
+	int b = m_perm[xi + 1] + yi;
+	int aa = m_perm[a] + zi;
+	int ab = m_perm[a + 1] + zi;
+	int ba = m_perm[b] + zi;
+	int bb = m_perm[b + 1] + zi;
+	int h[8] = {m_perm[aa] & 15, m_perm[ba] & 15, m_perm[ab] & 15, m_perm[bb] & 15,
+							m_perm[aa + 1] & 15, m_perm[ba + 1] & 15, m_perm[ab + 1] & 15, m_perm[bb + 1] & 15};
+							
+	// Combine the contribution of each corner, where corner c is offset by (c & 1, (c >> 1) & 1, c >> 2).
+	double n[8];
+	for (int c=0; c<8; ++c)
+	{
+		double dx = xf - static_cast<double>(c & 1);
+		double dy = yf - static_cast<double>((c >> 1) & 1);
+		double dz = zf - static_cast<double>(c >> 2);
+		n[c] = (GRAD3X[h[c]] * dx) + (GRAD3Y[h[c]] * dy) + (GRAD3Z[h[c]] * dz);
+	}
+	double y0 = Lerp(Lerp(n[0], n[1], u), Lerp(n[2], n[3], u), v);
+	double y1 = Lerp(Lerp(n[4], n[5], u), Lerp(n[6], n[7], u), v);
+	return Lerp(y0, y1, w);
+}
+
+// Function to return 2D gradient noise at several points at once.
+void qbRT::Texture::Noise::NoiseBase::Perlin2DLanes(const double *x, const double *y, double *result) const
+{
+	int xi[NOISELANES], yi[NOISELANES];
+	double xf[NOISELANES], yf[NOISELANES], u[NOISELANES], v[NOISELANES];
+	
+	// Split each point into its cell and its position within the cell.
+	for (int l=0; l<NOISELANES; ++l)
+	{
+		double xFloor = floor(x[l]);
+		double yFloor = floor(y[l]);
+		xi[l] = static_cast<int>(xFloor) & 255;
+		yi[l] = static_cast<int>(yFloor) & 255;
+		xf[l] = x[l] - xFloor;
+		yf[l] = y[l] - yFloor;
+		u[l] = Fade(xf[l]);
+		v[l] = Fade(yf[l]);
+	}
+	
+	// Hash the four corners of each cell.
+	int h00[NOISELANES], h10[NOISELANES], h01[NOISELANES], h11[NOISELANES];
+	for (int l=0; l<NOISELANES; ++l)
+	{
+		int a = m_perm[xi[l]] + yi[l];
+		int b = m_perm[xi[l] + 1] + yi[l];
+		h00[l] = m_perm[a] & 7;
+		h01[l] = m_perm[a + 1] & 7;
+		h10[l] = m_perm[b] & 7;
+		h11[l] = m_perm[b + 1] & 7;
+	}
+	
+	// Combine the contribution of each corner.
+	for (int l=0; l<NOISELANES; ++l)
+	{
+		double n00 = (GRAD2X[h00[l]] * xf[l]) + (GRAD2Y[h00[l]] * yf[l]);
+		double n10 = (GRAD2X[h10[l]] * (xf[l] - 1.0)) + (GRAD2Y[h10[l]] * yf[l]);
+		double n01 = (GRAD2X[h01[l]] * xf[l]) + (GRAD2Y[h01[l]] * (yf[l] - 1.0));
+		double n11 = (GRAD2X[h11[l]] * (xf[l] - 1.0)) + (GRAD2Y[h11[l]] * (yf[l] - 1.0));
+		result[l] = Lerp(Lerp(n00, n10, u[l]), Lerp(n01, n11, u[l]), v[l]);
+	}
+}
+
+// Function to return 3D gradient noise at several points at once.
+void qbRT::Texture::Noise::NoiseBase::Perlin3DLanes(const double *x, const double *y, const double *z, double *result) const
+{
+	int xi[NOISELANES], yi[NOISELANES], zi[NOISELANES];
+	double xf[NOISELANES], yf[NOISELANES], zf[NOISELANES];
+	double u[NOISELANES], v[NOISELANES], w[NOISELANES];
+	
+	// Split each point into its cell and its position within the cell.
+	for (int l=0; l<NOISELANES; ++l)
+	{
+		double xFloor = floor(x[l]);
+		double yFloor = floor(y[l]);
+		double zFloor = floor(z[l]);
+		xi[l] = static_cast<int>(xFloor) & 255;
+		yi[l] = static_cast<int>(yFloor) & 255;
+		zi[l] = static_cast<int>(zFloor) & 255;
+		xf[l] = x[l] - xFloor;
+		yf[l] = y[l] - yFloor;
+		zf[l] = z[l] - zFloor;
+		u[l] = Fade(xf[l]);
+		v[l] = Fade(yf[l]);
+		w[l] = Fade(zf[l]);
+	}
+	
+	// Hash the eight corners of each cell.
+	int h[8][NOISELANES];
+	for (int l=0; l<NOISELANES; ++l)
+	{
+		int a = m_perm[xi[l]] + yi[l];
+		int b = m_perm[xi[l] + 1] + yi[l];
+		int aa = m_perm[a] + zi[l];
+		int ab = m_perm[a + 1] + zi[l];
+		int ba = m_perm[b] + zi[l];
+		int bb = m_perm[b + 1] + zi[l];
+		h[0][l] = m_perm[aa] & 15;
+		h[1][l] = m_perm[ba] & 15;
+		h[2][l] = m_perm[ab] & 15;
+		h[3][l] = m_perm[bb] & 15;
+		h[4][l] = m_perm[aa + 1] & 15;
+		h[5][l] = m_perm[ba + 1] & 15;
+		h[6][l] = m_perm[ab + 1] & 15;
+		h[7][l] = m_perm[bb + 1] & 15;
+	}
+	
+	// Combine the contribution of each corner, where corner c is offset by (c & 1, (c >> 1) & 1, c >> 2).
+	for (int l=0; l<NOISELANES; ++l)
+	{
+		double n[8];
+		for (int c=0; c<8; ++c)
+		{
+			double dx = xf[l] - static_cast<double>(c & 1);
+			double dy = yf[l] - static_cast<double>((c >> 1) & 1);
+			double dz = zf[l] - static_cast<double>(c >> 2);
+			n[c] = (GRAD3X[h[c][l]] * dx) + (GRAD3Y[h[c][l]] * dy) + (GRAD3Z[h[c][l]] * dz);
+		}
+		double y0 = Lerp(Lerp(n[0], n[1], u[l]), Lerp(n[2], n[3], u[l]), v[l]);
+		double y1 = Lerp(Lerp(n[4], n[5], u[l]), Lerp(n[6], n[7], u[l]), v[l]);
+		result[l] = Lerp(y0, y1, w[l]);
+	}
+}
+
+// Function to return 2D fBm at a single point.
+double qbRT::Texture::Noise::NoiseBase::FBm2D(double x, double y) const
+{
+	double total = 0.0;
+	double totalAmplitude = 0.0;
+	double frequency = 1.0;
+	double amplitude = 1.0;
+	
+	// Evaluate the octaves NOISELANES at a time.
+	for (int octave=0; octave<m_octaves; octave+=NOISELANES)
+	{
+		double xs[NOISELANES], ys[NOISELANES], amplitudes[NOISELANES], noise[NOISELANES];
+		for (int l=0; l<NOISELANES; ++l)
+		{
+			// Lanes beyond the last octave are given no weight.
+			amplitudes[l] = ((octave + l) < m_octaves) ? amplitude : 0.0;
+			xs[l] = x * frequency;
+			ys[l] = y * frequency;
+			frequency *= m_lacunarity;
+			amplitude *= m_gain;
+		}
+		
+		Perlin2DLanes(xs, ys, noise);
+		
+		for (int l=0; l<NOISELANES; ++l)
+		{
+			total += noise[l] * amplitudes[l];
+			totalAmplitude += amplitudes[l];
+		}
+	}
+	
+	return (totalAmplitude > 0.0) ? total / totalAmplitude : 0.0;
+}
+
+// Function to return 3D fBm at a single point.
+double qbRT::Texture::Noise::NoiseBase::FBm3D(double x, double y, double z) const
+{
+	double total = 0.0;
+	double totalAmplitude = 0.0;
+	double frequency = 1.0;
+	double amplitude = 1.0;
+	
+	// Evaluate the octaves NOISELANES at a time.
+	for (int octave=0; octave<m_octaves; octave+=NOISELANES)
+	{
+		double xs[NOISELANES], ys[NOISELANES], zs[NOISELANES], amplitudes[NOISELANES], noise[NOISELANES];
+		for (int l=0; l<NOISELANES; ++l)
+		{
+			// Lanes beyond the last octave are given no weight.
+			amplitudes[l] = ((octave + l) < m_octaves) ? amplitude : 0.0;
+			xs[l] = x * frequency;
+			ys[l] = y * frequency;
+			zs[l] = z * frequency;
+			frequency *= m_lacunarity;
+			amplitude *= m_gain;
+		}
+		
+		Perlin3DLanes(xs, ys, zs, noise);
+		
+		for (int l=0; l<NOISELANES; ++l)
+		{
+			total += noise[l] * amplitudes[l];
+			totalAmplitude += amplitudes[l];
+		}
+	}
+	
+	return (totalAmplitude > 0.0) ? total / totalAmplitude : 0.0;
+}
+
+// Function to return Worley noise at a point.
+void qbRT::Texture::Noise::NoiseBase::Worley2D(double x, double y, double &f1, double &f2) const
+{
+	double xFloor = floor(x);
+	double yFloor = floor(y);
+	int xi = static_cast<int>(xFloor);
+	int yi = static_cast<int>(yFloor);
+	double xf = x - xFloor;
+	double yf = y - yFloor;
+	
+	// Find the squared distance to the feature point in this cell and each of its eight neighbours.
+	double distances[9];
+	for (int c=0; c<9; ++c)
+	{
+		int dx = (c % 3) - 1;
+		int dy = (c / 3) - 1;
+		int cellX = (xi + dx) & 255;
+		int cellY = (yi + dy) & 255;
+		int hash = m_perm[m_perm[cellX] + cellY];
+		double featureX = dx + (static_cast<double>(m_perm[hash]) / 256.0);
+		double featureY = dy + (static_cast<double>(m_perm[hash + 1]) / 256.0);
+		double ex = featureX - xf;
+		double ey = featureY - yf;
+		distances[c] = (ex * ex) + (ey * ey);
+	}
+	
+	// Pick out the two smallest.
+	double d1 = 1e30;
+	double d2 = 1e30;
+	for (int c=0; c<9; ++c)
+	{
+		double d = distances[c];
+		d2 = std::min(d2, std::max(d, d1));
+		d1 = std::min(d1, d);
+	}
+	
+	f1 = sqrt(d1);
+	f2 = sqrt(d2);
+}
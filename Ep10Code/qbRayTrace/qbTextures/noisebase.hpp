@@ -0,0 +1,110 @@
+/* ***********************************************************
+	noisebase.hpp
+	
+	The NoiseBase class definition - A base class for procedural
+	textures built from noise. It provides 2D and 3D gradient (Perlin)
+	noise, fractal Brownian motion (fBm) built from several octaves of
+	it, and Worley (cellular) noise.
+	
+	The kernels work on NOISELANES values at once, either several
+	octaves of a single point or several separate points, with every
+	step written as a simple loop across the lanes so that the
+	compiler can turn each one into SIMD instructions. The permutation
+	and gradient tables together take under 1 KB, and so stay in the
+	L1 cache.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef NOISEBASE_H
+#define NOISEBASE_H
+
+#include <cstdint>
+#include "texturebase.hpp"
+
+namespace qbRT
+{
+	namespace Texture
+	{
+		namespace Noise
+		{
+			// The number of values that the kernels work on at once.
+			constexpr int NOISELANES = 4;
+			
+			class NoiseBase : public TextureBase
+			{
+				public:
+					// Constructor / destructor.
+					NoiseBase();
+					virtual ~NoiseBase() override;
+					
+					// Function to set the seed used to shuffle the permutation table.
+					void SetSeed(unsigned int seed);
+					
+					// Function to set the two colors that the pattern blends between.
+					void SetColor(const qbVector<double> &inputColor1, const qbVector<double> &inputColor2);
+					
+					// Functions to return gradient noise at a single point, in the range of about [-1,1].
+					double Perlin2D(double x, double y) const;
+					double Perlin3D(double x, double y, double z) const;
+					
+					// Functions to return gradient noise at NOISELANES points at once.
+					void Perlin2DLanes(const double *x, const double *y, double *result) const;
+					void Perlin3DLanes(const double *x, const double *y, const double *z, double *result) const;
+					
+					/* Functions to return fBm at a single point, summing m_octaves octaves of
+						gradient noise, each m_lacunarity times the frequency and m_gain times
+						the amplitude of the one before. The result is normalised to about [-1,1]. */
+					double FBm2D(double x, double y) const;
+					double FBm3D(double x, double y, double z) const;
+					
+					/* Function to return Worley noise at a point: the distance to the nearest
+						feature point (f1) and to the second nearest (f2), with one feature
+						point in each unit cell. */
+					void Worley2D(double x, double y, double &f1, double &f2) const;
+					
+					// Function to return the color, through SampleColor.
+					virtual qbVector<double> GetColor(const qbVector<double> &uvCoords) override;
+					
+					// Function to return the parameter key.
+					virtual std::string GetParameterKey() override;
+					
+				public:
+					// The fBm parameters.
+					int m_octaves = 6;
+					double m_lacunarity = 2.0;
+					double m_gain = 0.5;
+					
+				protected:
+					// Function to blend between the two colors, with t from 0 to 1, writing the result into rgba[0..3].
+					void BlendColor(double t, double *rgba) const;
+					
+					/* Function to return the parameters specific to each type of noise
+						texture, as part of the parameter key. */
+					virtual std::string GetPatternKey() = 0;
+					
+				protected:
+					qbVector<double> m_color1 {std::vector<double>{1.0, 1.0, 1.0, 1.0}};
+					qbVector<double> m_color2 {std::vector<double>{0.0, 0.0, 0.0, 1.0}};
+					
+				private:
+					unsigned int m_seed = 0;
+					
+					// The permutation table, stored twice over so that lookups never need to wrap.
+					uint8_t m_perm[512];
+			};
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,132 @@
+/* ***********************************************************
+	texelsource.cpp
+	
+	The TexelSource class implementation - An abstract base class for
+	anything that can supply the texels of a mip mapped image,
+	whether held in memory or read from disk on demand, along with
+	the bilinear and trilinear filtering built on top of it.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "texelsource.hpp"
+#include <cmath>
+#include <algorithm>
+
+// Constructor / destructor.
+qbRT::Texture::TexelSource::TexelSource()
+{
+
+}
+
+qbRT::Texture::TexelSource::~TexelSource()
+{
+
+}
+
+// Function to sample a single level with bilinear filtering.
+void qbRT::Texture::TexelSource::SampleBilinear(int level, double s, double t, double *rgba) const
+{
+	// Convert to the texel coordinates of this level, relative to the texel centres.
+	double xScale = static_cast<double>(GetXSize(level)) / static_cast<double>(GetXSize(0));
+	double yScale = static_cast<double>(GetYSize(level)) / static_cast<double>(GetYSize(0));
+	double x = (s * xScale) - 0.5;
+	double y = (t * yScale) - 0.5;
+	double x0 = floor(x);
+	double y0 = floor(y);
+	double fx = x - x0;
+	double fy = y - y0;
+	
+	// Blend the four nearest texels.
+	double t00[4], t10[4], t01[4], t11[4];
+	GetTexel(level, static_cast<int>(x0), static_cast<int>(y0), t00);
+	GetTexel(level, static_cast<int>(x0) + 1, static_cast<int>(y0), t10);
+	GetTexel(level, static_cast<int>(x0), static_cast<int>(y0) + 1, t01);
+	GetTexel(level, static_cast<int>(x0) + 1, static_cast<int>(y0) + 1, t11);
+	for (int c=0; c<4; ++c)
+	{
+		double top = (t00[c] * (1.0 - fx)) + (t10[c] * fx);
+		double bottom = (t01[c] * (1.0 - fx)) + (t11[c] * fx);
+		rgba[c] = (top * (1.0 - fy)) + (bottom * fy);
+	}
+}
+
+// Function to sample the pyramid with trilinear filtering.
+void qbRT::Texture::TexelSource::SampleTrilinear(double s, double t, double lod, double *rgba) const
+{
+	// Clamp the level of detail to the levels that we actually have.
+	int maxLevel = GetNumLevels() - 1;
+	lod = std::min(std::max(lod, 0.0), static_cast<double>(maxLevel));
+	int level0 = static_cast<int>(floor(lod));
+	double blend = lod - level0;
+	
+	// Sample the finer level, and then blend in the coarser one if needed.
+	SampleBilinear(level0, s, t, rgba);
+	if ((blend > 0.0) && (level0 < maxLevel))
+	{
+		double coarse[4];
+		SampleBilinear(level0 + 1, s, t, coarse);
+		for (int c=0; c<4; ++c)
+			rgba[c] = (rgba[c] * (1.0 - blend)) + (coarse[c] * blend);
+	}
+}
+
+// Function to convert an 8 bit sRGB value to a linear one.
+double qbRT::Texture::TexelSource::SRGBToLinear(uint8_t value)
+{
+	double c = static_cast<double>(value) / 255.0;
+	if (c <= 0.04045)
+		return c / 12.92;
+	else
+		return pow((c + 0.055) / 1.055, 2.4);
+}
+
+// Function to convert a linear value to an 8 bit sRGB one.
+uint8_t qbRT::Texture::TexelSource::LinearToSRGB(float value)
+{
+	double c = std::min(std::max(static_cast<double>(value), 0.0), 1.0);
+	if (c <= 0.0031308)
+		c = c * 12.92;
+	else
+		c = (1.055 * pow(c, 1.0 / 2.4)) - 0.055;
+	return static_cast<uint8_t>(round(c * 255.0));
+}
+
+// Function to convert a linear value to a plain 8 bit one.
+uint8_t qbRT::Texture::TexelSource::LinearToByte(float value)
+{
+	float c = std::min(std::max(value, 0.0f), 1.0f);
+	return static_cast<uint8_t>(round(c * 255.0f));
+}
+
+// Function to return a decode table.
+const double *qbRT::Texture::TexelSource::GetDecodeTable(bool sRGB)
+{
+	// The tables are built once, on first use.
+	struct Tables
+	{
+		double linear[256];
+		double sRGB[256];
+		Tables()
+		{
+			for (int i=0; i<256; ++i)
+			{
+				linear[i] = static_cast<double>(i) / 255.0;
+				sRGB[i] = SRGBToLinear(static_cast<uint8_t>(i));
+			}
+		}
+	};
+	static const Tables tables;
+	
+	return sRGB ? tables.sRGB : tables.linear;
+}
@@ -0,0 +1,71 @@
+/* ***********************************************************
+	texelsource.hpp
+	
+	The TexelSource class definition - An abstract base class for
+	anything that can supply the texels of a mip mapped image,
+	whether held in memory or read from disk on demand, along with
+	the bilinear and trilinear filtering built on top of it.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef TEXELSOURCE_H
+#define TEXELSOURCE_H
+
+#include <cstdint>
+
+namespace qbRT
+{
+	namespace Texture
+	{
+		class TexelSource
+		{
+			public:
+				// The available storage formats.
+				enum class Format {RGBA8, RGBA32F};
+				
+			public:
+				// Constructor / destructor.
+				TexelSource();
+				virtual ~TexelSource();
+				
+				// Functions to return the number of levels and the size of each level.
+				virtual int GetNumLevels() const = 0;
+				virtual int GetXSize(int level) const = 0;
+				virtual int GetYSize(int level) const = 0;
+				
+				// Function to return a single texel, wrapping x and y into the image.
+				virtual void GetTexel(int level, int x, int y, double *rgba) const = 0;
+				
+				/* Functions to sample the pyramid. The position (s,t) is given in texels
+					of level zero, with texel (i,j) covering [i,i+1) x [j,j+1), and wraps
+					around the edges of the image. The level of detail for trilinear
+					filtering is log2 of the width of the sample in level zero texels. */
+				void SampleBilinear(int level, double s, double t, double *rgba) const;
+				void SampleTrilinear(double s, double t, double lod, double *rgba) const;
+				
+				// Functions to convert between 8 bit sRGB values and linear ones.
+				static double SRGBToLinear(uint8_t value);
+				static uint8_t LinearToSRGB(float value);
+				
+				// Function to convert a linear value to a plain 8 bit one.
+				static uint8_t LinearToByte(float value);
+				
+				/* Function to return a table that converts 8 bit values to doubles,
+					either sRGB decoded or simply scaled. */
+				static const double *GetDecodeTable(bool sRGB);
+		};
+	}
+}
+
+#endif
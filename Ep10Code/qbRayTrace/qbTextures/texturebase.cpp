@@ -23,6 +23,7 @@
 
 #include "texturebase.hpp"
 #include <cmath>
+#include <sstream>
 
 // Constructor / destructor.
 qbRT::Texture::TextureBase::TextureBase()
@@ -45,27 +46,43 @@ qbVector<double> qbRT::Texture::TextureBase::GetColor(const qbVector<double> &uv
 	return outputColor;
 }
 
+// Function to return the color averaged over a footprint.
+qbVector<double> qbRT::Texture::TextureBase::GetColor(const qbVector<double> &uvCoords, double footprint)
+{
+	// By default, ignore the footprint.
+	return GetColor(uvCoords);
+}
+
+// Function to write the color at a given (u,v) location into an array.
+void qbRT::Texture::TextureBase::SampleColor(double u, double v, double footprint, double *rgba)
+{
+	// By default, go through GetColor.
+	GetColorArray(GetColor(qbVector<double>{std::vector<double>{u, v}}, footprint), rgba);
+}
+
+// Function to return whether the footprint is used.
+bool qbRT::Texture::TextureBase::UsesFootprint() const
+{
+	// By default, the footprint is ignored.
+	return false;
+}
+
 // Function to set the transform matrix.
 void qbRT::Texture::TextureBase::SetTransform(const qbVector<double> &translation, const double &rotation, const qbVector<double> &scale)
 {
-	// Build the transform matrix.
-	qbMatrix2<double> rotationMatrix = {3, 3, std::vector<double> {
-																			cos(rotation), -sin(rotation), 0.0,
-																			sin(rotation), cos(rotation), 0.0,
-																			0.0, 0.0, 1.0}};
-																			
-	qbMatrix2<double> scaleMatrix = {	3, 3, std::vector<double> {
-																		scale.GetElement(0), 0.0, 0.0,
-																		0.0, scale.GetElement(1), 0.0,
-																		0.0, 0.0, 1.0}};
-																		
-	qbMatrix2<double> translationMatrix = {	3, 3, std::vector<double> {
-																					1.0, 0.0, translation.GetElement(0),
-																					0.0, 1.0, translation.GetElement(1),
-																					0.0, 0.0, 1.0}};
-																					
-	// And combine to form the final transform matrix.
-	m_transformMatrix = translationMatrix * rotationMatrix * scaleMatrix;
+	/* Form translation * rotation * scale directly. The bottom row of the
+		product is always (0, 0, 1), so only the top two rows are stored. */
+	double cosR = cos(rotation);
+	double sinR = sin(rotation);
+	double scaleU = scale.GetElement(0);
+	double scaleV = scale.GetElement(1);
+	
+	m_transformMatrix[0][0] = cosR * scaleU;
+	m_transformMatrix[0][1] = -sinR * scaleV;
+	m_transformMatrix[0][2] = translation.GetElement(0);
+	m_transformMatrix[1][0] = sinR * scaleU;
+	m_transformMatrix[1][1] = cosR * scaleV;
+	m_transformMatrix[1][2] = translation.GetElement(1);
 }
 
 // Function to blend colors.
@@ -73,47 +90,117 @@ qbVector<double> qbRT::Texture::TextureBase::BlendColors(const std::vector<qbVec
 {
 	// Setup the output color.
 	qbVector<double> outputColor {3};
+	double outputAlpha = 0.0;
+	
+	// Work down from the top layer, stopping once nothing more can show through.
+	for (auto layer = inputColorList.rbegin(); layer != inputColorList.rend(); ++layer)
+	{
+		if (BlendUnder(*layer, outputColor, outputAlpha))
+			break;
+	}
 	
 	// Return the output.
 	return outputColor;
 }
 
+// Function to add a layer underneath a front-to-back blend.
+bool qbRT::Texture::TextureBase::BlendUnder(const qbVector<double> &layerColor, qbVector<double> &blendedColor, double &blendedAlpha)
+{
+	// Colors without an alpha channel are opaque.
+	double layerAlpha = (layerColor.GetNumDims() > 3) ? layerColor.GetElement(3) : 1.0;
+	
+	// The layer only shows through where the layers above it do not cover.
+	double weight = (1.0 - blendedAlpha) * layerAlpha;
+	for (int i=0; i<3; ++i)
+		blendedColor.SetElement(i, blendedColor.GetElement(i) + (weight * layerColor.GetElement(i)));
+	blendedAlpha += weight;
+	
+	// Allow for rounding error when deciding whether we are fully opaque.
+	return blendedAlpha >= (1.0 - 1e-9);
+}
+
+// Function to add an RGBA array underneath a front-to-back blend.
+bool qbRT::Texture::TextureBase::BlendUnder(const double *layerRGBA, double *blendedRGB, double &blendedAlpha)
+{
+	double weight = (1.0 - blendedAlpha) * layerRGBA[3];
+	for (int i=0; i<3; ++i)
+		blendedRGB[i] += weight * layerRGBA[i];
+	blendedAlpha += weight;
+	
+	return blendedAlpha >= (1.0 - 1e-9);
+}
+
 // Function to apply the transform.
 qbVector<double> qbRT::Texture::TextureBase::ApplyTransform(const qbVector<double> &inputVector)
 {
-	// Copy the input vector and modify to have three elements.
-	qbVector<double> newInput {3};
-	newInput.SetElement(0, inputVector.GetElement(0));
-	newInput.SetElement(1, inputVector.GetElement(1));
-	
-	// Apply the transform.
-	qbVector<double> result = m_transformMatrix * newInput;
+	double newU, newV;
+	ApplyTransform(inputVector.GetElement(0), inputVector.GetElement(1), newU, newV);
 	
 	// Produce the output.
 	qbVector<double> output {2};
-	output.SetElement(0, result.GetElement(0));
-	output.SetElement(1, result.GetElement(1));
+	output.SetElement(0, newU);
+	output.SetElement(1, newV);
 	
 	return output;
 }
 
+// Function to apply the transform to a single (u,v) pair.
+void qbRT::Texture::TextureBase::ApplyTransform(double u, double v, double &newU, double &newV) const
+{
+	newU = (m_transformMatrix[0][0] * u) + (m_transformMatrix[0][1] * v) + m_transformMatrix[0][2];
+	newV = (m_transformMatrix[1][0] * u) + (m_transformMatrix[1][1] * v) + m_transformMatrix[1][2];
+}
 
+// Function to return the scale of the transform.
+double qbRT::Texture::TextureBase::GetTransformScale()
+{
+	// The square root of the determinant of the upper-left 2 x 2 part.
+	double det =	(m_transformMatrix[0][0] * m_transformMatrix[1][1]) -
+								(m_transformMatrix[0][1] * m_transformMatrix[1][0]);
+	return sqrt(fabs(det));
+}
 
+// Function to return the parameter key.
+std::string qbRT::Texture::TextureBase::GetParameterKey()
+{
+	// By default, the texture cannot be identified.
+	return std::string();
+}
 
+// Function to return the local transform as part of a parameter key.
+std::string qbRT::Texture::TextureBase::GetTransformKey() const
+{
+	// Hexadecimal floating point keeps every bit of each value.
+	std::ostringstream key;
+	key << std::hexfloat << "T";
+	for (int row=0; row<2; ++row)
+		for (int col=0; col<3; ++col)
+			key << "," << m_transformMatrix[row][col];
+			
+	return key.str();
+}
 
+// Function to return a vector as part of a parameter key.
+std::string qbRT::Texture::TextureBase::GetVectorKey(const qbVector<double> &inputVector)
+{
+	std::ostringstream key;
+	key << std::hexfloat << "V";
+	for (int i=0; i<inputVector.GetNumDims(); ++i)
+		key << "," << inputVector.GetElement(i);
+		
+	return key.str();
+}
 
+// Function to convert an RGBA array into a color vector.
+qbVector<double> qbRT::Texture::TextureBase::GetColorVector(const double *rgba)
+{
+	return qbVector<double>{std::vector<double>{rgba[0], rgba[1], rgba[2], rgba[3]}};
+}
 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
+// Function to copy a color vector into an RGBA array.
+void qbRT::Texture::TextureBase::GetColorArray(const qbVector<double> &color, double *rgba)
+{
+	for (int c=0; c<3; ++c)
+		rgba[c] = color.GetElement(c);
+	rgba[3] = (color.GetNumDims() > 3) ? color.GetElement(3) : 1.0;
+}
@@ -24,7 +24,7 @@
 #define TEXTUREBASE_H
 
 #include <memory>
-#include "../qbLinAlg/qbMatrix.h"
+#include <string>
 #include "../qbLinAlg/qbVector.h"
 #include "../ray.hpp"
 
@@ -43,20 +43,72 @@ namespace qbRT
 				// Note that the color is returned as a 4-dimensional vector (RGBA).
 				virtual qbVector<double> GetColor(const qbVector<double> &uvCoords);
 				
+				/* Function to return the color averaged over a region of the given width
+					(footprint) in the (u,v) coordinate system. Textures that cannot filter
+					simply return the color at the given point. */
+				virtual qbVector<double> GetColor(const qbVector<double> &uvCoords, double footprint);
+				
+				/* Function to write the RGBA color at the given (u,v), filtered over the
+					footprint if it is positive, into rgba[0..3]. Textures that override this
+					return their colors without allocating any memory; the default simply
+					calls GetColor. */
+				virtual void SampleColor(double u, double v, double footprint, double *rgba);
+				
+				/* Function to return whether the color depends on the footprint given to
+					SampleColor, so that ray differentials are only traced for the textures
+					that use them. */
+				virtual bool UsesFootprint() const;
+				
 				// Function to set transform.
 				void SetTransform(const qbVector<double> &translation, const double &rotation, const qbVector<double> &scale);
 				
-				// Function to blend RGBA colors, returning a 3-dimensional (RGB) result.
+				/* Function to blend RGBA colors, returning a 3-dimensional (RGB) result.
+					The list runs from the bottom layer to the top one, as textures are
+					assigned to a material, and each layer is placed over the ones below
+					it according to its alpha. Anything left uncovered is black. */
 				static qbVector<double> BlendColors(const std::vector<qbVector<double>> &inputColorList);
 				
+				/* Function to add one more layer, underneath those already accumulated, to a
+					front-to-back blend. Returns true once the result is fully opaque, after
+					which no further layers can make any difference. */
+				static bool BlendUnder(const qbVector<double> &layerColor, qbVector<double> &blendedColor, double &blendedAlpha);
+				
+				// The same, for an RGBA layer and an RGB result held in plain arrays.
+				static bool BlendUnder(const double *layerRGBA, double *blendedRGB, double &blendedAlpha);
+				
 				// Function to apply the local transform to the given input vector.
 				qbVector<double> ApplyTransform(const qbVector<double> &inputVector);
 				
+				// Function to apply the local transform to a single (u,v) pair.
+				void ApplyTransform(double u, double v, double &newU, double &newV) const;
+				
+				// Function to return the factor by which the local transform scales areas, as a length.
+				double GetTransformScale();
+				
+				/* Function to return a string that identifies every parameter that affects
+					the color of the texture, such that two textures with the same key look the
+					same. Textures that cannot describe themselves return an empty string. */
+				virtual std::string GetParameterKey();
+				
+			protected:
+				// Function to return the local transform as part of a parameter key.
+				std::string GetTransformKey() const;
+				
+				// Function to return a vector as part of a parameter key.
+				static std::string GetVectorKey(const qbVector<double> &inputVector);
+				
+				// Function to convert an RGBA array into a color vector.
+				static qbVector<double> GetColorVector(const double *rgba);
+				
+				// Function to copy a color vector into an RGBA array, treating RGB colors as opaque.
+				static void GetColorArray(const qbVector<double> &color, double *rgba);
+				
 			private:
 			
 			private:
-				// Initialise the transform matrix to the identity matrix.
-				qbMatrix2<double> m_transformMatrix {3, 3, std::vector<double>{1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0}};
+				/* The top two rows of the 3 x 3 transform matrix, which are all that an
+					affine transform in 2D needs, initialised to the identity. */
+				double m_transformMatrix[2][3] = {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}};
 				
 		};
 	}
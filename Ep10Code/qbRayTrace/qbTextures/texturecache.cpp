@@ -0,0 +1,274 @@
+/* ***********************************************************
+	texturecache.cpp
+	
+	The TextureCache class implementation - A cache, shared by all
+	textures, that reads the tiles of tiled texture files (.qbtx)
+	from disk as they are needed and keeps the most recently used
+	ones in memory, within a fixed memory budget.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "texturecache.hpp"
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Function to combine a file, level and tile position into a single key.
+	This allows up to 65536 files, 256 levels and tile positions of up to 2^20,
+	which OpenFile checks. */
+constexpr int MAXFILES = 1 << 16;
+constexpr int MAXTILES = 1 << 20;
+
+static inline uint64_t TileKey(int fileID, int level, int tileX, int tileY)
+{
+	return	(static_cast<uint64_t>(fileID) << 48) | (static_cast<uint64_t>(level) << 40) |
+					(static_cast<uint64_t>(tileY) << 20) | static_cast<uint64_t>(tileX);
+}
+
+// Function to choose the shard for a key.
+static inline int ShardIndex(uint64_t key, int numShards)
+{
+	// Mix the bits so that neighbouring tiles land in different shards.
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	return static_cast<int>(key % static_cast<uint64_t>(numShards));
+}
+
+// Constructor / destructor.
+qbRT::Texture::TextureCache::TextureCache()
+{
+
+}
+
+qbRT::Texture::TextureCache::~TextureCache()
+{
+	for (auto &file : m_files)
+	{
+		if (file->fileDescriptor >= 0)
+			close(file->fileDescriptor);
+	}
+}
+
+// Function to return the shared cache.
+qbRT::Texture::TextureCache &qbRT::Texture::TextureCache::GetShared()
+{
+	static TextureCache sharedCache;
+	return sharedCache;
+}
+
+// Function to open a tiled file.
+int qbRT::Texture::TextureCache::OpenFile(const std::string &fileName)
+{
+	std::lock_guard<std::mutex> lock (m_filesMutex);
+	
+	// If the file is already open, simply return it.
+	for (int i=0; i<static_cast<int>(m_files.size()); ++i)
+	{
+		if (m_files.at(i)->fileName == fileName)
+			return i;
+	}
+	
+	if (static_cast<int>(m_files.size()) >= MAXFILES)
+	{
+		std::cout << "Too many texture files are open to open " << fileName << "." << std::endl;
+		return -1;
+	}
+	
+	auto file = std::make_unique<OpenTexture>();
+	file->fileName = fileName;
+	file->fileDescriptor = open(fileName.c_str(), O_RDONLY);
+	if (file->fileDescriptor < 0)
+	{
+		std::cout << "Failed to open " << fileName << "." << std::endl;
+		return -1;
+	}
+	
+	if (!TiledFormat::ReadHeader(file->fileDescriptor, file->header, file->levels))
+	{
+		std::cout << fileName << " is not a valid tiled texture file." << std::endl;
+		close(file->fileDescriptor);
+		return -1;
+	}
+	
+	// The first level has the most tiles, and they must fit in the key.
+	if ((file->levels.at(0).tilesX > MAXTILES) || (file->levels.at(0).tilesY > MAXTILES))
+	{
+		std::cout << fileName << " has too many tiles across to be cached." << std::endl;
+		close(file->fileDescriptor);
+		return -1;
+	}
+	
+	m_files.push_back(std::move(file));
+	return static_cast<int>(m_files.size()) - 1;
+}
+
+// Function to return the header and level table of an open file.
+void qbRT::Texture::TextureCache::GetFileInfo(int fileID, TiledFormat::Header &header, std::vector<TiledFormat::LevelInfo> &levels)
+{
+	std::lock_guard<std::mutex> lock (m_filesMutex);
+	header = m_files.at(fileID)->header;
+	levels = m_files.at(fileID)->levels;
+}
+
+// Function to return a tile.
+std::shared_ptr<const qbRT::Texture::TextureCache::Tile> qbRT::Texture::TextureCache::GetTile(int fileID, int level, int tileX, int tileY)
+{
+	uint64_t key = TileKey(fileID, level, tileX, tileY);
+	Shard &shard = m_shards[ShardIndex(key, NUMSHARDS)];
+	
+	// Look for the tile, and if we find it, move it to the front of the list.
+	{
+		std::lock_guard<std::mutex> lock (shard.mutex);
+		auto found = shard.index.find(key);
+		if (found != shard.index.end())
+		{
+			shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+			m_hits.fetch_add(1, std::memory_order_relaxed);
+			return found->second->tile;
+		}
+	}
+	
+	// Otherwise read it from disk, without holding the lock.
+	m_misses.fetch_add(1, std::memory_order_relaxed);
+	std::shared_ptr<const Tile> tile = ReadTile(fileID, level, tileX, tileY);
+	if (!tile)
+		return tile;
+		
+	// Another thread may have read the same tile in the meantime, in which case we use theirs.
+	std::lock_guard<std::mutex> lock (shard.mutex);
+	auto found = shard.index.find(key);
+	if (found != shard.index.end())
+	{
+		shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+		return found->second->tile;
+	}
+	
+	shard.lru.push_front(Entry {key, tile});
+	shard.index[key] = shard.lru.begin();
+	shard.bytes += tile->size();
+	Evict(shard);
+	
+	return tile;
+}
+
+// Function to read a tile from disk.
+std::shared_ptr<const qbRT::Texture::TextureCache::Tile> qbRT::Texture::TextureCache::ReadTile(int fileID, int level, int tileX, int tileY)
+{
+	const OpenTexture *file;
+	{
+		std::lock_guard<std::mutex> lock (m_filesMutex);
+		file = m_files.at(fileID).get();
+	}
+	
+	std::size_t tileBytes = TiledFormat::GetTileBytes(file->header);
+	uint64_t offset = TiledFormat::GetTileOffset(file->header, file->levels.at(level), tileX, tileY);
+	auto tile = std::make_shared<Tile>(tileBytes);
+	
+	// pread does not move the file position, so it is safe to use from several threads at once.
+	std::size_t totalRead = 0;
+	while (totalRead < tileBytes)
+	{
+		ssize_t bytesRead = pread(file->fileDescriptor, tile->data() + totalRead, tileBytes - totalRead, offset + totalRead);
+		if (bytesRead <= 0)
+		{
+			std::cout << "Failed to read a tile from " << file->fileName << "." << std::endl;
+			return nullptr;
+		}
+		totalRead += static_cast<std::size_t>(bytesRead);
+	}
+	
+	return tile;
+}
+
+// Function to evict tiles from a shard.
+void qbRT::Texture::TextureCache::Evict(Shard &shard)
+{
+	// Always keep at least the tile that was just added.
+	std::size_t shardBudget = m_memoryBudget.load() / NUMSHARDS;
+	while ((shard.bytes > shardBudget) && (shard.lru.size() > 1))
+	{
+		Entry &last = shard.lru.back();
+		shard.bytes -= last.tile->size();
+		shard.index.erase(last.key);
+		shard.lru.pop_back();
+	}
+}
+
+// Functions to set and return the memory budget.
+void qbRT::Texture::TextureCache::SetMemoryBudget(std::size_t bytes)
+{
+	m_memoryBudget = bytes;
+	for (auto &shard : m_shards)
+	{
+		std::lock_guard<std::mutex> lock (shard.mutex);
+		Evict(shard);
+	}
+}
+
+std::size_t qbRT::Texture::TextureCache::GetMemoryBudget() const
+{
+	return m_memoryBudget.load();
+}
+
+// Function to return the memory currently held by tiles.
+std::size_t qbRT::Texture::TextureCache::GetMemoryUsed()
+{
+	std::size_t total = 0;
+	for (auto &shard : m_shards)
+	{
+		std::lock_guard<std::mutex> lock (shard.mutex);
+		total += shard.bytes;
+	}
+	return total;
+}
+
+// Functions to return the statistics.
+uint64_t qbRT::Texture::TextureCache::GetHits() const
+{
+	return m_hits.load();
+}
+
+uint64_t qbRT::Texture::TextureCache::GetMisses() const
+{
+	return m_misses.load();
+}
+
+double qbRT::Texture::TextureCache::GetHitRate() const
+{
+	uint64_t hits = m_hits.load();
+	uint64_t total = hits + m_misses.load();
+	if (total == 0)
+		return 0.0;
+	
+	return static_cast<double>(hits) / static_cast<double>(total);
+}
+
+void qbRT::Texture::TextureCache::ResetStats()
+{
+	m_hits = 0;
+	m_misses = 0;
+}
+
+// Function to release every tile held in memory.
+void qbRT::Texture::TextureCache::Clear()
+{
+	for (auto &shard : m_shards)
+	{
+		std::lock_guard<std::mutex> lock (shard.mutex);
+		shard.lru.clear();
+		shard.index.clear();
+		shard.bytes = 0;
+	}
+}
@@ -0,0 +1,140 @@
+/* ***********************************************************
+	texturecache.hpp
+	
+	The TextureCache class definition - A cache, shared by all
+	textures, that reads the tiles of tiled texture files (.qbtx)
+	from disk as they are needed and keeps the most recently used
+	ones in memory, within a fixed memory budget.
+	
+	Lookups may be made from several threads at once. The tiles are
+	spread over a number of independently locked shards, so that
+	threads rarely wait for each other, and each shard evicts its
+	least recently used tiles once it is over its share of the
+	budget. Tiles are handed out as shared pointers, so a tile that
+	is evicted while a thread is still reading it stays valid.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include "tiledformat.hpp"
+
+namespace qbRT
+{
+	namespace Texture
+	{
+		class TextureCache
+		{
+			public:
+				// A single tile, as read from the file.
+				using Tile = std::vector<uint8_t>;
+				
+			public:
+				// Constructor / destructor.
+				TextureCache();
+				~TextureCache();
+				
+				// The cache is shared, and so is not copyable.
+				TextureCache(const TextureCache &) = delete;
+				TextureCache &operator= (const TextureCache &) = delete;
+				
+				// Function to return the cache shared by all textures.
+				static TextureCache &GetShared();
+				
+				/* Function to open a tiled file and return an identifier for it, or -1
+					if it cannot be opened, or has more tiles across than the cache can
+					tell apart. Opening the same file twice returns the same identifier. */
+				int OpenFile(const std::string &fileName);
+				
+				// Function to return the header and level table of an open file.
+				void GetFileInfo(int fileID, TiledFormat::Header &header, std::vector<TiledFormat::LevelInfo> &levels);
+				
+				/* Function to return a tile, reading it from disk if it is not already
+					in memory. Returns an empty pointer if the tile cannot be read. */
+				std::shared_ptr<const Tile> GetTile(int fileID, int level, int tileX, int tileY);
+				
+				// Functions to set and return the memory budget, in bytes.
+				void SetMemoryBudget(std::size_t bytes);
+				std::size_t GetMemoryBudget() const;
+				
+				// Function to return the memory currently held by tiles, in bytes.
+				std::size_t GetMemoryUsed();
+				
+				/* Functions to return the statistics. These count calls to GetTile, so the
+					texel lookups that CachedTexture answers from the tile that the thread
+					used last, without asking the cache, are not counted as hits. */
+				uint64_t GetHits() const;
+				uint64_t GetMisses() const;
+				double GetHitRate() const;
+				void ResetStats();
+				
+				// Function to release every tile held in memory.
+				void Clear();
+				
+			private:
+				struct OpenTexture
+				{
+					std::string fileName;
+					int fileDescriptor = -1;
+					TiledFormat::Header header;
+					std::vector<TiledFormat::LevelInfo> levels;
+				};
+				
+				struct Entry
+				{
+					uint64_t key;
+					std::shared_ptr<const Tile> tile;
+				};
+				
+				struct Shard
+				{
+					std::mutex mutex;
+					std::list<Entry> lru;
+					std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+					std::size_t bytes = 0;
+				};
+				
+			private:
+				// Function to read a tile from disk.
+				std::shared_ptr<const Tile> ReadTile(int fileID, int level, int tileX, int tileY);
+				
+				// Function to evict tiles from a shard until it is within its budget.
+				void Evict(Shard &shard);
+				
+			private:
+				// The number of shards that the tiles are spread over.
+				static constexpr int NUMSHARDS = 16;
+				
+				std::vector<std::unique_ptr<OpenTexture>> m_files;
+				std::mutex m_filesMutex;
+				
+				Shard m_shards[NUMSHARDS];
+				std::atomic<std::size_t> m_memoryBudget {256 * 1024 * 1024};
+				
+				std::atomic<uint64_t> m_hits {0};
+				std::atomic<uint64_t> m_misses {0};
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,134 @@
+/* ***********************************************************
+	textureregistry.cpp
+	
+	The TextureRegistry class implementation - A registry, keyed by file
+	name, of every image loaded for use as a texture. Each file is
+	only ever loaded once, however many textures refer to it, and
+	the loading is done on the shared thread pool.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "textureregistry.hpp"
+#include "mipmap.hpp"
+#include "cachedtexture.hpp"
+#include "mappedtexture.hpp"
+#include "bmpdecoder.hpp"
+#include "../threadpool.hpp"
+#include <vector>
+#include <iostream>
+
+// Constructor / destructor.
+qbRT::Texture::TextureRegistry::TextureRegistry()
+{
+
+}
+
+qbRT::Texture::TextureRegistry::~TextureRegistry()
+{
+
+}
+
+// Function to return the shared registry.
+qbRT::Texture::TextureRegistry &qbRT::Texture::TextureRegistry::GetShared()
+{
+	static TextureRegistry sharedRegistry;
+	return sharedRegistry;
+}
+
+// Function to return a handle to the given file.
+qbRT::Texture::TextureRegistry::Handle qbRT::Texture::TextureRegistry::Load(const std::string &fileName, const Options &options)
+{
+	// The same file loaded with different options is a different entry.
+	std::string key = fileName + "|" + std::to_string(static_cast<int>(options.format)) +
+										(options.linearize ? "|linear" : "|raw") + (options.useTextureCache ? "|cached" : "|direct");
+	
+	std::lock_guard<std::mutex> lock (m_mutex);
+	auto found = m_entries.find(key);
+	if (found != m_entries.end())
+		return found->second;
+		
+	// Start the load in the background.
+	Handle handle = qbRT::ThreadPool::GetShared().Submit([fileName, options]() { return LoadTexels(fileName, options); }).share();
+	m_entries[key] = handle;
+	
+	return handle;
+}
+
+// Function to wait for every load to finish.
+void qbRT::Texture::TextureRegistry::WaitAll()
+{
+	// Take a copy of the handles, so that we do not hold the lock while waiting.
+	std::vector<Handle> handles;
+	{
+		std::lock_guard<std::mutex> lock (m_mutex);
+		for (auto &entry : m_entries)
+			handles.push_back(entry.second);
+	}
+	
+	for (auto &handle : handles)
+		handle.wait();
+}
+
+// Function to return the number of distinct loads.
+int qbRT::Texture::TextureRegistry::GetNumLoads()
+{
+	std::lock_guard<std::mutex> lock (m_mutex);
+	return static_cast<int>(m_entries.size());
+}
+
+// Function to forget every entry.
+void qbRT::Texture::TextureRegistry::Clear()
+{
+	std::lock_guard<std::mutex> lock (m_mutex);
+	m_entries.clear();
+}
+
+// Function to load a file straight away.
+std::shared_ptr<qbRT::Texture::TexelSource> qbRT::Texture::TextureRegistry::LoadTexels(const std::string &fileName, const Options &options)
+{
+	// Tiled files are not loaded here, just opened.
+	if ((fileName.size() > 5) && (fileName.compare(fileName.size() - 5, 5, ".qbtx") == 0))
+	{
+		std::shared_ptr<TexelSource> texels;
+		if (options.useTextureCache)
+		{
+			auto cachedTexture = std::make_shared<CachedTexture>();
+			if (!cachedTexture->Open(fileName))
+				return nullptr;
+			texels = cachedTexture;
+		}
+		else
+		{
+			auto mappedTexture = std::make_shared<MappedTexture>();
+			if (!mappedTexture->Open(fileName))
+				return nullptr;
+			texels = mappedTexture;
+		}
+		
+		std::cout << "Opened " << texels->GetXSize(0) << " by " << texels->GetYSize(0) << " tiled texture." << std::endl;
+		return texels;
+	}
+	
+	// Decode the bitmap once, here, into linear RGBA values.
+	int xSize, ySize;
+	std::vector<float> rgba;
+	if (!DecodeBMP(fileName, xSize, ySize, rgba, options.linearize))
+		return nullptr;
+	
+	// Build the mip map in the requested format.
+	auto mipMap = std::make_shared<MipMap>();
+	mipMap->Build(xSize, ySize, rgba, options.format, options.linearize);
+	
+	return mipMap;
+}
@@ -0,0 +1,88 @@
+/* ***********************************************************
+	textureregistry.hpp
+	
+	The TextureRegistry class definition - A registry, keyed by file
+	name, of every image loaded for use as a texture. Each file is
+	only ever loaded once, however many textures refer to it, and
+	the loading is done on the shared thread pool, so that several
+	files can be decoded at once while the rest of the scene is
+	being set up.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef TEXTUREREGISTRY_H
+#define TEXTUREREGISTRY_H
+
+#include <string>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include "texelsource.hpp"
+
+namespace qbRT
+{
+	namespace Texture
+	{
+		class TextureRegistry
+		{
+			public:
+				/* A shared handle to a loaded image. Calling get() waits for the load
+					to finish, and returns an empty pointer if it failed. */
+				using Handle = std::shared_future<std::shared_ptr<TexelSource>>;
+				
+				// The options that control how an image is loaded.
+				struct Options
+				{
+					TexelSource::Format format = TexelSource::Format::RGBA8;
+					bool linearize = false;
+					bool useTextureCache = false;
+				};
+				
+			public:
+				// Constructor / destructor.
+				TextureRegistry();
+				~TextureRegistry();
+				
+				// Function to return the registry shared by all textures.
+				static TextureRegistry &GetShared();
+				
+				/* Function to return a handle to the given file, loaded with the given
+					options, starting the load in the background if this is the first
+					time that it has been asked for. */
+				Handle Load(const std::string &fileName, const Options &options);
+				
+				// Function to wait for every load that has been started to finish.
+				void WaitAll();
+				
+				// Function to return the number of distinct loads that have been started.
+				int GetNumLoads();
+				
+				/* Function to forget every entry. Handles that have already been given
+					out remain valid. */
+				void Clear();
+				
+				/* Function to load a file straight away, on the calling thread. Tiled
+					files (.qbtx) are memory mapped, or opened through the shared texture
+					cache; anything else is loaded as a bitmap and held in memory. */
+				static std::shared_ptr<TexelSource> LoadTexels(const std::string &fileName, const Options &options);
+				
+			private:
+				std::mutex m_mutex;
+				std::unordered_map<std::string, Handle> m_entries;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,278 @@
+/* ***********************************************************
+	tiledformat.cpp
+	
+	Functions for reading and writing the tiled texture format
+	(.qbtx) - A binary file that holds every level of a mip mapped
+	texture, already cut into fixed size square tiles, so that the
+	renderer can read just the tiles that it needs.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "tiledformat.hpp"
+#include "mipmap.hpp"
+#include <fstream>
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <string>
+#include <atomic>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// The file identifier and the version of the format that we write.
+static const char TILEDMAGIC[4] = {'Q', 'B', 'T', 'X'};
+static const int32_t TILEDVERSION = 1;
+
+// The size of each entry in the level table.
+static const int LEVELENTRYSIZE = 24;
+
+// Function to return the size in bytes of a single tile.
+std::size_t qbRT::Texture::TiledFormat::GetTileBytes(const Header &header)
+{
+	std::size_t bytesPerTexel = (header.format == TexelSource::Format::RGBA8) ? 4 : 16;
+	return static_cast<std::size_t>(header.tileSize) * header.tileSize * bytesPerTexel;
+}
+
+// Function to return the offset in the file of the given tile.
+uint64_t qbRT::Texture::TiledFormat::GetTileOffset(const Header &header, const LevelInfo &level, int tileX, int tileY)
+{
+	uint64_t tileIndex = (static_cast<uint64_t>(tileY) * level.tilesX) + tileX;
+	return level.offset + (tileIndex * GetTileBytes(header));
+}
+
+// Function to write a tiled file.
+bool qbRT::Texture::TiledFormat::Write(	const std::string &fileName, int xSize, int ySize, const std::vector<float> &rgba,
+																				TexelSource::Format format, bool sRGB, int tileSize)
+{
+	Header header;
+	header.xSize = xSize;
+	header.ySize = ySize;
+	header.tileSize = tileSize;
+	header.format = format;
+	header.sRGB = sRGB && (format == TexelSource::Format::RGBA8);
+	
+	// Compute every level of the mip chain up front, so that the level table can be written first.
+	std::vector<std::vector<float>> levelData;
+	std::vector<LevelInfo> levels;
+	levelData.push_back(rgba);
+	LevelInfo first;
+	first.xSize = xSize;
+	first.ySize = ySize;
+	levels.push_back(first);
+	while ((levels.back().xSize > 1) || (levels.back().ySize > 1))
+	{
+		LevelInfo next;
+		std::vector<float> nextData;
+		MipMap::Downsample(levels.back().xSize, levels.back().ySize, levelData.back(), next.xSize, next.ySize, nextData);
+		levelData.push_back(std::move(nextData));
+		levels.push_back(next);
+	}
+	header.numLevels = static_cast<int>(levels.size());
+	
+	// Work out where each level will go.
+	uint64_t tableEnd = HEADERSIZE + (static_cast<uint64_t>(LEVELENTRYSIZE) * header.numLevels);
+	uint64_t offset = ((tableEnd + DATAALIGNMENT - 1) / DATAALIGNMENT) * DATAALIGNMENT;
+	for (auto &level : levels)
+	{
+		level.tilesX = (level.xSize + tileSize - 1) / tileSize;
+		level.tilesY = (level.ySize + tileSize - 1) / tileSize;
+		level.offset = offset;
+		offset += static_cast<uint64_t>(level.tilesX) * level.tilesY * GetTileBytes(header);
+	}
+	
+	/* Write to a temporary file first, so that a failed write never leaves a partial file behind.
+		Its name is unique to this write, so that two processes or threads writing the same file
+		never write into the same temporary file, and whichever renames last wins. */
+	static std::atomic<unsigned int> writeCount {0};
+	std::string tempName = fileName + "." + std::to_string(getpid()) + "." + std::to_string(writeCount.fetch_add(1)) + ".tmp";
+	std::ofstream file (tempName, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "Failed to open " << tempName << " for writing." << std::endl;
+		return false;
+	}
+	
+	// The header.
+	int32_t headerValues[7] = {	TILEDVERSION, header.xSize, header.ySize, header.numLevels, header.tileSize,
+															static_cast<int32_t>(header.format), header.sRGB ? 1 : 0};
+	file.write(TILEDMAGIC, 4);
+	file.write(reinterpret_cast<const char *>(headerValues), sizeof(headerValues));
+	
+	// The level table.
+	for (auto &level : levels)
+	{
+		int32_t levelValues[4] = {level.xSize, level.ySize, level.tilesX, level.tilesY};
+		file.write(reinterpret_cast<const char *>(levelValues), sizeof(levelValues));
+		file.write(reinterpret_cast<const char *>(&level.offset), sizeof(level.offset));
+	}
+	
+	// Pad up to the start of the tile data.
+	std::vector<char> padding (levels.front().offset - tableEnd, 0);
+	file.write(padding.data(), padding.size());
+	
+	// And the tiles themselves.
+	std::vector<uint8_t> tile (GetTileBytes(header));
+	for (int l=0; l<header.numLevels; ++l)
+	{
+		const LevelInfo &level = levels.at(l);
+		const std::vector<float> &data = levelData.at(l);
+		for (int tileY=0; tileY<level.tilesY; ++tileY)
+		{
+			for (int tileX=0; tileX<level.tilesX; ++tileX)
+			{
+				// Fill the tile, repeating the edge texels into any padding.
+				for (int y=0; y<tileSize; ++y)
+				{
+					int sourceY = std::min((tileY * tileSize) + y, level.ySize - 1);
+					for (int x=0; x<tileSize; ++x)
+					{
+						int sourceX = std::min((tileX * tileSize) + x, level.xSize - 1);
+						const float *source = &data.at(((sourceY * level.xSize) + sourceX) * 4);
+						int texelIndex = (y * tileSize) + x;
+						if (header.format == TexelSource::Format::RGBA8)
+						{
+							uint8_t *target = &tile.at(texelIndex * 4);
+							for (int c=0; c<3; ++c)
+								target[c] = header.sRGB ? TexelSource::LinearToSRGB(source[c]) : TexelSource::LinearToByte(source[c]);
+							target[3] = TexelSource::LinearToByte(source[3]);
+						}
+						else
+						{
+							memcpy(&tile.at(texelIndex * 16), source, 16);
+						}
+					}
+				}
+				file.write(reinterpret_cast<const char *>(tile.data()), tile.size());
+			}
+		}
+	}
+	
+	file.close();
+	if (!file)
+	{
+		std::cout << "Failed to write " << tempName << "." << std::endl;
+		std::remove(tempName.c_str());
+		return false;
+	}
+	
+	if (std::rename(tempName.c_str(), fileName.c_str()) != 0)
+	{
+		std::remove(tempName.c_str());
+		return false;
+	}
+	
+	return true;
+}
+
+// Function to parse the header and level table.
+bool qbRT::Texture::TiledFormat::Parse(const uint8_t *data, std::size_t dataSize, uint64_t fileSize, Header &header, std::vector<LevelInfo> &levels)
+{
+	if ((dataSize < static_cast<std::size_t>(HEADERSIZE)) || (memcmp(data, TILEDMAGIC, 4) != 0))
+		return false;
+		
+	int32_t headerValues[7];
+	memcpy(headerValues, data + 4, sizeof(headerValues));
+	if (headerValues[0] != TILEDVERSION)
+		return false;
+		
+	// Check the format before it is cast, as only the two known formats can be decoded.
+	if ((headerValues[5] != static_cast<int32_t>(TexelSource::Format::RGBA8)) && (headerValues[5] != static_cast<int32_t>(TexelSource::Format::RGBA32F)))
+		return false;
+		
+	header.xSize = headerValues[1];
+	header.ySize = headerValues[2];
+	header.numLevels = headerValues[3];
+	header.tileSize = headerValues[4];
+	header.format = static_cast<TexelSource::Format>(headerValues[5]);
+	header.sRGB = headerValues[6] != 0;
+	if ((header.xSize < 1) || (header.ySize < 1) || (header.numLevels < 1) || (header.numLevels > 32) || (header.tileSize < 1) || (header.tileSize > 4096))
+		return false;
+	
+	if (dataSize < static_cast<std::size_t>(HEADERSIZE + (LEVELENTRYSIZE * header.numLevels)))
+		return false;
+	
+	levels.resize(header.numLevels);
+	for (int l=0; l<header.numLevels; ++l)
+	{
+		const uint8_t *entry = data + HEADERSIZE + (LEVELENTRYSIZE * l);
+		int32_t levelValues[4];
+		memcpy(levelValues, entry, sizeof(levelValues));
+		levels.at(l).xSize = levelValues[0];
+		levels.at(l).ySize = levelValues[1];
+		levels.at(l).tilesX = levelValues[2];
+		levels.at(l).tilesY = levelValues[3];
+		memcpy(&levels.at(l).offset, entry + sizeof(levelValues), sizeof(uint64_t));
+		
+		/* Each level must have texels, no more than the level above, and exactly the
+			tiles needed to cover them, so that lookups never divide by zero or index
+			outside the level. */
+		const LevelInfo &level = levels.at(l);
+		int maxXSize = (l == 0) ? header.xSize : levels.at(l - 1).xSize;
+		int maxYSize = (l == 0) ? header.ySize : levels.at(l - 1).ySize;
+		if ((level.xSize < 1) || (level.ySize < 1) || (level.xSize > maxXSize) || (level.ySize > maxYSize))
+			return false;
+		if ((l == 0) && ((level.xSize != header.xSize) || (level.ySize != header.ySize)))
+			return false;
+		if (	(level.tilesX != ((level.xSize + header.tileSize - 1) / header.tileSize)) ||
+					(level.tilesY != ((level.ySize + header.tileSize - 1) / header.tileSize)))
+			return false;
+			
+		// And its tiles must lie within the file, checked without overflowing.
+		uint64_t tileBytes = GetTileBytes(header);
+		uint64_t numTiles = static_cast<uint64_t>(level.tilesX) * static_cast<uint64_t>(level.tilesY);
+		if ((level.offset > fileSize) || (numTiles > ((fileSize - level.offset) / tileBytes)))
+			return false;
+	}
+	
+	return true;
+}
+
+// Function to read the header and level table from a file descriptor.
+bool qbRT::Texture::TiledFormat::ReadHeader(int fileDescriptor, Header &header, std::vector<LevelInfo> &levels)
+{
+	// The header and table always fit within the aligned space before the tile data.
+	struct stat fileInfo;
+	if ((fstat(fileDescriptor, &fileInfo) != 0) || (fileInfo.st_size <= 0))
+		return false;
+		
+	std::vector<uint8_t> data (DATAALIGNMENT);
+	ssize_t bytesRead = pread(fileDescriptor, data.data(), data.size(), 0);
+	if (bytesRead <= 0)
+		return false;
+		
+	return Parse(data.data(), static_cast<std::size_t>(bytesRead), static_cast<uint64_t>(fileInfo.st_size), header, levels);
+}
+
+// Function to decode a single texel from a tile.
+void qbRT::Texture::TiledFormat::DecodeTexel(const Header &header, const uint8_t *tile, int x, int y, double *rgba)
+{
+	int texelIndex = (y * header.tileSize) + x;
+	if (header.format == TexelSource::Format::RGBA8)
+	{
+		const double *decodeTable = TexelSource::GetDecodeTable(header.sRGB);
+		const uint8_t *texel = tile + (texelIndex * 4);
+		rgba[0] = decodeTable[texel[0]];
+		rgba[1] = decodeTable[texel[1]];
+		rgba[2] = decodeTable[texel[2]];
+		rgba[3] = static_cast<double>(texel[3]) / 255.0;
+	}
+	else
+	{
+		float texel[4];
+		memcpy(texel, tile + (texelIndex * 16), sizeof(texel));
+		for (int c=0; c<4; ++c)
+			rgba[c] = texel[c];
+	}
+}
@@ -0,0 +1,95 @@
+/* ***********************************************************
+	tiledformat.hpp
+	
+	Functions for reading and writing the tiled texture format
+	(.qbtx) - A binary file that holds every level of a mip mapped
+	texture, already cut into fixed size square tiles, so that the
+	renderer can read just the tiles that it needs.
+	
+	The file starts with a header and a table giving the size of
+	each level and the position of its first tile. The tiles follow,
+	level by level and row by row, each padded to the full tile size
+	with the texels inside a tile stored row by row. The tile data
+	starts on a 4096 byte boundary.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef TILEDFORMAT_H
+#define TILEDFORMAT_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "texelsource.hpp"
+
+namespace qbRT
+{
+	namespace Texture
+	{
+		namespace TiledFormat
+		{
+			// The size of the header, which the level table immediately follows.
+			constexpr int HEADERSIZE = 32;
+			
+			// The boundary that the tile data is aligned to.
+			constexpr int DATAALIGNMENT = 4096;
+		
+			struct Header
+			{
+				int xSize = 0;
+				int ySize = 0;
+				int numLevels = 0;
+				int tileSize = 0;
+				TexelSource::Format format = TexelSource::Format::RGBA8;
+				bool sRGB = false;
+			};
+			
+			struct LevelInfo
+			{
+				int xSize = 0;
+				int ySize = 0;
+				int tilesX = 0;
+				int tilesY = 0;
+				uint64_t offset = 0;
+			};
+			
+			/* Function to write an image, given as linear RGBA values with rows running
+				from the top of the image down, to a tiled file with a full mip chain. */
+			bool Write(	const std::string &fileName, int xSize, int ySize, const std::vector<float> &rgba,
+									TexelSource::Format format, bool sRGB, int tileSize = 64);
+			
+			/* Function to parse the header and level table from the start of a file,
+				given dataSize bytes from the start of a file of fileSize bytes. Returns
+				false if the data is not a valid tiled file, including if any level has no
+				texels, has a tile count that does not match its size, or lies beyond the
+				end of the file. */
+			bool Parse(const uint8_t *data, std::size_t dataSize, uint64_t fileSize, Header &header, std::vector<LevelInfo> &levels);
+			
+			// Function to read the header and level table from an open file descriptor.
+			bool ReadHeader(int fileDescriptor, Header &header, std::vector<LevelInfo> &levels);
+			
+			// Function to return the size in bytes of a single tile.
+			std::size_t GetTileBytes(const Header &header);
+			
+			// Function to return the offset in the file of the given tile.
+			uint64_t GetTileOffset(const Header &header, const LevelInfo &level, int tileX, int tileY);
+			
+			// Function to decode a single texel from a tile, given its position within the tile.
+			void DecodeTexel(const Header &header, const uint8_t *tile, int x, int y, double *rgba);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,55 @@
+/* ***********************************************************
+	wood.cpp
+	
+	The Wood class implementation - A noise texture of growth rings
+	around the (u,v) origin, with the rings distorted by gradient noise.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "wood.hpp"
+#include <cmath>
+#include <sstream>
+
+// Constructor / destructor.
+qbRT::Texture::Noise::Wood::Wood()
+{
+	m_color1 = qbVector<double>{std::vector<double>{0.75, 0.55, 0.35, 1.0}};
+	m_color2 = qbVector<double>{std::vector<double>{0.45, 0.28, 0.15, 1.0}};
+}
+
+qbRT::Texture::Noise::Wood::~Wood()
+{
+
+}
+
+// Function to return the color.
+void qbRT::Texture::Noise::Wood::SampleColor(double inputU, double inputV, double, double *rgba)
+{
+	// Apply the local transform to the (u,v) coordinates.
+	double u, v;
+	ApplyTransform(inputU, inputV, u, v);
+	
+	// Distort the distance from the origin, and keep just the fractional part of the ring number.
+	double distance = sqrt((u * u) + (v * v)) + (m_turbulence * Perlin2D(u * m_noiseFrequency, v * m_noiseFrequency));
+	double rings = distance * m_ringFrequency;
+	BlendColor(rings - floor(rings), rgba);
+}
+
+// Function to return the parameters of this pattern.
+std::string qbRT::Texture::Noise::Wood::GetPatternKey()
+{
+	std::ostringstream key;
+	key << std::hexfloat << "Wood," << m_ringFrequency << "," << m_turbulence << "," << m_noiseFrequency;
+	return key.str();
+}
@@ -0,0 +1,57 @@
+/* ***********************************************************
+	wood.hpp
+	
+	The Wood class definition - A noise texture of growth rings
+	around the (u,v) origin, with the rings distorted by gradient noise.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef WOOD_H
+#define WOOD_H
+
+#include "noisebase.hpp"
+
+namespace qbRT
+{
+	namespace Texture
+	{
+		namespace Noise
+		{
+			class Wood : public NoiseBase
+			{
+				public:
+					// Constructor / destructor.
+					Wood();
+					virtual ~Wood() override;
+					
+					// Function to return the color.
+					virtual void SampleColor(double u, double v, double footprint, double *rgba) override;
+					
+				protected:
+					// Function to return the parameters of this pattern.
+					virtual std::string GetPatternKey() override;
+					
+				public:
+					// The number of rings per unit of distance, and how strongly they are distorted.
+					double m_ringFrequency = 8.0;
+					double m_turbulence = 0.1;
+					
+					// The frequency of the noise used to distort the rings.
+					double m_noiseFrequency = 4.0;
+			};
+		}
+	}
+}
+
+#endif
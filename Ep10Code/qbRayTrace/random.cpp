@@ -0,0 +1,75 @@
+/* ***********************************************************
+	random.cpp
+	
+	Functions for generating random numbers - A single, seedable
+	source of random numbers shared by everything in the renderer
+	that needs to take random samples.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+// random.cpp
+
+#include "random.hpp"
+#include "./qbSamplers/samplerbase.hpp"
+
+/* The generator itself. This is always started from the same
+	seed so that renders are repeatable. */
+static std::mt19937 randomGenerator (1);
+
+// The sampler bound to this thread, if any.
+static thread_local qbRT::Sampler::SamplerBase *t_sampler = nullptr;
+
+// Function to seed the random number generator.
+void qbRT::Random::Seed(unsigned int seed)
+{
+	randomGenerator.seed(seed);
+}
+
+// Function to return a uniformly distributed random number in the range [0,1).
+double qbRT::Random::Uniform()
+{
+	if (t_sampler)
+		return t_sampler->Get1D();
+		
+	/* Build the number from the top 53 bits of two 32-bit draws so that
+		the result does not depend on the standard library implementation. */
+	unsigned long long a = randomGenerator() >> 5;
+	unsigned long long b = randomGenerator() >> 6;
+	return ((a * 67108864.0) + b) * (1.0 / 9007199254740992.0);
+}
+
+// Function to return a pair of uniformly distributed random numbers.
+void qbRT::Random::Uniform2D(double &u1, double &u2)
+{
+	if (t_sampler)
+	{
+		t_sampler->Get2D(u1, u2);
+		return;
+	}
+	
+	u1 = Uniform();
+	u2 = Uniform();
+}
+
+// Function to bind a sampler to the calling thread.
+void qbRT::Random::SetThreadSampler(qbRT::Sampler::SamplerBase *sampler)
+{
+	t_sampler = sampler;
+}
+
+// Function to return a reference to the underlying generator.
+std::mt19937 &qbRT::Random::GetGenerator()
+{
+	return randomGenerator;
+}
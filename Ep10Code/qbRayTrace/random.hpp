@@ -0,0 +1,61 @@
+/* ***********************************************************
+	random.hpp
+	
+	Functions for generating random numbers - A single, seedable
+	source of random numbers shared by everything in the renderer
+	that needs to take random samples. While a sampler is bound to
+	the calling thread, the numbers come from the current sample of
+	that sampler instead, one dimension after another, so code that
+	takes random samples uses whichever sampler the render has set
+	up without needing to know about it.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+// random.hpp
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <random>
+
+namespace qbRT
+{
+	namespace Sampler
+	{
+		class SamplerBase;
+	}
+	
+	namespace Random
+	{
+		// Function to seed the random number generator.
+		void Seed(unsigned int seed);
+		
+		// Function to return a uniformly distributed random number in the range [0,1).
+		double Uniform();
+		
+		/* Function to return a pair of uniformly distributed random numbers in the range
+			[0,1), for choices such as a point on a light, that are made in two dimensions.
+			Samplers spread the pairs over the square, rather than each number separately. */
+		void Uniform2D(double &u1, double &u2);
+		
+		/* Function to bind a sampler to the calling thread, or to unbind it if null.
+			The sampler must already have been started on the sample to be taken. */
+		void SetThreadSampler(qbRT::Sampler::SamplerBase *sampler);
+		
+		// Function to return a reference to the underlying generator.
+		std::mt19937 &GetGenerator();
+	}
+}
+
+#endif
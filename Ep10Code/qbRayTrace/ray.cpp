@@ -48,3 +48,50 @@ qbVector<double> qbRT::Ray::GetPoint2() const
 {
 	return m_point2;
 }
+
+// Function to attach the ray differentials.
+void qbRT::Ray::SetDifferentials(const qbRT::Ray &rayX, const qbRT::Ray &rayY)
+{
+	// Store the auxiliary rays without any differentials of their own.
+	for (int j=0; j<3; ++j)
+	{
+		m_differentialOrigin[0][j] = rayX.m_point1.GetElement(j);
+		m_differentialDirection[0][j] = rayX.m_lab.GetElement(j);
+		m_differentialOrigin[1][j] = rayY.m_point1.GetElement(j);
+		m_differentialDirection[1][j] = rayY.m_lab.GetElement(j);
+	}
+	m_hasDifferentials = true;
+}
+
+// Function to remove the ray differentials.
+void qbRT::Ray::ClearDifferentials()
+{
+	m_hasDifferentials = false;
+}
+
+// Function to test whether the ray carries differentials.
+bool qbRT::Ray::HasDifferentials() const
+{
+	return m_hasDifferentials;
+}
+
+// Function to return one of the auxiliary rays.
+qbRT::Ray qbRT::Ray::GetDifferential(int index) const
+{
+	const double *origin = m_differentialOrigin[index];
+	const double *direction = m_differentialDirection[index];
+	qbVector<double> point1 {std::vector<double> {origin[0], origin[1], origin[2]}};
+	qbVector<double> lab {std::vector<double> {direction[0], direction[1], direction[2]}};
+	return qbRT::Ray (point1, point1 + lab);
+}
+
+// Function to return a copy of this ray without the differentials.
+qbRT::Ray qbRT::Ray::GetBaseRay() const
+{
+	// Copy only the ray itself, leaving the auxiliary rays behind.
+	qbRT::Ray baseRay;
+	baseRay.m_point1 = m_point1;
+	baseRay.m_point2 = m_point2;
+	baseRay.m_lab = m_lab;
+	return baseRay;
+}
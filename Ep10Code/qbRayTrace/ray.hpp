@@ -39,11 +39,31 @@ namespace qbRT
 			qbVector<double> GetPoint1() const;
 			qbVector<double> GetPoint2() const;
 			
+			/* Functions to attach and remove the ray differentials. These are
+				auxiliary rays offset by one pixel step in x and y, used to estimate
+				how large an area the ray covers where it hits a surface. */
+			void SetDifferentials(const qbRT::Ray &rayX, const qbRT::Ray &rayY);
+			void ClearDifferentials();
+			bool HasDifferentials() const;
+			
+			// Function to return one of the auxiliary rays, 0 for the step in x and 1 for the step in y.
+			qbRT::Ray GetDifferential(int index) const;
+			
+			// Function to return a copy of this ray without the differentials.
+			qbRT::Ray GetBaseRay() const;
+			
 		public:
 			qbVector<double> m_point1	{3};
 			qbVector<double> m_point2 {3};
 			qbVector<double> m_lab		{3};
 			
+			/* The origin and direction of the auxiliary rays in x and y, held in plain
+				arrays so that copying a ray allocates nothing more for them. They are only
+				valid if m_hasDifferentials is true. */
+			double m_differentialOrigin[2][3];
+			double m_differentialDirection[2][3];
+			bool m_hasDifferentials = false;
+			
 	};
 }
 
@@ -28,6 +28,15 @@
 #include "./qbMaterials/simplerefractive.hpp"
 #include "./qbTextures/checker.hpp"
 #include "./qbTextures/image.hpp"
+#include "./qbTextures/texturecache.hpp"
+#include "random.hpp"
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <limits>
 
 // The constructor.
 qbRT::Scene::Scene()
@@ -61,7 +70,7 @@ qbRT::Scene::Scene()
 																0.0,
 																qbVector<double>{std::vector<double>{16.0, 16.0}} );
 																
-	imageTexture -> LoadImage("testImage.bmp");
+	imageTexture -> LoadImageAsync("testImage.bmp");
 	imageTexture -> SetTransform(	qbVector<double>{std::vector<double>{0.0, 0.0}},
 																0.0,
 																qbVector<double>{std::vector<double>{1.0, 1.0}}	);
@@ -173,25 +182,30 @@ qbRT::Scene::Scene()
 	m_lightList.at(1) -> m_location = qbVector<double> {std::vector<double> {0.0, -10.0, -5.0}};
 	m_lightList.at(1) -> m_color = qbVector<double> {std::vector<double> {1.0, 1.0, 1.0}};
 	m_lightList.at(1) -> m_intensity = 2.0;
-
+	
+	// **************************************************************************************	
+	// Wait for any textures that are still loading in the background.
+	// **************************************************************************************	
+	qbRT::Texture::TextureRegistry::GetShared().WaitAll();
 }
 
 // Function to perform the rendering.
 bool qbRT::Scene::Render(qbImage &outputImage)
 {
+	PrepareLights();
+	
+	// If anti-aliasing has been enabled, use the adaptive renderer instead.
+	if (m_aaMaxSamples > 1)
+		return RenderAdaptive(outputImage);
+		
 	// Get the dimensions of the output image.
 	int xSize = outputImage.GetXSize();
 	int ySize = outputImage.GetYSize();
 	
 	// Loop over each pixel in our image.
-	qbRT::Ray cameraRay;
-	qbVector<double> intPoint			(3);
-	qbVector<double> localNormal	(3);
-	qbVector<double> localColor		(3);
 	double xFact = 1.0 / (static_cast<double>(xSize) / 2.0);
 	double yFact = 1.0 / (static_cast<double>(ySize) / 2.0);
-	double minDist = 1e6;
-	double maxDist = 0.0;
+	qbVector<double> color {3};
 	for (int y=0; y<ySize; ++y)
 	{
 		// Display progress.
@@ -204,46 +218,705 @@ bool qbRT::Scene::Render(qbImage &outputImage)
 			double normX = (static_cast<double>(x) * xFact) - 1.0;
 			double normY = (static_cast<double>(y) * yFact) - 1.0;
 			
-			// Generate the ray for this pixel.
-			m_camera.GenerateRay(normX, normY, cameraRay);
-			
-			// Test for intersections with all objects in the scene.
-			std::shared_ptr<qbRT::ObjectBase> closestObject;
-			qbVector<double> closestIntPoint		{3};
-			qbVector<double> closestLocalNormal	{3};
-			qbVector<double> closestLocalColor	{3};
-			bool intersectionFound = CastRay(cameraRay, closestObject, closestIntPoint, closestLocalNormal, closestLocalColor);
+			// The ray passes through the corner of the pixel, but the sampler still drives any shading choices.
+			if (m_sampler)
+			{
+				m_sampler->StartPixelSample(x, y, 0);
+				qbRT::Random::SetThreadSampler(m_sampler.get());
+			}
 			
-			/* Compute the illumination for the closest object, assuming that there
-				was a valid intersection. */
-			if (intersectionFound)
+			// Compute the color for this pixel, assuming that the ray hit something or saw the environment.
+			if (ComputeSampleColor(normX, normY, xFact, yFact, color))
+				outputImage.SetPixel(x, y, color.GetElement(0), color.GetElement(1), color.GetElement(2));
+			qbRT::Random::SetThreadSampler(nullptr);
+		}
+	}
+	
+	std::cout << std::endl;
+	return true;
+}
+
+// Function to render with adaptive anti-aliasing.
+bool qbRT::Scene::RenderAdaptive(qbImage &outputImage)
+{
+	// Get the dimensions of the output image.
+	int xSize = outputImage.GetXSize();
+	int ySize = outputImage.GetYSize();
+	
+	/* The initial samples are stratified over a square grid, so round the
+		requested number of samples to the nearest square. */
+	int gridSize = std::max(1, static_cast<int>(round(sqrt(static_cast<double>(m_aaMinSamples)))));
+	int maxSamples = std::max(m_aaMaxSamples, gridSize * gridSize);
+	
+	// Start with an empty accumulation buffer.
+	m_accumBuffer.Initialize(xSize, ySize);
+	m_passCount = 0;
+	
+	// First pass, take the initial stratified samples for every pixel.
+	for (int y=0; y<ySize; ++y)
+	{
+		// Display progress.
+		std::cout << "Processing line " << y << " of " << ySize << "." << " \r";
+		std::cout.flush();
+		
+		for (int x=0; x<xSize; ++x)
+			SamplePixel(x, y, gridSize, maxSamples);
+	}
+	std::cout << std::endl;
+	
+	/* Second pass, refine pixels that either have a high variance or
+		that contrast strongly with any of their neighbours. The contrast
+		is computed from the first pass values, before any refinement. */
+	std::vector<double> firstPassLum (xSize * ySize);
+	for (int y=0; y<ySize; ++y)
+	{
+		for (int x=0; x<xSize; ++x)
+			firstPassLum.at((y * xSize) + x) = m_accumBuffer.GetLuminance(x, y);
+	}
+	
+	int refinedPixels = 0;
+	long long totalSamples = 0;
+	for (int y=0; y<ySize; ++y)
+	{
+		// Display progress.
+		std::cout << "Refining line " << y << " of " << ySize << "." << " \r";
+		std::cout.flush();
+		
+		for (int x=0; x<xSize; ++x)
+		{
+			// Compute the largest contrast with any of the four neighbours.
+			double contrast = 0.0;
+			double lum = firstPassLum.at((y * xSize) + x);
+			const int offsets[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+			for (auto &offset : offsets)
 			{
-				// Check if the object has a material.
-				if (closestObject -> m_hasMaterial)
+				int nx = x + offset[0];
+				int ny = y + offset[1];
+				if ((nx >= 0) && (nx < xSize) && (ny >= 0) && (ny < ySize))
 				{
-					// Use the material to compute the color.
-					qbRT::MaterialBase::m_reflectionRayCount = 0;
-					qbVector<double> color = closestObject -> m_pMaterial -> ComputeColor(	m_objectList, m_lightList,
-																																									closestObject, closestIntPoint,
-																																									closestLocalNormal, cameraRay);
-					outputImage.SetPixel(x, y, color.GetElement(0), color.GetElement(1), color.GetElement(2));
+					double otherLum = firstPassLum.at((ny * xSize) + nx);
+					double sum = lum + otherLum;
+					if (sum > 1e-6)
+						contrast = std::max(contrast, fabs(lum - otherLum) / sum);
 				}
-				else
+			}
+			
+			/* Pixels on an edge always get at least one extra batch of samples,
+				after which we keep going until the noise is low enough or we have
+				reached the sample limit. */
+			bool refine = (contrast > m_aaContrast) || (m_accumBuffer.GetRelativeError(x, y) > m_aaThreshold);
+			if (refine)
+				refinedPixels++;
+			while (refine && (m_accumBuffer.GetSampleCount(x, y) < maxSamples))
+			{
+				SamplePixel(x, y, gridSize, maxSamples);
+				refine = (m_accumBuffer.GetRelativeError(x, y) > m_aaThreshold);
+			}
+			
+			totalSamples += m_accumBuffer.GetSampleCount(x, y);
+		}
+	}
+	std::cout << std::endl;
+	
+	// Store the final colors.
+	m_accumBuffer.WriteToImage(outputImage);
+	
+	std::cout << "Refined " << refinedPixels << " of " << xSize * ySize << " pixels, average of "
+						<< static_cast<double>(totalSamples) / static_cast<double>(xSize * ySize) << " samples per pixel." << std::endl;
+	
+	return true;
+}
+
+// Function to perform a single progressive pass.
+bool qbRT::Scene::RenderPass(qbImage &outputImage)
+{
+	PrepareLights();
+	
+	// Get the dimensions of the output image.
+	int xSize = outputImage.GetXSize();
+	int ySize = outputImage.GetYSize();
+	
+	// If the image size has changed, then start accumulating again.
+	if ((m_accumBuffer.GetXSize() != xSize) || (m_accumBuffer.GetYSize() != ySize))
+	{
+		m_accumBuffer.Initialize(xSize, ySize);
+		m_passCount = 0;
+		m_tileDone.clear();
+	}
+	m_resumePending = false;
+	m_lastCheckpoint = std::chrono::steady_clock::now();
+	
+	// Add one sample, at a random point within the pixel, to every pixel.
+	AccumulatePass(0.0, std::chrono::steady_clock::time_point::max());
+	m_passCount++;
+	
+	// Write the current estimate to the output image.
+	m_accumBuffer.WriteToImage(outputImage);
+	
+	return true;
+}
+
+// Function to render within a time budget or to a target error.
+bool qbRT::Scene::RenderToTarget(qbImage &outputImage, double timeBudget, double targetError)
+{
+	// Without either limit this would never finish.
+	if ((timeBudget <= 0.0) && (targetError <= 0.0))
+		return false;
+		
+	/* Work out the deadline first, so that the time taken to prepare the lights,
+		which may include building the photon map, counts towards the budget. */
+	auto startTime = std::chrono::steady_clock::now();
+	auto deadline = std::chrono::steady_clock::time_point::max();
+	if (timeBudget > 0.0)
+		deadline = startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(timeBudget));
+		
+	PrepareLights();
+	
+	/* Start with an empty accumulation buffer, unless we are carrying on
+		from a checkpoint of a render of the same size. */
+	int xSize = outputImage.GetXSize();
+	int ySize = outputImage.GetYSize();
+	if (!m_resumePending || (m_accumBuffer.GetXSize() != xSize) || (m_accumBuffer.GetYSize() != ySize))
+	{
+		m_accumBuffer.Initialize(xSize, ySize);
+		m_passCount = 0;
+		m_tileDone.clear();
+	}
+	m_resumePending = false;
+	m_tileTime = 0.0;
+	m_lastCheckpoint = startTime;
+	
+	// Keep adding passes until we run out of time, reach the target or reach the pass limit.
+	int pixelsAboveTarget = -1;
+	while (m_passCount < m_targetMaxPasses)
+	{
+		// Only start skipping converged pixels once the error estimates can be trusted.
+		double passTarget = (m_passCount >= m_targetMinPasses) ? targetError : 0.0;
+		bool passComplete = AccumulatePass(passTarget, deadline);
+		if (!passComplete)
+			break;
+		m_passCount++;
+		
+		// Check whether every pixel has reached the target.
+		if ((targetError > 0.0) && (m_passCount >= m_targetMinPasses))
+		{
+			pixelsAboveTarget = 0;
+			for (int y=0; y<ySize; ++y)
+			{
+				for (int x=0; x<xSize; ++x)
 				{
-					// Use the basic method to compute the color.
-					qbVector<double> matColor = qbRT::MaterialBase::ComputeDiffuseColor(m_objectList, m_lightList,
-																																							closestObject, closestIntPoint,
-																																							closestLocalNormal, closestObject->m_baseColor);
-					outputImage.SetPixel(x, y, matColor.GetElement(0), matColor.GetElement(1), matColor.GetElement(2));
+					if (m_accumBuffer.GetRelativeError(x, y) > targetError)
+						pixelsAboveTarget++;
 				}
 			}
+			
+			if (pixelsAboveTarget == 0)
+				break;
 		}
 	}
-	
 	std::cout << std::endl;
+	
+	// Finalise the image with whatever we have accumulated.
+	m_accumBuffer.WriteToImage(outputImage);
+	
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	std::cout << "Completed " << m_passCount << " passes in " << elapsed << " seconds";
+	if (pixelsAboveTarget >= 0)
+		std::cout << ", " << pixelsAboveTarget << " pixels above the target error";
+	std::cout << "." << std::endl;
+	
+	return true;
+}
+
+// Function to add one sample to every pixel that still needs one.
+bool qbRT::Scene::AccumulatePass(double targetError, const std::chrono::steady_clock::time_point &deadline)
+{
+	int xSize = m_accumBuffer.GetXSize();
+	int ySize = m_accumBuffer.GetYSize();
+	int tilesX = (xSize + m_tileSize - 1) / m_tileSize;
+	int tilesY = (ySize + m_tileSize - 1) / m_tileSize;
+	int numTiles = tilesX * tilesY;
+	
+	// If the tile map does not match, then none of the tiles in this pass have been done yet.
+	if (static_cast<int>(m_tileDone.size()) != numTiles)
+		m_tileDone.assign(numTiles, 0);
+		
+	// Work out the order in which to visit the tiles and the pixels within them.
+	std::vector<int> tileOrder = qbRT::Traversal::BuildOrder(tilesX, tilesY, m_tileOrder);
+	std::vector<int> pixelOrder = qbRT::Traversal::BuildOrder(m_tileSize, m_tileSize, m_pixelOrder);
+	
+	// Start collecting statistics for this pass.
+	auto passStart = std::chrono::steady_clock::now();
+	long long startSamples = m_statSamples;
+	long long startSwitches = m_statObjectSwitches;
+	long long startMisses = m_perfCounter.GetCount();
+	qbRT::Texture::TextureCache &textureCache = qbRT::Texture::TextureCache::GetShared();
+	uint64_t startTextureHits = textureCache.GetHits();
+	uint64_t startTextureMisses = textureCache.GetMisses();
+	m_lastHitObject = nullptr;
+	m_perfCounter.Start();
+	
+	for (int tileNumber=0; tileNumber<numTiles; ++tileNumber)
+	{
+		// Skip tiles that were completed before a checkpoint was taken.
+		int tile = tileOrder.at(tileNumber);
+		if (m_tileDone.at(tile))
+			continue;
+			
+		/* Stop if the next tile is not expected to finish before the deadline. We
+			allow some headroom, as tiles vary in cost. Any pixels that miss out on
+			this pass just end up with one fewer sample. */
+		auto tileStart = std::chrono::steady_clock::now();
+		if (deadline != std::chrono::steady_clock::time_point::max())
+		{
+			double remaining = std::chrono::duration<double>(deadline - tileStart).count();
+			if (remaining < (1.5 * m_tileTime))
+			{
+				m_perfCounter.Stop();
+				return false;
+			}
+		}
+			
+		// Display progress.
+		std::cout << "Pass " << m_passCount + 1 << ", processing tile " << tileNumber << " of " << numTiles << "." << " \r";
+		std::cout.flush();
+		
+		int x0 = (tile % tilesX) * m_tileSize;
+		int y0 = (tile / tilesX) * m_tileSize;
+		for (int pixel : pixelOrder)
+		{
+			// Tiles at the edges of the image may only be partly filled.
+			int x = x0 + (pixel % m_tileSize);
+			int y = y0 + (pixel / m_tileSize);
+			if ((x >= xSize) || (y >= ySize))
+				continue;
+				
+			if ((targetError <= 0.0) || (m_accumBuffer.GetRelativeError(x, y) > targetError))
+				SamplePixel(x, y, 1, std::numeric_limits<int>::max());
+		}
+		m_tileDone.at(tile) = 1;
+		
+		// Update the estimate of the time per tile, favouring the most recent tiles.
+		auto tileEnd = std::chrono::steady_clock::now();
+		double tileTime = std::chrono::duration<double>(tileEnd - tileStart).count();
+		m_tileTime = (m_tileTime == 0.0) ? tileTime : std::max(tileTime, (0.9 * m_tileTime) + (0.1 * tileTime));
+		
+		// Write a checkpoint if one is due.
+		if (!m_checkpointFile.empty() && (std::chrono::duration<double>(tileEnd - m_lastCheckpoint).count() >= m_checkpointInterval))
+		{
+			m_perfCounter.Stop();
+			SaveCheckpoint(m_checkpointFile);
+			m_lastCheckpoint = tileEnd;
+			m_perfCounter.Start();
+		}
+	}
+	m_perfCounter.Stop();
+	
+	// Report the statistics for this pass.
+	double passTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - passStart).count();
+	long long passSamples = m_statSamples - startSamples;
+	if (passSamples > 0)
+	{
+		std::cout << std::endl << "Pass " << m_passCount + 1 << " (tiles " << qbRT::Traversal::GetName(m_tileOrder)
+							<< ", pixels " << qbRT::Traversal::GetName(m_pixelOrder) << "): "
+							<< static_cast<double>(passSamples) / passTime << " samples per second, ";
+		if (m_perfCounter.IsAvailable())
+			std::cout << static_cast<double>(m_perfCounter.GetCount() - startMisses) / passSamples << " cache misses per sample, ";
+		else
+			std::cout << "cache misses not available, ";
+		std::cout << (100.0 * (m_statObjectSwitches - startSwitches)) / passSamples << "% object switches." << std::endl;
+		
+		// Only report on the texture cache if it was used.
+		uint64_t textureHits = textureCache.GetHits() - startTextureHits;
+		uint64_t textureMisses = textureCache.GetMisses() - startTextureMisses;
+		if ((textureHits + textureMisses) > 0)
+		{
+			std::cout << "Texture cache: " << textureHits << " hits, " << textureMisses << " misses ("
+								<< (100.0 * textureHits) / (textureHits + textureMisses) << "% hit rate), "
+								<< textureCache.GetMemoryUsed() / 1024 << " KB in use." << std::endl;
+		}
+		
+		if (m_ambientOcclusion && (m_ambientOcclusion->GetRaysCast() > 0))
+		{
+			std::cout << "Ambient occlusion: " << m_ambientOcclusion->GetRaysCast() << " rays, "
+								<< static_cast<double>(m_ambientOcclusion->GetObjectsTested()) / m_ambientOcclusion->GetRaysCast()
+								<< " objects tested per ray." << std::endl;
+			m_ambientOcclusion->ResetStats();
+		}
+	}
+	
+	// The pass is complete, so clear the tile map ready for the next one.
+	m_tileDone.assign(numTiles, 0);
+	
 	return true;
 }
 
+// Function to save a checkpoint of a progressive render.
+bool qbRT::Scene::SaveCheckpoint(const std::string &fileName)
+{
+	/* Write to a temporary file first and then rename it, so that a crash
+		part way through writing can never destroy the previous checkpoint. */
+	std::string tempFileName = fileName + ".tmp";
+	std::ofstream outputFile (tempFileName, std::ios::binary | std::ios::trunc);
+	if (!outputFile)
+	{
+		std::cout << "Failed to write checkpoint " << tempFileName << "." << std::endl;
+		return false;
+	}
+	
+	// The header.
+	const char magic[4] = {'Q', 'B', 'C', 'P'};
+	int32_t header[6] = {	2, m_tileSize, m_passCount, static_cast<int32_t>(m_tileDone.size()),
+												static_cast<int32_t>(m_tileOrder), static_cast<int32_t>(m_pixelOrder)};
+	outputFile.write(magic, sizeof(magic));
+	outputFile.write(reinterpret_cast<const char *>(header), sizeof(header));
+	
+	// The state of the random number generator.
+	std::ostringstream rngStream;
+	rngStream << qbRT::Random::GetGenerator();
+	std::string rngState = rngStream.str();
+	int32_t rngLength = static_cast<int32_t>(rngState.size());
+	outputFile.write(reinterpret_cast<const char *>(&rngLength), sizeof(rngLength));
+	outputFile.write(rngState.data(), rngLength);
+	
+	// The tile map, packed into bits.
+	std::vector<unsigned char> tileBits ((m_tileDone.size() + 7) / 8, 0);
+	for (size_t i=0; i<m_tileDone.size(); ++i)
+	{
+		if (m_tileDone.at(i))
+			tileBits.at(i / 8) |= static_cast<unsigned char>(1 << (i % 8));
+	}
+	outputFile.write(reinterpret_cast<const char *>(tileBits.data()), tileBits.size());
+	
+	// And finally the accumulation buffer itself.
+	m_accumBuffer.Write(outputFile);
+	outputFile.close();
+	if (!outputFile)
+	{
+		std::cout << "Failed to write checkpoint " << tempFileName << "." << std::endl;
+		return false;
+	}
+	
+	return (std::rename(tempFileName.c_str(), fileName.c_str()) == 0);
+}
+
+// Function to load a checkpoint of a progressive render.
+bool qbRT::Scene::LoadCheckpoint(const std::string &fileName, int xSize, int ySize)
+{
+	std::ifstream inputFile (fileName, std::ios::binary);
+	if (!inputFile)
+	{
+		std::cout << "Failed to open checkpoint " << fileName << "." << std::endl;
+		return false;
+	}
+	
+	// Check the header.
+	char magic[4];
+	int32_t header[6];
+	inputFile.read(magic, sizeof(magic));
+	inputFile.read(reinterpret_cast<char *>(header), sizeof(header));
+	if (!inputFile || (std::string(magic, 4) != "QBCP") || (header[0] != 2))
+	{
+		std::cout << "Checkpoint " << fileName << " is not valid." << std::endl;
+		return false;
+	}
+	
+	/* Check that the settings are in range before anything is allocated from them.
+		Tiles larger than 4096 pixels would only waste memory on the pixel order. The
+		tile map is empty until the first pass, and after that covers the image. */
+	int32_t tileSize = header[1];
+	bool headerValid = (xSize > 0) && (ySize > 0) && (tileSize > 0) && (tileSize <= 4096) && (header[2] >= 0);
+	if (headerValid)
+	{
+		int32_t numTiles = ((xSize + tileSize - 1) / tileSize) * ((ySize + tileSize - 1) / tileSize);
+		headerValid = (header[3] == 0) || (header[3] == numTiles);
+	}
+	int32_t lastOrder = static_cast<int32_t>(qbRT::Traversal::Order::Spiral);
+	headerValid = headerValid && (header[4] >= 0) && (header[4] <= lastOrder) && (header[5] >= 0) && (header[5] <= lastOrder);
+	if (!headerValid)
+	{
+		std::cout << "Checkpoint " << fileName << " does not match a " << xSize << " x " << ySize << " render." << std::endl;
+		return false;
+	}
+	
+	/* Read the state of the random number generator. Written as text, it takes
+		under 7 KB, so anything much longer is not a generator state. */
+	int32_t rngLength = 0;
+	inputFile.read(reinterpret_cast<char *>(&rngLength), sizeof(rngLength));
+	if (!inputFile || (rngLength <= 0) || (rngLength > 16384))
+	{
+		std::cout << "Checkpoint " << fileName << " is not valid." << std::endl;
+		return false;
+	}
+	std::string rngState (rngLength, ' ');
+	inputFile.read(&rngState[0], rngLength);
+	std::mt19937 generator;
+	std::istringstream rngStream (rngState);
+	rngStream >> generator;
+	
+	// Read the tile map.
+	std::vector<unsigned char> tileBits ((header[3] + 7) / 8, 0);
+	inputFile.read(reinterpret_cast<char *>(tileBits.data()), tileBits.size());
+	
+	// And the accumulation buffer.
+	qbRT::AccumBuffer accumBuffer;
+	if (!inputFile || rngStream.fail() || !accumBuffer.Read(inputFile, xSize, ySize))
+	{
+		std::cout << "Checkpoint " << fileName << " is not valid." << std::endl;
+		return false;
+	}
+	
+	// Everything was read successfully, so now we can update the scene.
+	m_tileSize = header[1];
+	m_passCount = header[2];
+	m_tileOrder = static_cast<qbRT::Traversal::Order>(header[4]);
+	m_pixelOrder = static_cast<qbRT::Traversal::Order>(header[5]);
+	m_tileDone.assign(header[3], 0);
+	for (size_t i=0; i<m_tileDone.size(); ++i)
+		m_tileDone.at(i) = (tileBits.at(i / 8) >> (i % 8)) & 1;
+	qbRT::Random::GetGenerator() = generator;
+	m_accumBuffer = accumBuffer;
+	m_resumePending = true;
+	
+	std::cout << "Resuming from pass " << m_passCount + 1 << " of checkpoint " << fileName << "." << std::endl;
+	return true;
+}
+
+// Function to discard all accumulated samples.
+void qbRT::Scene::ResetAccumulation()
+{
+	m_accumBuffer.Reset();
+	m_passCount = 0;
+	m_tileDone.clear();
+	m_resumePending = false;
+}
+
+// Function to return the number of progressive passes accumulated so far.
+int qbRT::Scene::GetPassCount()
+{
+	return m_passCount;
+}
+
+// Function to return the accumulation buffer.
+const qbRT::AccumBuffer &qbRT::Scene::GetAccumBuffer()
+{
+	return m_accumBuffer;
+}
+
+// Function to build the light tree and grid.
+void qbRT::Scene::PrepareLights()
+{
+	/* Hash everything about the lights that the tree and grid depend on, so that
+		they are rebuilt if any light has moved or changed, not only if lights have
+		been added or removed. */
+	int numLights = static_cast<int>(m_lightList.size());
+	bool hasRadius = false;
+	uint64_t lightHash = 1469598103934665603ULL;
+	auto hashValue = [&lightHash](double value)
+	{
+		uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		lightHash = (lightHash ^ bits) * 1099511628211ULL;
+	};
+	hashValue(static_cast<double>(numLights));
+	for (auto &currentLight : m_lightList)
+	{
+		hasRadius = hasRadius || (currentLight->m_radius > 0.0);
+		for (int i=0; i<3; ++i)
+		{
+			hashValue(currentLight->m_location.GetElement(i));
+			hashValue(currentLight->m_color.GetElement(i));
+		}
+		hashValue(currentLight->m_radius);
+		hashValue(currentLight->GetExtent());
+		hashValue(currentLight->m_intensity);
+	}
+	bool lightsChanged = (lightHash != m_lightHash);
+	m_lightHash = lightHash;
+	
+	/* The photon map and the irradiance cache also depend on where the objects are,
+		and the map on how much their materials scatter specularly, so carry on hashing
+		those to tell when they are out of date. Other changes to the materials need
+		them to be cleared by hand. */
+	hashValue(static_cast<double>(m_objectList.size()));
+	for (auto &currentObject : m_objectList)
+	{
+		qbMatrix2<double> fwdtfm = currentObject->m_transformMatrix.GetForward();
+		for (int i=0; i<4; ++i)
+		{
+			for (int j=0; j<4; ++j)
+				hashValue(fwdtfm.GetElement(i, j));
+		}
+		hashValue(currentObject->m_hasMaterial ? currentObject->m_pMaterial->GetSpecularProbability() : -1.0);
+	}
+	if (m_photonMap)
+	{
+		hashValue(static_cast<double>(m_photonMap->m_numPhotons));
+		hashValue(static_cast<double>(m_photonMap->m_maxBounces));
+	}
+	bool sceneChanged = (lightHash != m_sceneHash);
+	m_sceneHash = lightHash;
+	
+	// The tree chooses which lights to use and the grid culls those out of range, so a scene may need both.
+	if (numLights > m_lightTreeThreshold)
+	{
+		if (!m_lightTree || lightsChanged)
+		{
+			m_lightTree = std::make_shared<qbRT::LightTree>();
+			m_lightTree->Build(m_lightList);
+		}
+	}
+	else
+	{
+		m_lightTree.reset();
+	}
+	
+	if (hasRadius)
+	{
+		if (!m_lightGrid || lightsChanged)
+		{
+			m_lightGrid = std::make_shared<qbRT::LightGrid>();
+			m_lightGrid->Build(m_lightList);
+		}
+	}
+	else
+	{
+		m_lightGrid.reset();
+	}
+	
+	qbRT::MaterialBase::m_lightTree = m_lightTree;
+	qbRT::MaterialBase::m_lightGrid = m_lightGrid;
+	qbRT::MaterialBase::m_environmentLight = m_environmentLight;
+	qbRT::MaterialBase::m_irradianceCache = m_irradianceCache;
+	
+	// The records cached for the old lights or objects no longer apply.
+	if (m_irradianceCache && sceneChanged)
+		m_irradianceCache->Clear();
+	
+	if (m_photonMap && (!m_photonMap->IsBuilt() || sceneChanged))
+		m_photonMap->Build(m_objectList, m_lightList);
+	qbRT::MaterialBase::m_photonMap = m_photonMap;
+	
+	// The objects may have moved since the last render, so find their bounds again.
+	if (!m_ambientOcclusion && (m_output == Output::AmbientOcclusion))
+		m_ambientOcclusion = std::make_shared<qbRT::AmbientOcclusion>();
+	if (m_ambientOcclusion)
+		m_ambientOcclusion->Prepare(m_objectList);
+	qbRT::MaterialBase::m_ambientOcclusion = (m_output == Output::Color) ? m_ambientOcclusion : nullptr;
+}
+
+// Function to add a stratified batch of gridSize x gridSize samples to a pixel.
+void qbRT::Scene::SamplePixel(int x, int y, int gridSize, int maxSamples)
+{
+	double xFact = 1.0 / (static_cast<double>(m_accumBuffer.GetXSize()) / 2.0);
+	double yFact = 1.0 / (static_cast<double>(m_accumBuffer.GetYSize()) / 2.0);
+	qbVector<double> color {3};
+	for (int j=0; j<gridSize; ++j)
+	{
+		for (int i=0; i<gridSize; ++i)
+		{
+			if (m_accumBuffer.GetSampleCount(x, y) >= maxSamples)
+				return;
+				
+			/* Pick a random point within this stratum, or let the sampler choose the point
+				within the pixel, as it spreads its samples out by itself. */
+			double sx, sy;
+			if (m_sampler)
+			{
+				m_sampler->StartPixelSample(x, y, m_accumBuffer.GetSampleCount(x, y));
+				qbRT::Random::SetThreadSampler(m_sampler.get());
+				qbRT::Random::Uniform2D(sx, sy);
+			}
+			else
+			{
+				sx = (static_cast<double>(i) + qbRT::Random::Uniform()) / static_cast<double>(gridSize);
+				sy = (static_cast<double>(j) + qbRT::Random::Uniform()) / static_cast<double>(gridSize);
+			}
+			double normX = ((static_cast<double>(x) + sx) * xFact) - 1.0;
+			double normY = ((static_cast<double>(y) + sy) * yFact) - 1.0;
+			
+			// Rays that miss everything, with no environment, contribute black.
+			if (!ComputeSampleColor(normX, normY, xFact / static_cast<double>(gridSize), yFact / static_cast<double>(gridSize), color))
+				color = qbVector<double>{3};
+			qbRT::Random::SetThreadSampler(nullptr);
+				
+			m_accumBuffer.AddSample(x, y, color);
+		}
+	}
+}
+
+// Function to compute the color seen along a single camera ray.
+bool qbRT::Scene::ComputeSampleColor(double normX, double normY, double stepX, double stepY, qbVector<double> &color)
+{
+	// Generate the ray for this point on the screen.
+	qbRT::Ray cameraRay;
+	m_camera.GenerateRay(normX, normY, cameraRay);
+	
+	// Test for intersections with all objects in the scene.
+	std::shared_ptr<qbRT::ObjectBase> closestObject;
+	qbVector<double> closestIntPoint		{3};
+	qbVector<double> closestLocalNormal	{3};
+	qbVector<double> closestLocalColor	{3};
+	bool intersectionFound = CastRay(cameraRay, closestObject, closestIntPoint, closestLocalNormal, closestLocalColor);
+	
+	/* Only the central ray is tested, so the differentials through the neighbouring
+		pixels need only be added if the object hit has a texture that uses them. */
+	if (intersectionFound && qbRT::MaterialBase::NeedsDifferentials(closestObject))
+		m_camera.GenerateRay(normX, normY, stepX, stepY, cameraRay);
+	
+	// Keep track of how often consecutive samples hit different objects.
+	const qbRT::ObjectBase *hitObject = intersectionFound ? closestObject.get() : nullptr;
+	if (hitObject != m_lastHitObject)
+		m_statObjectSwitches++;
+	m_lastHitObject = hitObject;
+	m_statSamples++;
+	
+	// For the ambient occlusion output, only the geometry at the first hit matters.
+	if (m_output == Output::AmbientOcclusion)
+	{
+		if (!intersectionFound)
+			return false;
+			
+		double visibility = m_ambientOcclusion->ComputeVisibility(closestIntPoint, closestLocalNormal, m_objectList, closestObject);
+		color = qbVector<double>{std::vector<double> {visibility, visibility, visibility}};
+		return true;
+	}
+	
+	// The path tracer carries on from the first hit by itself.
+	if (m_pathTracer)
+		return m_pathTracer->ComputeColor(	cameraRay, intersectionFound, closestObject, closestIntPoint, closestLocalNormal,
+																				m_objectList, m_lightList, color);
+	
+	/* Compute the illumination for the closest object, assuming that there
+		was a valid intersection. */
+	if (intersectionFound)
+	{
+		// Check if the object has a material.
+		if (closestObject -> m_hasMaterial)
+		{
+			// Use the material to compute the color.
+			color = closestObject -> m_pMaterial -> ComputeColor(	m_objectList, m_lightList,
+																														closestObject, closestIntPoint,
+																														closestLocalNormal, cameraRay, 0);
+		}
+		else
+		{
+			// Use the basic method to compute the color.
+			color = qbRT::MaterialBase::ComputeDiffuseColor(m_objectList, m_lightList,
+																											closestObject, closestIntPoint,
+																											closestLocalNormal, closestObject->m_baseColor);
+		}
+	}
+	else if (m_environmentLight && m_environmentLight->IsValid())
+	{
+		// The ray sees the environment.
+		color = qbRT::MaterialBase::ComputeBackgroundColor(cameraRay);
+		return true;
+	}
+	
+	return intersectionFound;
+}
+
 // Function to cast a ray into the scene.
 bool qbRT::Scene::CastRay(	qbRT::Ray &castRay, std::shared_ptr<qbRT::ObjectBase> &closestObject,
 														qbVector<double> &closestIntPoint, qbVector<double> &closestLocalNormal,
@@ -254,9 +927,12 @@ bool qbRT::Scene::CastRay(	qbRT::Ray &castRay, std::shared_ptr<qbRT::ObjectBase>
 	qbVector<double> localColor		{3};
 	double minDist = 1e6;
 	bool intersectionFound = false;
+	
+	// Test the central ray only, so that the objects do not also transform the differentials.
+	qbRT::Ray testRay = castRay.GetBaseRay();
 	for (auto currentObject : m_objectList)
 	{
-		bool validInt = currentObject -> TestIntersection(castRay, intPoint, localNormal, localColor);
+		bool validInt = currentObject -> TestIntersection(testRay, intPoint, localNormal, localColor);
 		
 		// If we have a valid intersection.
 		if (validInt)
@@ -29,19 +29,39 @@
 
 #include <memory>
 #include <vector>
+#include <chrono>
+#include <string>
+#include <cstdint>
 #include <SDL2/SDL.h>
 #include "qbImage.hpp"
 #include "camera.hpp"
+#include "accumbuffer.hpp"
+#include "traversal.hpp"
+#include "perfcounter.hpp"
+#include "pathtracer.hpp"
 #include "./qbPrimatives/objsphere.hpp"
 #include "./qbPrimatives/objplane.hpp"
 #include "./qbPrimatives/cylinder.hpp"
 #include "./qbPrimatives/cone.hpp"
 #include "./qbLights/pointlight.hpp"
+#include "./qbLights/lighttree.hpp"
+#include "./qbLights/lightgrid.hpp"
+#include "./qbLights/environmentlight.hpp"
+#include "./qbLights/irradiancecache.hpp"
+#include "./qbLights/photonmap.hpp"
+#include "./qbLights/ambientocclusion.hpp"
+#include "./qbSamplers/samplerbase.hpp"
 
 namespace qbRT
 {
 	class Scene
 	{
+		public:
+			/* The quantity written to the image. Color is the shaded scene, and
+				AmbientOcclusion is the fraction of the hemisphere left open at the
+				first surface that each ray hits, as a shade of grey. */
+			enum class Output {Color, AmbientOcclusion};
+			
 		public:
 			// The default constructor.
 			Scene();
@@ -49,13 +69,148 @@ namespace qbRT
 			// Function to perform the rendering.
 			bool Render(qbImage &outputImage);
 			
+			/* Function to perform a single progressive pass. Each pass adds one
+				sample to every pixel of the accumulation buffer and then writes the
+				current estimate to the output image. */
+			bool RenderPass(qbImage &outputImage);
+			
+			/* Function to render within a wall-clock time budget (in seconds) or until
+				the relative error of every pixel is below the target, whichever comes
+				first. A value of zero disables either limit. After the first few passes,
+				only pixels that have not yet reached the target are sampled. */
+			bool RenderToTarget(qbImage &outputImage, double timeBudget, double targetError);
+			
+			/* Functions to save and load a checkpoint of a progressive render. A checkpoint
+				holds the accumulation buffer, the random number generator state and the map
+				of tiles completed in the current pass. After loading a checkpoint, the next
+				call to RenderPass or RenderToTarget carries on from where it left off and
+				produces exactly the same result as a render that was never interrupted,
+				unless the scene has an irradiance cache. Its records are not saved, so
+				they are computed again as they are needed, which changes the result
+				slightly.
+				The size of the image that the render will carry on into must be given
+				when loading, and a checkpoint that does not match it, or whose header is
+				out of range, is rejected and leaves the scene unchanged. */
+			bool SaveCheckpoint(const std::string &fileName);
+			bool LoadCheckpoint(const std::string &fileName, int xSize, int ySize);
+			
+			// Function to discard all accumulated samples, so that the next pass starts afresh.
+			void ResetAccumulation();
+			
+			// Function to return the number of progressive passes accumulated so far.
+			int GetPassCount();
+			
+			// Function to return the accumulation buffer.
+			const qbRT::AccumBuffer &GetAccumBuffer();
+			
 			// Function to cast a ray into the scene.
 			bool CastRay(	qbRT::Ray &castRay, std::shared_ptr<qbRT::ObjectBase> &closestObject,
 										qbVector<double> &closestIntPoint, qbVector<double> &closestLocalNormal,
 										qbVector<double> &closestLocalColor);
 			
+		// Public member variables.
+		public:
+			/* Anti-aliasing settings. Each pixel starts with m_aaMinSamples stratified
+				samples (rounded to a square grid) and pixels that are noisy or differ
+				from their neighbours are refined up to m_aaMaxSamples. With the default
+				m_aaMaxSamples of 1 it is off, and a single ray passes through the corner
+				of each pixel, as before; set both, for example to 4 and 16, to use it. */
+			int m_aaMinSamples = 1;
+			int m_aaMaxSamples = 1;
+			
+			// Refinement thresholds for the relative standard error and the neighbour contrast.
+			double m_aaThreshold = 0.02;
+			double m_aaContrast = 0.1;
+			
+			/* Limits on the number of passes used by RenderToTarget. Error estimates
+				are not trusted until m_targetMinPasses samples have been taken. */
+			int m_targetMinPasses = 4;
+			int m_targetMaxPasses = 1024;
+			
+			// The size of the square tiles that each progressive pass is divided into.
+			int m_tileSize = 32;
+			
+			/* The order in which progressive passes visit the tiles of the image and
+				the pixels within each tile. After each pass, the throughput, cache misses
+				and how often consecutive samples hit different objects are reported, so
+				that the orders can be compared for a given scene. */
+			qbRT::Traversal::Order m_tileOrder = qbRT::Traversal::Order::Scanline;
+			qbRT::Traversal::Order m_pixelOrder = qbRT::Traversal::Order::Scanline;
+			
+			/* If a file name is given, progressive renders write a checkpoint to it
+				every m_checkpointInterval seconds. */
+			std::string m_checkpointFile;
+			double m_checkpointInterval = 60.0;
+			
+			/* In scenes with more lights than this, each point is shaded with a few lights
+				chosen at random from a light tree rather than with every light. The result
+				is noisy but unbiased, and converges as progressive passes accumulate. If any
+				light has a radius, a light grid is also built, to skip the lights that are
+				out of range, and points with no more lights in range than would be chosen
+				from the tree are shaded with all of them instead. */
+			int m_lightTreeThreshold = 64;
+			
+			/* An optional light surrounding the scene, such as the sky. Rays that miss
+				every object see it, rather than black. */
+			std::shared_ptr<qbRT::EnvironmentLight> m_environmentLight;
+			
+			/* An optional irradiance cache, which adds a bounce of indirect diffuse light
+				in place of the constant ambient light. Its records are kept from one pass
+				to the next, and cleared if the lights or the objects' transforms change. */
+			std::shared_ptr<qbRT::IrradianceCache> m_irradianceCache;
+			
+			/* An optional photon map for caustics. It is built before the first pass that
+				uses it, and built again if it is cleared or if the lights, the objects'
+				transforms or their materials' specular probabilities change. */
+			std::shared_ptr<qbRT::PhotonMap> m_photonMap;
+			
+			/* Optional ambient occlusion, which darkens the ambient light where nearby
+				objects block it. It is also used for the AmbientOcclusion output, with
+				default settings if none has been given. */
+			std::shared_ptr<qbRT::AmbientOcclusion> m_ambientOcclusion;
+			
+			// The quantity written to the image.
+			Output m_output = Output::Color;
+			
+			/* An optional sampler, which supplies every random number used for each sample,
+				from the point in the pixel onwards, in place of the shared generator and the
+				stratified grid. Its numbers depend only on the pixel and the number of samples
+				that it already has, so a render gives the same result whatever order the
+				pixels are sampled in. */
+			std::shared_ptr<qbRT::Sampler::SamplerBase> m_sampler;
+			
+			/* An optional path tracer, which computes the color in place of the Whitted
+				shading of the materials, following each ray through every bounce. It needs
+				many samples for each pixel to converge, so is best used with progressive
+				rendering and a sampler. */
+			std::shared_ptr<qbRT::PathTracer> m_pathTracer;
+			
 		// Private functions.
 		private:
+			// Function to render with adaptive anti-aliasing.
+			bool RenderAdaptive(qbImage &outputImage);
+			
+			/* Function to get the lights and their helpers ready for a render. The light
+				tree and grid are built if the scene has lights that need them and the
+				lights have changed since they were last built. The photon map is built if
+				it has not been built since it was created or cleared, or if the lights or
+				objects have changed, in which case the irradiance cache is also cleared.
+				These, the environment light and the ambient occlusion are then passed to
+				the materials. */
+			void PrepareLights();
+			
+			/* Function to add one sample to every pixel whose relative error is above
+				the target (or to every pixel if the target is zero), one tile at a time.
+				Returns false if the pass had to stop early because the next tile would
+				not finish before the deadline. */
+			bool AccumulatePass(double targetError, const std::chrono::steady_clock::time_point &deadline);
+			
+			// Function to add a stratified batch of gridSize x gridSize samples to a pixel.
+			void SamplePixel(int x, int y, int gridSize, int maxSamples);
+			
+			/* Function to compute the color seen along a single camera ray, given
+				the spacing between samples on the screen for the ray differentials. */
+			bool ComputeSampleColor(double normX, double normY, double stepX, double stepY, qbVector<double> &color);
 		
 		// Private members.
 		private:
@@ -67,6 +222,40 @@ namespace qbRT
 	
 			// The list of lights in the scene.
 			std::vector<std::shared_ptr<qbRT::LightBase>> m_lightList;
+			
+			// The tree or grid built over the lights.
+			std::shared_ptr<qbRT::LightTree> m_lightTree;
+			std::shared_ptr<qbRT::LightGrid> m_lightGrid;
+			
+			// A hash of the lights that the tree and grid were built over, to tell when they need rebuilding.
+			uint64_t m_lightHash = 0;
+			
+			// A hash of the lights and objects that the photon map was built over.
+			uint64_t m_sceneHash = 0;
+			
+			// The buffer in which samples are accumulated.
+			qbRT::AccumBuffer m_accumBuffer;
+			
+			// The number of progressive passes accumulated so far.
+			int m_passCount = 0;
+			
+			// A running estimate of the time taken to render one tile, in seconds.
+			double m_tileTime = 0.0;
+			
+			// Flags for the tiles that have been completed in the current pass.
+			std::vector<char> m_tileDone;
+			
+			// The time at which the last checkpoint was written.
+			std::chrono::steady_clock::time_point m_lastCheckpoint;
+			
+			// Flag to indicate that a checkpoint has been loaded and should be continued.
+			bool m_resumePending = false;
+			
+			// Statistics used to compare the traversal orders.
+			qbRT::PerfCounter m_perfCounter;
+			long long m_statSamples = 0;
+			long long m_statObjectSwitches = 0;
+			const qbRT::ObjectBase *m_lastHitObject = nullptr;
 	};
 }
 
@@ -0,0 +1,79 @@
+/* ***********************************************************
+	threadpool.cpp
+	
+	The ThreadPool class implementation - A fixed set of worker threads
+	that run tasks taken from a shared queue, returning a future
+	for the result of each one.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include "threadpool.hpp"
+#include <algorithm>
+
+// Constructor.
+qbRT::ThreadPool::ThreadPool(int numThreads)
+{
+	if (numThreads <= 0)
+		numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+		
+	for (int i=0; i<numThreads; ++i)
+		m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+// Destructor.
+qbRT::ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock (m_mutex);
+		m_stopping = true;
+	}
+	m_condition.notify_all();
+	
+	for (auto &worker : m_workers)
+		worker.join();
+}
+
+// Function to return the shared pool.
+qbRT::ThreadPool &qbRT::ThreadPool::GetShared()
+{
+	static ThreadPool sharedPool;
+	return sharedPool;
+}
+
+// Function to return the number of worker threads.
+int qbRT::ThreadPool::GetNumThreads() const
+{
+	return static_cast<int>(m_workers.size());
+}
+
+// Function run by each of the worker threads.
+void qbRT::ThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			// Wait for a task, or for the pool to stop once the queue is empty.
+			std::unique_lock<std::mutex> lock (m_mutex);
+			m_condition.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+			if (m_tasks.empty())
+				return;
+				
+			task = std::move(m_tasks.front());
+			m_tasks.pop();
+		}
+		
+		task();
+	}
+}
@@ -0,0 +1,92 @@
+/* ***********************************************************
+	threadpool.hpp
+	
+	The ThreadPool class definition - A fixed set of worker threads
+	that run tasks taken from a shared queue, returning a future
+	for the result of each one.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+namespace qbRT
+{
+	class ThreadPool
+	{
+		public:
+			/* Constructor / destructor. With no number of threads given, one is
+				started for each hardware thread. The destructor finishes any tasks
+				that are still queued before returning. */
+			explicit ThreadPool(int numThreads = 0);
+			~ThreadPool();
+			
+			// The pool owns its threads, and so is not copyable.
+			ThreadPool(const ThreadPool &) = delete;
+			ThreadPool &operator= (const ThreadPool &) = delete;
+			
+			// Function to return the pool shared by the whole renderer.
+			static ThreadPool &GetShared();
+			
+			// Function to return the number of worker threads.
+			int GetNumThreads() const;
+			
+			/* Function to queue a task, returning a future for its result. Tasks should
+				not wait on other tasks queued on the same pool, as every worker might
+				end up waiting. */
+			template <class F>
+			std::future<typename std::invoke_result<F>::type> Submit(F task);
+			
+		private:
+			// Function run by each of the worker threads.
+			void WorkerLoop();
+			
+		private:
+			std::vector<std::thread> m_workers;
+			std::queue<std::function<void()>> m_tasks;
+			std::mutex m_mutex;
+			std::condition_variable m_condition;
+			bool m_stopping = false;
+	};
+	
+	// Function to queue a task.
+	template <class F>
+	std::future<typename std::invoke_result<F>::type> ThreadPool::Submit(F task)
+	{
+		using ResultType = typename std::invoke_result<F>::type;
+		
+		// std::function must be copyable, so the packaged task is held by a shared pointer.
+		auto packagedTask = std::make_shared<std::packaged_task<ResultType()>>(std::move(task));
+		std::future<ResultType> result = packagedTask->get_future();
+		{
+			std::lock_guard<std::mutex> lock (m_mutex);
+			m_tasks.push([packagedTask]() { (*packagedTask)(); });
+		}
+		m_condition.notify_one();
+		
+		return result;
+	}
+}
+
+#endif
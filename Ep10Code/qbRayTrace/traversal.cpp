@@ -0,0 +1,137 @@
+/* ***********************************************************
+	traversal.cpp
+	
+	Functions to generate the order in which the cells of a
+	rectangular grid (tiles of an image, or pixels of a tile)
+	are visited when rendering.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+// traversal.cpp
+
+#include "traversal.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Function to interleave the bits of x and y to form a Morton code.
+static uint64_t MortonCode(uint32_t x, uint32_t y)
+{
+	uint64_t code = 0;
+	for (int bit=0; bit<32; ++bit)
+	{
+		code |= static_cast<uint64_t>((x >> bit) & 1) << (2 * bit);
+		code |= static_cast<uint64_t>((y >> bit) & 1) << ((2 * bit) + 1);
+	}
+	return code;
+}
+
+/* Function to compute the distance along a Hilbert curve covering an n x n
+	grid (n must be a power of two) of the cell at (x,y). */
+static uint64_t HilbertDistance(uint32_t n, uint32_t x, uint32_t y)
+{
+	uint64_t d = 0;
+	for (uint32_t s=n/2; s>0; s/=2)
+	{
+		uint32_t rx = (x & s) > 0;
+		uint32_t ry = (y & s) > 0;
+		d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+		
+		// Rotate the quadrant so that the curve is continuous.
+		if (ry == 0)
+		{
+			if (rx == 1)
+			{
+				x = s - 1 - x;
+				y = s - 1 - y;
+			}
+			std::swap(x, y);
+		}
+	}
+	return d;
+}
+
+// Function to build the order in which the cells of a grid are visited.
+std::vector<int> qbRT::Traversal::BuildOrder(int width, int height, Order order)
+{
+	int numCells = width * height;
+	std::vector<int> cells (numCells);
+	for (int i=0; i<numCells; ++i)
+		cells.at(i) = i;
+		
+	if (order == Order::Scanline)
+		return cells;
+		
+	/* For the other orders, compute a key for each cell and sort by it.
+		Sorting keeps things simple for grids that are not a power of two
+		in size, where the curves have to skip the cells outside the grid. */
+	std::vector<double> keys (numCells);
+	uint32_t n = 1;
+	while ((n < static_cast<uint32_t>(width)) || (n < static_cast<uint32_t>(height)))
+		n *= 2;
+	double cx = (static_cast<double>(width) - 1.0) / 2.0;
+	double cy = (static_cast<double>(height) - 1.0) / 2.0;
+	
+	for (int i=0; i<numCells; ++i)
+	{
+		int x = i % width;
+		int y = i / width;
+		switch (order)
+		{
+			case Order::Morton:
+				keys.at(i) = static_cast<double>(MortonCode(x, y));
+				break;
+				
+			case Order::Hilbert:
+				keys.at(i) = static_cast<double>(HilbertDistance(n, x, y));
+				break;
+				
+			case Order::Spiral:
+			{
+				/* Order by the square ring around the centre first, and then by
+					the angle around the centre within each ring. */
+				double dx = static_cast<double>(x) - cx;
+				double dy = static_cast<double>(y) - cy;
+				double ring = std::max(fabs(dx), fabs(dy));
+				double angle = atan2(dy, dx) + M_PI;
+				keys.at(i) = (floor(ring) * 8.0) + angle;
+				break;
+			}
+			
+			default:
+				keys.at(i) = static_cast<double>(i);
+				break;
+		}
+	}
+	
+	std::stable_sort(cells.begin(), cells.end(), [&keys](int a, int b) {return keys.at(a) < keys.at(b);});
+	return cells;
+}
+
+// Function to return the name of an order.
+std::string qbRT::Traversal::GetName(Order order)
+{
+	switch (order)
+	{
+		case Order::Scanline:
+			return "Scanline";
+		case Order::Morton:
+			return "Morton";
+		case Order::Hilbert:
+			return "Hilbert";
+		case Order::Spiral:
+			return "Spiral";
+	}
+	return "Unknown";
+}
@@ -0,0 +1,48 @@
+/* ***********************************************************
+	traversal.hpp
+	
+	Functions to generate the order in which the cells of a
+	rectangular grid (tiles of an image, or pixels of a tile)
+	are visited when rendering.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+// traversal.hpp
+
+#ifndef TRAVERSAL_H
+#define TRAVERSAL_H
+
+#include <vector>
+#include <string>
+
+namespace qbRT
+{
+	namespace Traversal
+	{
+		/* The available orders. Scanline visits each row left to right, Morton
+			(Z-order) and Hilbert follow space-filling curves so that consecutive
+			cells are close together, and Spiral works outwards from the centre,
+			which is useful for previews. */
+		enum class Order {Scanline, Morton, Hilbert, Spiral};
+		
+		/* Function to build the order in which the cells of a width x height grid
+			are visited. Each entry is the index x + (y * width) of a cell. */
+		std::vector<int> BuildOrder(int width, int height, Order order);
+		
+		// Function to return the name of an order, for reporting.
+		std::string GetName(Order order);
+	}
+}
+
+#endif
@@ -0,0 +1,94 @@
+/* ***********************************************************
+	qbtxconvert.cpp
+	
+	A command line tool to convert a bitmap image into a tiled
+	texture file (.qbtx), holding every mip level already cut into
+	tiles, ready to be memory mapped by the renderer.
+	
+	Usage:
+		qbtxconvert input.bmp output.qbtx [-tile N] [-float] [-srgb]
+		
+		-tile N		The width and height of each tile, in texels (default 64).
+		-float		Store 32 bit float RGBA rather than 8 bit RGBA.
+		-srgb			Treat the input as sRGB encoded and convert it to linear values.
+	
+	This file forms part of the qbRayTrace project as described
+	in the series of videos on the QuantitativeBytes YouTube
+	channel.
+	
+	The whole series may be found on the QuantitativeBytes 
+	YouTube channel at:
+	www.youtube.com/c/QuantitativeBytes
+	
+	GPLv3 LICENSE
+	Copyright (c) 2021 Michael Bennett
+	
+***********************************************************/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "../qbRayTrace/qbTextures/bmpdecoder.hpp"
+#include "../qbRayTrace/qbTextures/tiledformat.hpp"
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		std::cout << "Usage: " << argv[0] << " input.bmp output.qbtx [-tile N] [-float] [-srgb]" << std::endl;
+		return 1;
+	}
+	
+	std::string inputName = argv[1];
+	std::string outputName = argv[2];
+	int tileSize = 64;
+	bool sRGB = false;
+	qbRT::Texture::TexelSource::Format format = qbRT::Texture::TexelSource::Format::RGBA8;
+	
+	// Parse the options.
+	for (int i=3; i<argc; ++i)
+	{
+		std::string option = argv[i];
+		if ((option == "-tile") && (i + 1 < argc))
+		{
+			tileSize = atoi(argv[++i]);
+		}
+		else if (option == "-float")
+		{
+			format = qbRT::Texture::TexelSource::Format::RGBA32F;
+		}
+		else if (option == "-srgb")
+		{
+			sRGB = true;
+		}
+		else
+		{
+			std::cout << "Unknown option " << option << "." << std::endl;
+			return 1;
+		}
+	}
+	
+	// Readers reject tiles larger than 4096 texels, so do not write them.
+	if ((tileSize < 1) || (tileSize > 4096))
+	{
+		std::cout << "The tile size must be from 1 to 4096." << std::endl;
+		return 1;
+	}
+	
+	// Load the image.
+	int xSize, ySize;
+	std::vector<float> rgba;
+	if (!qbRT::Texture::DecodeBMP(inputName, xSize, ySize, rgba, sRGB))
+		return 1;
+		
+	// And write it out.
+	if (!qbRT::Texture::TiledFormat::Write(outputName, xSize, ySize, rgba, format, sRGB, tileSize))
+	{
+		std::cout << "Failed to write " << outputName << "." << std::endl;
+		return 1;
+	}
+	
+	std::cout << "Wrote " << outputName << "." << std::endl;
+	return 0;
+}